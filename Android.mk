@@ -2,5 +2,6 @@ AUDIO_PATH := $(call my-dir)
 
 ifeq ($(INTEL_VA),true)
  include $(AUDIO_PATH)/videodecoder/Android.mk
+ include $(AUDIO_PATH)/videodecoder/test/Android.mk
  include $(AUDIO_PATH)/videoencoder/Android.mk
 endif
@@ -43,6 +43,10 @@ void _mix_aip_initialize (void)
 
 static void mix_aip_init (MixAudioInitParams *self)
 {
+  self->ring_slots = 0;
+  self->ring_slot_size = 0;
+  self->ring_low_watermark = 0;
+  self->ring_high_watermark = 0;
   self->reserved1 = self->reserved2 = self->reserved3 = self->reserved4 = NULL;
 }
 
@@ -119,8 +123,14 @@ gboolean mix_aip_copy(MixParams* target, const MixParams *src)
 {
   if (MIX_IS_AUDIOINITPARAMS(target) && MIX_IS_AUDIOINITPARAMS(src))
   {
-    // TODO perform copy.
-    // 
+    MixAudioInitParams *t = MIX_AUDIOINITPARAMS(target);
+    MixAudioInitParams *s = MIX_AUDIOINITPARAMS(src);
+
+    t->ring_slots = s->ring_slots;
+    t->ring_slot_size = s->ring_slot_size;
+    t->ring_low_watermark = s->ring_low_watermark;
+    t->ring_high_watermark = s->ring_high_watermark;
+
     // Now chainup base class
     // Get the root class from the cached parent_class object. This cached parent_class object has not be overwritten by this current class.
     // Using the cached parent_class object because this_class would have ->copy pointing to this method!
@@ -150,7 +160,13 @@ gboolean mix_aip_equal(MixParams* first, MixParams *second)
 
   if (MIX_IS_AUDIOINITPARAMS(first) && MIX_IS_AUDIOINITPARAMS(second))
   {
-    // TODO: do deep compare
+    MixAudioInitParams *acp1 = MIX_AUDIOINITPARAMS(first);
+    MixAudioInitParams *acp2 = MIX_AUDIOINITPARAMS(second);
+
+    ret = (acp1->ring_slots == acp2->ring_slots) &&
+          (acp1->ring_slot_size == acp2->ring_slot_size) &&
+          (acp1->ring_low_watermark == acp2->ring_low_watermark) &&
+          (acp1->ring_high_watermark == acp2->ring_high_watermark);
 
     if (ret)
     {
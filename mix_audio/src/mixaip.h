@@ -65,6 +65,10 @@ typedef struct _MixAudioInitParamsClass   MixAudioInitParamsClass;
 /**
  * MixAudioInitParams:
  * @parent: Parent.
+ * @ring_slots: Number of output slots queued ahead of the device in #MIX_DECODE_DIRECTRENDER mode. Input is copied into the slots. 0 keeps the blocking, zero-copy write path.
+ * @ring_slot_size: Size in bytes of each output slot.
+ * @ring_low_watermark: Number of filled slots before the device is fed.
+ * @ring_high_watermark: Number of filled slots at which mix_audio_decode() blocks.
  *
  * @MixAudio initialization parameter object.
  */
@@ -73,6 +77,12 @@ struct _MixAudioInitParams
   /*< public >*/
   MixParams parent;
 
+  /*< public >*/
+  guint ring_slots;
+  guint ring_slot_size;
+  guint ring_low_watermark;
+  guint ring_high_watermark;
+
   /*< private >*/
   void* reserved1;
   void* reserved2;
@@ -129,4 +139,38 @@ MixAudioInitParams *mix_aip_ref(MixAudioInitParams *mix);
 
 /* Class Methods */
 
+/**
+ * MIX_AIP_RING_SLOTS:
+ * @obj: #MixAudioInitParams object
+ * 
+ * MixAudioInitParams.ring_slots accessor.
+ * 
+ * Number of output slots the decode path keeps queued ahead of the device. When non-zero, mix_audio_decode() in #MIX_DECODE_DIRECTRENDER mode copies into a free slot and returns instead of blocking on the device.
+*/
+#define MIX_AIP_RING_SLOTS(obj) (MIX_AUDIOINITPARAMS(obj)->ring_slots)
+
+/**
+ * MIX_AIP_RING_SLOT_SIZE:
+ * @obj: #MixAudioInitParams object
+ * 
+ * MixAudioInitParams.ring_slot_size accessor.
+*/
+#define MIX_AIP_RING_SLOT_SIZE(obj) (MIX_AUDIOINITPARAMS(obj)->ring_slot_size)
+
+/**
+ * MIX_AIP_RING_LOW_WATERMARK:
+ * @obj: #MixAudioInitParams object
+ * 
+ * MixAudioInitParams.ring_low_watermark accessor.
+*/
+#define MIX_AIP_RING_LOW_WATERMARK(obj) (MIX_AUDIOINITPARAMS(obj)->ring_low_watermark)
+
+/**
+ * MIX_AIP_RING_HIGH_WATERMARK:
+ * @obj: #MixAudioInitParams object
+ * 
+ * MixAudioInitParams.ring_high_watermark accessor.
+*/
+#define MIX_AIP_RING_HIGH_WATERMARK(obj) (MIX_AUDIOINITPARAMS(obj)->ring_high_watermark)
+
 #endif /* __MIX_AUDIOINITPARAMS_H__ */
@@ -78,6 +78,8 @@
 #include <linux/types.h>
 #include "intel_sst_ioctl.h"
 #include "sst_proxy.h"
+#include "mixaudioring.h"
+#include "mixaudioswdec.h"
 
 #ifdef G_LOG_DOMAIN
 #undef G_LOG_DOMAIN
@@ -140,6 +142,7 @@ static MIX_RESULT mix_audio_FW_INFO(MixAudio *mix);
 static MIX_RESULT mix_audio_SST_SET_PARAMS(MixAudio *mix, MixAudioConfigParams *params);
 static MIX_RESULT mix_audio_SST_writev(MixAudio *mix, const MixIOVec *iovin, gint iovincnt, guint64 *insize);
 static MIX_RESULT mix_audio_SST_STREAM_DECODE(MixAudio *mix, const MixIOVec *iovin, gint iovincnt, guint64 *insize, MixIOVec *iovout, gint iovoutcnt, guint64 *outsize);
+static MIX_RESULT mix_audio_SW_SET_PARAMS(MixAudio *mix, MixAudioConfigParams *params);
 static void mix_audio_debug_dump(MixAudio *mix);
 
 static guint g_log_handler=0;
@@ -180,6 +183,14 @@ static void mix_audio_init (MixAudio *self)
 
   self->bytes_written=0;
 
+  self->ring = NULL;
+  self->ring_slots = 0;
+  self->ring_slot_size = 0;
+  self->ring_low_watermark = 0;
+  self->ring_high_watermark = 0;
+
+  self->swdecode = FALSE;
+  self->swdec = NULL;
 }
 
 void _mix_aip_initialize (void);
@@ -304,6 +315,12 @@ void mix_audio_finalize(GObject *obj)
 
   g_debug("_finalized(). bytes written=%" G_GUINT64_FORMAT, mix->bytes_written);
 
+  mix_audio_ring_free(mix->ring);
+  mix->ring = NULL;
+
+  mix_audio_swdec_free(mix->swdec);
+  mix->swdec = NULL;
+
   g_static_rec_mutex_free (&mix->streamlock);
   g_static_rec_mutex_free (&mix->controllock);
 
@@ -327,7 +344,7 @@ MIX_RESULT mix_audio_initialize_default(MixAudio *mix, MixCodecMode mode, MixAud
 
   if (G_UNLIKELY(!mix)) return MIX_RESULT_NULL_PTR;
 
-  // TODO: parse and process MixAudioInitParams. It is ignored for now.
+  // Only the output ring settings are taken from MixAudioInitParams for now.
 
   // initialized must be called with both thread-lock held, so no other operation is allowed.
   
@@ -380,11 +397,27 @@ MIX_RESULT mix_audio_initialize_default(MixAudio *mix, MixCodecMode mode, MixAud
 #endif
           if (mix->fileDescriptor != -1)
           {
+            if (aip && MIX_IS_AUDIOINITPARAMS(aip))
+            {
+              mix->ring_slots = MIX_AIP_RING_SLOTS(aip);
+              mix->ring_slot_size = MIX_AIP_RING_SLOT_SIZE(aip);
+              mix->ring_low_watermark = MIX_AIP_RING_LOW_WATERMARK(aip);
+              mix->ring_high_watermark = MIX_AIP_RING_HIGH_WATERMARK(aip);
+            }
             mix->codecMode = mode;
             mix->state = MIX_STATE_INITIALIZED;
             ret = MIX_RESULT_SUCCESS;
             g_debug("open() succeeded. fd=%d", mix->fileDescriptor);
           }
+          else if ((mode == MIX_CODING_DECODE) && mix_audio_swdec_is_available())
+          {
+            // No device: decode in software, DECODERETURN only.
+            g_debug("open() failed, falling back to software decode");
+            mix->swdecode = TRUE;
+            mix->codecMode = mode;
+            mix->state = MIX_STATE_INITIALIZED;
+            ret = MIX_RESULT_SUCCESS;
+          }
           else
           {
             ret = MIX_RESULT_LPE_NOTAVAIL;
@@ -536,6 +569,45 @@ MIX_RESULT mix_audio_SST_SET_PARAMS(MixAudio *mix, MixAudioConfigParams *params)
   return ret;
 }
 
+/**
+ * mix_audio_SW_SET_PARAMS:
+ * @mix: #MixAudio object.
+ * @params: Audio parameter used to configure the software decoder.
+ * @returns: #MIX_RESULT indicating configuration result.
+ * 
+ * Software decode counterpart of mix_audio_SST_SET_PARAMS(). Selects a registered
+ * backend for @params and replaces any previous one.
+ */
+static MIX_RESULT mix_audio_SW_SET_PARAMS(MixAudio *mix, MixAudioConfigParams *params)
+{
+  MixAudioSwDecoder *dec = NULL;
+
+  if (G_UNLIKELY(!mix)) return MIX_RESULT_NULL_PTR;
+
+  if (!MIX_IS_AUDIOCONFIGPARAMS(params)) return MIX_RESULT_INVALID_PARAM;
+
+  // There is no device to render to.
+  if (MIX_ACP_DECODEMODE(params) != MIX_DECODE_DECODERETURN) return MIX_RESULT_WRONGMODE;
+
+  mix_acp_print_params(params);
+
+  dec = mix_audio_swdec_new(params);
+  if (!dec) return MIX_RESULT_CODEC_NOTSUPPORTED;
+
+  mix_audio_swdec_free(mix->swdec);
+  mix->swdec = dec;
+  mix->streamState = MIX_STREAM_STOPPED;
+
+  if (MIX_IS_AUDIOCONFIGPARAMS(mix->audioconfigparams))
+  {
+    mix_acp_unref(mix->audioconfigparams);
+    mix->audioconfigparams=NULL;
+  }
+  mix->audioconfigparams = MIX_AUDIOCONFIGPARAMS(mix_params_dup(MIX_PARAMS(params)));
+
+  return MIX_RESULT_SUCCESS;
+}
+
 MIX_RESULT mix_audio_get_state_default(MixAudio *mix, MixState *state)
 {
   MIX_RESULT ret = MIX_RESULT_SUCCESS;
@@ -559,8 +631,15 @@ MIX_RESULT mix_audio_decode_default(MixAudio *mix, const MixIOVec *iovin, gint i
 
   if (mix->state != MIX_STATE_CONFIGURED) _UNLOCK_RETURN(&mix->streamlock, MIX_RESULT_WRONG_STATE);
 
-  if (MIX_ACP_DECODEMODE(mix->audioconfigparams) == MIX_DECODE_DIRECTRENDER)
-    ret = mix_audio_SST_writev(mix, iovin, iovincnt, insize);
+  if (mix->swdec)
+    ret = mix_audio_swdec_decode(mix->swdec, iovin, iovincnt, insize, iovout, iovoutcnt, outsize);
+  else if (MIX_ACP_DECODEMODE(mix->audioconfigparams) == MIX_DECODE_DIRECTRENDER)
+  {
+    if (mix->ring)
+      ret = mix_audio_ring_enqueue(mix->ring, iovin, iovincnt, insize);
+    else
+      ret = mix_audio_SST_writev(mix, iovin, iovincnt, insize);
+  }
   else
     ret = mix_audio_SST_STREAM_DECODE(mix, iovin, iovincnt, insize, iovout, iovoutcnt, outsize);
 
@@ -591,6 +670,14 @@ MIX_RESULT mix_audio_deinitialize_default(MixAudio *mix)
     ret = MIX_RESULT_WRONG_STATE;
   else
   {
+    // Writer thread must be gone before the fd is closed.
+    mix_audio_ring_free(mix->ring);
+    mix->ring = NULL;
+
+    mix_audio_swdec_free(mix->swdec);
+    mix->swdec = NULL;
+    mix->swdecode = FALSE;
+
     if (mix->fileDescriptor != -1)
     {
       g_debug("Closing fd=%d\n", mix->fileDescriptor);
@@ -627,13 +714,24 @@ MIX_RESULT mix_audio_stop_drop_default(MixAudio *mix)
 //  else
   {
     int retVal = 0;
+    if (mix->swdec)
+    {
+      // No device behind a software decoder; just forget buffered state.
+      mix_audio_swdec_reset(mix->swdec);
+    }
+    else
+    {
 #ifdef LPESTUB
-    // Not calling ioctl.
+      // Not calling ioctl.
 #else
-    g_debug("Calling SNDRV_SST_STREAM_DROP. fd=%d", mix->fileDescriptor);
-    retVal = ioctl(mix->fileDescriptor, SNDRV_SST_STREAM_DROP);
-    g_debug("_DROP returned %d", retVal);
+      g_debug("Calling SNDRV_SST_STREAM_DROP. fd=%d", mix->fileDescriptor);
+      retVal = ioctl(mix->fileDescriptor, SNDRV_SST_STREAM_DROP);
+      g_debug("_DROP returned %d", retVal);
 #endif
+    }
+
+    // DROP unblocked any pending ring write; discard what is still queued.
+    if (mix->ring) mix_audio_ring_drop(mix->ring);
 
     if (!retVal)
       {
@@ -686,6 +784,10 @@ MIX_RESULT mix_audio_stop_drain_default(MixAudio *mix)
 
     if (doDrain)
     {
+      // Push everything still queued in the ring to the device first.
+      if (mix->ring && !MIX_SUCCEEDED(mix_audio_ring_drain(mix->ring)))
+        retVal = -1;
+
       // Calling the blocking DRAIN without holding the controllock
       // TODO: remove this ifdef when API becomes available.
   #ifdef LPESTUB
@@ -694,9 +796,12 @@ MIX_RESULT mix_audio_stop_drain_default(MixAudio *mix)
       //g_debug("Calling SNDRV_SST_STREAM_DRAIN. fd=0x%08x", mix->fileDescriptor);
       //retVal = ioctl(mix->fileDescriptor, SNDRV_SST_STREAM_DRAIN);
 //      g_warning("Calling SNDRV_SST_STREAM_DROP instead of SNDRV_SST_STREAM_DRAIN here since DRAIN is not yet integrated. There may be data loss. fd=%d", mix->fileDescriptor);
-      g_debug("Calling SNDRV_SST_STREAM_DRAIN fd=%d", mix->fileDescriptor);
-      retVal = ioctl(mix->fileDescriptor, SNDRV_SST_STREAM_DRAIN);
-      g_debug("_DRAIN returned %d", retVal);
+      if (!retVal)
+      {
+        g_debug("Calling SNDRV_SST_STREAM_DRAIN fd=%d", mix->fileDescriptor);
+        retVal = ioctl(mix->fileDescriptor, SNDRV_SST_STREAM_DRAIN);
+        g_debug("_DRAIN returned %d", retVal);
+      }
   #endif
 
       if (retVal)
@@ -858,16 +963,37 @@ MIX_RESULT mix_audio_configure_default(MixAudio *mix, MixAudioConfigParams *audi
   }
   // now configure stream.
 
-  ret = mix_audio_am_unregister(mix, audioconfigparams);
-
-  if (MIX_SUCCEEDED(ret))
+  if (mix->swdecode)
   {
-    ret = mix_audio_SST_SET_PARAMS(mix, audioconfigparams);
+    ret = mix_audio_SW_SET_PARAMS(mix, audioconfigparams);
   }
+  else
+  {
+    ret = mix_audio_am_unregister(mix, audioconfigparams);
 
-  if (MIX_SUCCEEDED(ret))
+    if (MIX_SUCCEEDED(ret))
+    {
+      ret = mix_audio_SST_SET_PARAMS(mix, audioconfigparams);
+    }
+
+    if (MIX_SUCCEEDED(ret))
+    {
+      ret = mix_audio_am_register(mix, audioconfigparams);
+    }
+  }
+
+  // The output ring only applies to DIRECTRENDER; rebuild it for the new stream.
+  mix_audio_ring_free(mix->ring);
+  mix->ring = NULL;
+  if (MIX_SUCCEEDED(ret) && (mix->ring_slots > 0) &&
+      (MIX_ACP_DECODEMODE(audioconfigparams) == MIX_DECODE_DIRECTRENDER))
   {
-    ret = mix_audio_am_register(mix, audioconfigparams);
+    mix->ring = mix_audio_ring_new(mix->fileDescriptor, mix->ring_slots, mix->ring_slot_size,
+                                   mix->ring_low_watermark, mix->ring_high_watermark);
+    if (!mix->ring)
+    {
+      g_warning("Cannot allocate output ring, falling back to blocking writes");
+    }
   }
 
   if (MIX_SUCCEEDED(ret))
@@ -912,7 +1038,8 @@ MIX_RESULT mix_audio_get_timestamp_default(MixAudio *mix, guint64 *msecs)
       {
         // use bytes_written and bitrate
         // to get times in msec.
-        ts = mix->bytes_written * 8000 / MIX_ACP_BITRATE(mix->audioconfigparams);
+        guint64 written = mix->ring ? mix_audio_ring_get_bytes_written(mix->ring) : mix->bytes_written;
+        ts = written * 8000 / MIX_ACP_BITRATE(mix->audioconfigparams);
       }
       else if (mix->ts_last)
       {
@@ -210,6 +210,17 @@ struct _MixAudio
   guint64 ts_last;
   guint64 ts_elapsed;
   guint64 bytes_written;
+
+  // DIRECTRENDER output ring, see mixaudioring.h
+  struct _MixAudioRing *ring;
+  guint ring_slots;
+  guint ring_slot_size;
+  guint ring_low_watermark;
+  guint ring_high_watermark;
+
+  // Software decode fallback when the LPE device is absent, see mixaudioswdec.h
+  gboolean swdecode;
+  struct _MixAudioSwDecoder *swdec;
 };
 
 /**
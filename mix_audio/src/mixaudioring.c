@@ -0,0 +1,350 @@
+/* 
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved. 
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <string.h>
+
+#include <glib.h>
+#include "mixaudioring.h"
+
+#ifdef G_LOG_DOMAIN
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN    ((gchar*)"mixaudio")
+#endif
+
+// Longest time the writer sleeps on a full non-blocking device before it
+// checks again for a drop or shutdown.
+#define MIX_AUDIO_RING_POLL_MS 20
+
+struct _MixAudioRing
+{
+  int fd;
+  guint nslots;
+  guint slot_size;
+  guint low;
+  guint high;
+
+  guchar *storage;     // nslots * slot_size bytes, allocated once
+  gsize *fill;         // bytes committed in each slot
+  struct iovec *iov;   // persistent writev array, nslots entries
+
+  guint head;          // next slot to hand to the device
+  gsize head_offset;   // bytes of head slot already written
+  guint count;         // committed slots not yet written
+
+  GMutex *lock;
+  GCond *not_full;     // producer waits here at high watermark
+  GCond *ready;        // writer waits here for data
+  GCond *idle;         // drain/drop wait here for the writer
+
+  GThread *thread;
+  gboolean running;
+  gboolean draining;
+  gboolean writing;
+  gboolean dropping;   // drop waits for the writer, no new writes or copies
+  guint generation;    // bumped by drop to invalidate an in-flight write
+  gint error;          // errno of the last failed write, 0 if none
+  guint64 bytes_written;
+};
+
+static gpointer mix_audio_ring_writer(gpointer data)
+{
+  MixAudioRing *ring = (MixAudioRing*)data;
+
+  g_mutex_lock(ring->lock);
+
+  while (ring->running)
+  {
+    // Wait until we are primed to the low watermark, unless draining.
+    if (ring->dropping || (ring->count == 0) || ((ring->count < ring->low) && !ring->draining))
+    {
+      g_cond_wait(ring->ready, ring->lock);
+      continue;
+    }
+
+    // Gather the contiguous run of committed slots starting at head.
+    guint n = 0;
+    guint slot = ring->head;
+    gsize total_bytes = 0;
+    while ((n < ring->count) && (slot < ring->nslots))
+    {
+      gsize offset = (n == 0) ? ring->head_offset : 0;
+      ring->iov[n].iov_base = ring->storage + (gsize)slot * ring->slot_size + offset;
+      ring->iov[n].iov_len = ring->fill[slot] - offset;
+      total_bytes += ring->iov[n].iov_len;
+      n++;
+      slot++;
+    }
+
+    guint generation = ring->generation;
+    ring->writing = TRUE;
+    g_mutex_unlock(ring->lock);
+
+    ssize_t written = writev(ring->fd, ring->iov, n);
+    int err = errno;
+
+    g_mutex_lock(ring->lock);
+    ring->writing = FALSE;
+
+    if (generation != ring->generation)
+    {
+      // Ring was dropped while we were writing. Nothing to account for.
+      g_cond_broadcast(ring->idle);
+      continue;
+    }
+
+    if (written < 0)
+    {
+      if (err == EINTR) continue;
+      if (err == EAGAIN)
+      {
+        // Non-blocking device is full. Sleep until it can take data
+        // instead of retrying writev() in a loop.
+        struct pollfd pfd;
+        pfd.fd = ring->fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        g_mutex_unlock(ring->lock);
+        poll(&pfd, 1, MIX_AUDIO_RING_POLL_MS);
+        g_mutex_lock(ring->lock);
+        continue;
+      }
+      g_debug("ring writev() failed. Error:0x%08x", err);
+      ring->error = err;
+      g_cond_broadcast(ring->not_full);
+      g_cond_broadcast(ring->idle);
+      // Wait for a drop or shutdown to clear the error.
+      while (ring->running && ring->error)
+        g_cond_wait(ring->ready, ring->lock);
+      continue;
+    }
+
+    ring->bytes_written += written;
+    if (written != total_bytes)
+    {
+      g_debug("ring writev() wrote only %" G_GSSIZE_FORMAT " out of %" G_GSIZE_FORMAT, (gssize)written, total_bytes);
+    }
+
+    // Retire fully written slots, keep the offset into a partial one.
+    gsize left = (gsize)written + ring->head_offset;
+    while ((ring->count > 0) && (left >= ring->fill[ring->head]))
+    {
+      left -= ring->fill[ring->head];
+      ring->fill[ring->head] = 0;
+      ring->head = (ring->head + 1) % ring->nslots;
+      ring->count--;
+    }
+    ring->head_offset = left;
+
+    if (ring->count < ring->high) g_cond_broadcast(ring->not_full);
+    if (ring->count == 0) g_cond_broadcast(ring->idle);
+  }
+
+  g_mutex_unlock(ring->lock);
+
+  return NULL;
+}
+
+MixAudioRing *mix_audio_ring_new(int fd, guint slots, guint slot_size, guint low_watermark, guint high_watermark)
+{
+  MixAudioRing *ring = NULL;
+  GError *err = NULL;
+
+  if ((fd == -1) || (slots == 0) || (slot_size == 0)) return NULL;
+
+  // Keep the watermarks sane: 1 <= low <= high <= slots.
+  if ((high_watermark == 0) || (high_watermark > slots)) high_watermark = slots;
+  if (low_watermark == 0) low_watermark = 1;
+  if (low_watermark > high_watermark) low_watermark = high_watermark;
+
+  ring = g_new0(MixAudioRing, 1);
+  ring->fd = fd;
+  ring->nslots = slots;
+  ring->slot_size = slot_size;
+  ring->low = low_watermark;
+  ring->high = high_watermark;
+
+  ring->storage = g_try_malloc((gsize)slots * slot_size);
+  ring->fill = g_new0(gsize, slots);
+  ring->iov = g_new0(struct iovec, slots);
+  if (!ring->storage)
+  {
+    mix_audio_ring_free(ring);
+    return NULL;
+  }
+
+  ring->lock = g_mutex_new();
+  ring->not_full = g_cond_new();
+  ring->ready = g_cond_new();
+  ring->idle = g_cond_new();
+
+  ring->running = TRUE;
+  ring->thread = g_thread_create(mix_audio_ring_writer, ring, TRUE, &err);
+  if (!ring->thread)
+  {
+    g_warning("Cannot create ring writer thread: %s", err ? err->message : "unknown");
+    if (err) g_error_free(err);
+    ring->running = FALSE;
+    mix_audio_ring_free(ring);
+    return NULL;
+  }
+
+  g_debug("Audio ring created. slots=%u size=%u low=%u high=%u", slots, slot_size, ring->low, ring->high);
+
+  return ring;
+}
+
+void mix_audio_ring_free(MixAudioRing *ring)
+{
+  if (!ring) return;
+
+  if (ring->thread)
+  {
+    g_mutex_lock(ring->lock);
+    ring->running = FALSE;
+    g_cond_broadcast(ring->ready);
+    g_mutex_unlock(ring->lock);
+    g_thread_join(ring->thread);
+    ring->thread = NULL;
+  }
+
+  if (ring->idle) g_cond_free(ring->idle);
+  if (ring->ready) g_cond_free(ring->ready);
+  if (ring->not_full) g_cond_free(ring->not_full);
+  if (ring->lock) g_mutex_free(ring->lock);
+
+  g_free(ring->iov);
+  g_free(ring->fill);
+  g_free(ring->storage);
+  g_free(ring);
+}
+
+MIX_RESULT mix_audio_ring_enqueue(MixAudioRing *ring, const MixIOVec *iovin, gint iovincnt, guint64 *insize)
+{
+  MIX_RESULT ret = MIX_RESULT_SUCCESS;
+  guint64 copied = 0;
+  gint i = 0;
+
+  if (G_UNLIKELY(!ring)) return MIX_RESULT_NULL_PTR;
+
+  g_mutex_lock(ring->lock);
+
+  for (i = 0; (i < iovincnt) && MIX_SUCCEEDED(ret); i++)
+  {
+    const guchar *src = iovin[i].data;
+    gsize remain = (iovin[i].size > 0) ? (gsize)iovin[i].size : 0;
+
+    while (remain > 0)
+    {
+      while (ring->dropping || ((ring->count >= ring->high) && !ring->error))
+        g_cond_wait(ring->not_full, ring->lock);
+
+      if (ring->error)
+      {
+        errno = ring->error;
+        ret = MIX_RESULT_SYSTEM_ERRNO;
+        break;
+      }
+
+      // Each input element is spread over as many slots as needed; only
+      // its last slot may be short.
+      guint tail = (ring->head + ring->count) % ring->nslots;
+      gsize n = MIN(remain, (gsize)ring->slot_size);
+      memcpy(ring->storage + (gsize)tail * ring->slot_size, src, n);
+      ring->fill[tail] = n;
+      ring->count++;
+
+      src += n;
+      remain -= n;
+      copied += n;
+
+      if (ring->count >= ring->low) g_cond_signal(ring->ready);
+    }
+  }
+
+  g_mutex_unlock(ring->lock);
+
+  if (insize) *insize = copied;
+
+  return ret;
+}
+
+MIX_RESULT mix_audio_ring_drain(MixAudioRing *ring)
+{
+  MIX_RESULT ret = MIX_RESULT_SUCCESS;
+
+  if (G_UNLIKELY(!ring)) return MIX_RESULT_NULL_PTR;
+
+  g_mutex_lock(ring->lock);
+
+  // Flush whatever is below the low watermark too.
+  ring->draining = TRUE;
+  g_cond_signal(ring->ready);
+
+  while (((ring->count > 0) || ring->writing) && !ring->error)
+    g_cond_wait(ring->idle, ring->lock);
+
+  if (ring->error)
+  {
+    errno = ring->error;
+    ret = MIX_RESULT_SYSTEM_ERRNO;
+  }
+
+  ring->draining = FALSE;
+
+  g_mutex_unlock(ring->lock);
+
+  return ret;
+}
+
+void mix_audio_ring_drop(MixAudioRing *ring)
+{
+  if (G_UNLIKELY(!ring)) return;
+
+  g_mutex_lock(ring->lock);
+
+  // The caller has already issued the device DROP which unblocks a pending
+  // write. Wait for it before the slots are reset, so that neither the
+  // writer nor a producer woken meanwhile touches slot memory that writev()
+  // may still be reading.
+  ring->dropping = TRUE;
+  ring->generation++;
+  while (ring->writing)
+    g_cond_wait(ring->idle, ring->lock);
+
+  ring->head = 0;
+  ring->head_offset = 0;
+  ring->count = 0;
+  ring->error = 0;
+  memset(ring->fill, 0, sizeof(gsize) * ring->nslots);
+  ring->dropping = FALSE;
+
+  // Wake a blocked producer, a pending drain and an erroring writer.
+  g_cond_broadcast(ring->not_full);
+  g_cond_broadcast(ring->ready);
+  g_cond_broadcast(ring->idle);
+
+  g_mutex_unlock(ring->lock);
+}
+
+guint64 mix_audio_ring_get_bytes_written(MixAudioRing *ring)
+{
+  guint64 ret = 0;
+
+  if (G_UNLIKELY(!ring)) return 0;
+
+  g_mutex_lock(ring->lock);
+  ret = ring->bytes_written;
+  g_mutex_unlock(ring->lock);
+
+  return ret;
+}
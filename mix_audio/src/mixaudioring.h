@@ -0,0 +1,42 @@
+/* 
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved. 
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+
+#ifndef __MIX_AUDIO_RING_H__
+#define __MIX_AUDIO_RING_H__
+
+#include "mixaudio.h"
+
+/*
+ * Ring of pre-allocated output slots drained to the device (or the LPESTUB
+ * sink) by a dedicated writer thread. Used by DIRECTRENDER decode so that
+ * mix_audio_decode() only has to copy into a free slot instead of blocking
+ * in writev().
+ *
+ * Input is copied into the slots. mix_audio_decode() returns before the
+ * device has taken the data and the caller may reuse its buffers right
+ * away, so they cannot be handed to the writer by reference. The copy is
+ * the price of not blocking; the synchronous writev() path (ring_slots 0)
+ * stays zero-copy.
+ *
+ * The writer does not start until low_watermark slots are filled (or a
+ * drain is requested), and the producer blocks only once high_watermark
+ * slots are waiting.
+ */
+typedef struct _MixAudioRing MixAudioRing;
+
+MixAudioRing *mix_audio_ring_new(int fd, guint slots, guint slot_size, guint low_watermark, guint high_watermark);
+void mix_audio_ring_free(MixAudioRing *ring);
+
+MIX_RESULT mix_audio_ring_enqueue(MixAudioRing *ring, const MixIOVec *iovin, gint iovincnt, guint64 *insize);
+MIX_RESULT mix_audio_ring_drain(MixAudioRing *ring);
+void mix_audio_ring_drop(MixAudioRing *ring);
+
+guint64 mix_audio_ring_get_bytes_written(MixAudioRing *ring);
+
+#endif
@@ -0,0 +1,428 @@
+/* 
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved. 
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+
+#include <string.h>
+#include <glib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "mixaudioswdec.h"
+
+struct _MixAudioSwDecoder
+{
+  const MixAudioSwDecoderOps *ops;
+  gpointer ctx;
+  MixACPBPSType bps;
+  MixACPOpAlign op_align;
+
+  // Converted PCM that did not fit in the caller's output buffers.
+  guchar *pending;
+  guint64 pending_alloc;
+  guint64 pending_size;
+  guint64 pending_offset;
+};
+
+static GStaticMutex swdec_lock = G_STATIC_MUTEX_INIT;
+static GSList *swdec_backends = NULL;
+
+MIX_RESULT mix_audio_swdec_register(const MixAudioSwDecoderOps *ops)
+{
+  if (!ops || !ops->name || !ops->probe || !ops->open || !ops->decode || !ops->close)
+    return MIX_RESULT_NULL_PTR;
+
+  g_static_mutex_lock(&swdec_lock);
+  swdec_backends = g_slist_prepend(swdec_backends, (gpointer)ops);
+  g_static_mutex_unlock(&swdec_lock);
+
+  g_debug("Registered software decoder \"%s\"", ops->name);
+
+  return MIX_RESULT_SUCCESS;
+}
+
+gboolean mix_audio_swdec_is_available(void)
+{
+  gboolean avail = FALSE;
+
+  g_static_mutex_lock(&swdec_lock);
+  avail = (swdec_backends != NULL);
+  g_static_mutex_unlock(&swdec_lock);
+
+  return avail;
+}
+
+guint mix_audio_pcm_frame_size(guint nchannels, MixACPBPSType bps)
+{
+  // 24-bit samples are carried in 32-bit containers, as the SST firmware does.
+  return nchannels * ((bps == MIX_ACP_BPS_24) ? 4 : 2);
+}
+
+static guint64 mix_audio_pcm_interleave_16(const gint32 * const *planes, guint nchannels, guint nsamples, gint16 *out)
+{
+  guint i = 0, c = 0;
+
+#ifdef __SSE2__
+  if (nchannels == 2)
+  {
+    const gint32 *l = planes[0];
+    const gint32 *r = planes[1];
+    for (; i + 4 <= nsamples; i += 4)
+    {
+      __m128i vl = _mm_loadu_si128((const __m128i*)(l + i));
+      __m128i vr = _mm_loadu_si128((const __m128i*)(r + i));
+      __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi32(vl, vr), 16);
+      __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi32(vl, vr), 16);
+      _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_packs_epi32(lo, hi));
+    }
+  }
+  else if (nchannels == 1)
+  {
+    const gint32 *m = planes[0];
+    for (; i + 8 <= nsamples; i += 8)
+    {
+      __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(m + i)), 16);
+      __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(m + i + 4)), 16);
+      _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+  }
+#endif
+
+  // The caller's output need not be aligned.
+  for (; i < nsamples; i++)
+  {
+    for (c = 0; c < nchannels; c++)
+    {
+      gint16 s = (gint16)(planes[c][i] >> 16);
+      memcpy(out + i * nchannels + c, &s, sizeof(s));
+    }
+  }
+
+  return (guint64)nsamples * nchannels * sizeof(gint16);
+}
+
+static guint64 mix_audio_pcm_interleave_24(const gint32 * const *planes, guint nchannels, guint nsamples, gboolean lsb, gint32 *out)
+{
+  guint i = 0, c = 0;
+
+#ifdef __SSE2__
+  if (nchannels == 2)
+  {
+    const gint32 *l = planes[0];
+    const gint32 *r = planes[1];
+    const __m128i mask = _mm_set1_epi32((gint32)0xFFFFFF00);
+    for (; i + 4 <= nsamples; i += 4)
+    {
+      __m128i vl = _mm_loadu_si128((const __m128i*)(l + i));
+      __m128i vr = _mm_loadu_si128((const __m128i*)(r + i));
+      __m128i lo = _mm_unpacklo_epi32(vl, vr);
+      __m128i hi = _mm_unpackhi_epi32(vl, vr);
+      if (lsb)
+      {
+        lo = _mm_srai_epi32(lo, 8);
+        hi = _mm_srai_epi32(hi, 8);
+      }
+      else
+      {
+        lo = _mm_and_si128(lo, mask);
+        hi = _mm_and_si128(hi, mask);
+      }
+      _mm_storeu_si128((__m128i*)(out + 2 * i), lo);
+      _mm_storeu_si128((__m128i*)(out + 2 * i + 4), hi);
+    }
+  }
+#endif
+
+  for (; i < nsamples; i++)
+  {
+    for (c = 0; c < nchannels; c++)
+    {
+      gint32 s = planes[c][i];
+      s = lsb ? (s >> 8) : (gint32)((guint32)s & 0xFFFFFF00);
+      memcpy(out + i * nchannels + c, &s, sizeof(s));
+    }
+  }
+
+  return (guint64)nsamples * nchannels * sizeof(gint32);
+}
+
+guint64 mix_audio_pcm_interleave(const gint32 * const *planes, guint nchannels, guint nsamples, MixACPBPSType bps, MixACPOpAlign op_align, guchar *out)
+{
+  if (!planes || !out || !nchannels) return 0;
+
+  if (bps == MIX_ACP_BPS_24)
+    return mix_audio_pcm_interleave_24(planes, nchannels, nsamples, op_align == MIX_ACP_OUTPUT_ALIGN_LSB, (gint32*)out);
+
+  return mix_audio_pcm_interleave_16(planes, nchannels, nsamples, (gint16*)out);
+}
+
+MixAudioSwDecoder *mix_audio_swdec_new(MixAudioConfigParams *acp)
+{
+  const MixAudioSwDecoderOps *ops = NULL;
+  MixAudioSwDecoder *dec = NULL;
+  GSList *l = NULL;
+
+  if (!MIX_IS_AUDIOCONFIGPARAMS(acp)) return NULL;
+
+  g_static_mutex_lock(&swdec_lock);
+  for (l = swdec_backends; l; l = l->next)
+  {
+    const MixAudioSwDecoderOps *cand = (const MixAudioSwDecoderOps*)l->data;
+    if (cand->probe(acp))
+    {
+      ops = cand;
+      break;
+    }
+  }
+  g_static_mutex_unlock(&swdec_lock);
+
+  if (!ops)
+  {
+    g_debug("No software decoder accepts this configuration");
+    return NULL;
+  }
+
+  dec = g_new0(MixAudioSwDecoder, 1);
+  dec->ops = ops;
+  dec->ctx = ops->open(acp);
+  if (!dec->ctx)
+  {
+    g_warning("Software decoder \"%s\" failed to open", ops->name);
+    g_free(dec);
+    return NULL;
+  }
+
+  // Same defaulting as the SST parameter conversion: 16-bit output is always 16-bit aligned.
+  dec->bps = mix_acp_get_bps(acp);
+  if (dec->bps != MIX_ACP_BPS_24) dec->bps = MIX_ACP_BPS_16;
+  dec->op_align = mix_acp_get_op_align(acp);
+  if (dec->bps == MIX_ACP_BPS_16)
+    dec->op_align = MIX_ACP_OUTPUT_ALIGN_16;
+  else if (dec->op_align != MIX_ACP_OUTPUT_ALIGN_LSB)
+    dec->op_align = MIX_ACP_OUTPUT_ALIGN_MSB;
+
+  g_debug("Using software decoder \"%s\" bps=%d align=%d", ops->name, dec->bps, dec->op_align);
+
+  return dec;
+}
+
+void mix_audio_swdec_free(MixAudioSwDecoder *dec)
+{
+  if (!dec) return;
+
+  dec->ops->close(dec->ctx);
+  g_free(dec->pending);
+  g_free(dec);
+}
+
+void mix_audio_swdec_reset(MixAudioSwDecoder *dec)
+{
+  if (!dec) return;
+
+  if (dec->ops->reset) dec->ops->reset(dec->ctx);
+  dec->pending_size = 0;
+  dec->pending_offset = 0;
+}
+
+/* Copy as much pending PCM as fits into the output vector, starting at (*idx, *off). */
+static guint64 mix_audio_swdec_flush_pending(MixAudioSwDecoder *dec, MixIOVec *iovout, gint iovoutcnt, gint *idx, guint64 *off)
+{
+  guint64 copied = 0;
+
+  while ((dec->pending_offset < dec->pending_size) && (*idx < iovoutcnt))
+  {
+    guint64 room = (guint64)iovout[*idx].size - *off;
+    guint64 n = MIN(room, dec->pending_size - dec->pending_offset);
+
+    memcpy(iovout[*idx].data + *off, dec->pending + dec->pending_offset, n);
+    dec->pending_offset += n;
+    *off += n;
+    copied += n;
+
+    if (*off >= (guint64)iovout[*idx].size)
+    {
+      (*idx)++;
+      *off = 0;
+    }
+  }
+
+  if (dec->pending_offset >= dec->pending_size)
+  {
+    dec->pending_size = 0;
+    dec->pending_offset = 0;
+  }
+
+  return copied;
+}
+
+MIX_RESULT mix_audio_swdec_decode(MixAudioSwDecoder *dec, const MixIOVec *iovin, gint iovincnt, guint64 *insize, MixIOVec *iovout, gint iovoutcnt, guint64 *outsize)
+{
+  MIX_RESULT ret = MIX_RESULT_SUCCESS;
+  guint64 consumed = 0;
+  guint64 produced = 0;
+  guint64 out_off = 0;
+  gint out_idx = 0;
+  gint i = 0;
+
+  if (!dec) return MIX_RESULT_NULL_PTR;
+
+  if ((iovout == NULL) || (iovoutcnt <= 0)) return MIX_RESULT_NULL_PTR;
+
+  // Leftover from the previous call goes out first to keep the PCM in order.
+  produced += mix_audio_swdec_flush_pending(dec, iovout, iovoutcnt, &out_idx, &out_off);
+
+  for (i = 0; (i < iovincnt) && (dec->pending_size == 0); i++)
+  {
+    guint64 in_off = 0;
+
+    while ((in_off < (guint64)iovin[i].size) && (dec->pending_size == 0) && (out_idx < iovoutcnt))
+    {
+      const gint32 * const *planes = NULL;
+      guint nchannels = 0;
+      guint nsamples = 0;
+      guint64 used = 0;
+
+      ret = dec->ops->decode(dec->ctx, iovin[i].data + in_off, (guint64)iovin[i].size - in_off, &used, &planes, &nchannels, &nsamples);
+      if (!MIX_SUCCEEDED(ret))
+      {
+        g_debug("Software decoder \"%s\" failed: 0x%08x", dec->ops->name, ret);
+        goto done;
+      }
+
+      in_off += used;
+      consumed += used;
+
+      if ((nsamples > 0) && planes && nchannels)
+      {
+        guint64 bytes = (guint64)mix_audio_pcm_frame_size(nchannels, dec->bps) * nsamples;
+
+        if ((guint64)iovout[out_idx].size - out_off >= bytes)
+        {
+          // Common case: convert straight into the caller's buffer.
+          mix_audio_pcm_interleave(planes, nchannels, nsamples, dec->bps, dec->op_align, iovout[out_idx].data + out_off);
+          out_off += bytes;
+          produced += bytes;
+          if (out_off >= (guint64)iovout[out_idx].size)
+          {
+            out_idx++;
+            out_off = 0;
+          }
+        }
+        else
+        {
+          if (bytes > dec->pending_alloc)
+          {
+            g_free(dec->pending);
+            dec->pending = g_try_malloc(bytes);
+            dec->pending_alloc = dec->pending ? bytes : 0;
+            if (!dec->pending)
+            {
+              ret = MIX_RESULT_NO_MEMORY;
+              goto done;
+            }
+          }
+          dec->pending_size = mix_audio_pcm_interleave(planes, nchannels, nsamples, dec->bps, dec->op_align, dec->pending);
+          dec->pending_offset = 0;
+          produced += mix_audio_swdec_flush_pending(dec, iovout, iovoutcnt, &out_idx, &out_off);
+        }
+      }
+      else if (used == 0)
+      {
+        // Incomplete frame; caller resubmits the remainder with more data.
+        goto done;
+      }
+    }
+
+    if (in_off < (guint64)iovin[i].size) break;
+  }
+
+done:
+  if (insize) *insize = consumed;
+  if (outsize) *outsize = produced;
+
+  return ret;
+}
+
+/*
+ * Reference backend: interleaved native endian 16-bit PCM in, planar 32-bit out.
+ * Decodes nothing, but gives the software path something to run against when
+ * there is neither an LPE device nor an MP3/AAC backend.
+ */
+#define MIX_AUDIO_SWDEC_PCM_MAX_CHANNELS 8
+#define MIX_AUDIO_SWDEC_PCM_FRAMES 1152
+
+typedef struct
+{
+  guint nchannels;
+  gint32 *planes[MIX_AUDIO_SWDEC_PCM_MAX_CHANNELS];
+} MixAudioSwDecPcm;
+
+static gboolean mix_audio_swdec_pcm_probe(MixAudioConfigParams *acp)
+{
+  // Only the plain base class; the codec specific subclasses carry compressed streams.
+  if (G_TYPE_FROM_INSTANCE(acp) != MIX_TYPE_AUDIOCONFIGPARAMS) return FALSE;
+
+  return (MIX_ACP_NUM_CHANNELS(acp) > 0) && (MIX_ACP_NUM_CHANNELS(acp) <= MIX_AUDIO_SWDEC_PCM_MAX_CHANNELS);
+}
+
+static gpointer mix_audio_swdec_pcm_open(MixAudioConfigParams *acp)
+{
+  MixAudioSwDecPcm *pcm = g_new0(MixAudioSwDecPcm, 1);
+  guint c = 0;
+
+  pcm->nchannels = MIX_ACP_NUM_CHANNELS(acp);
+  for (c = 0; c < pcm->nchannels; c++)
+    pcm->planes[c] = g_new(gint32, MIX_AUDIO_SWDEC_PCM_FRAMES);
+
+  return pcm;
+}
+
+static MIX_RESULT mix_audio_swdec_pcm_decode(gpointer ctx, const guchar *in, guint64 insize, guint64 *consumed, const gint32 * const **planes, guint *nchannels, guint *nsamples)
+{
+  MixAudioSwDecPcm *pcm = (MixAudioSwDecPcm*)ctx;
+  guint frame = pcm->nchannels * sizeof(gint16);
+  guint n = (guint)MIN(insize / frame, MIX_AUDIO_SWDEC_PCM_FRAMES);
+  guint i = 0, c = 0;
+
+  for (i = 0; i < n; i++)
+  {
+    for (c = 0; c < pcm->nchannels; c++)
+    {
+      gint16 s = 0;
+      memcpy(&s, in + (i * pcm->nchannels + c) * sizeof(gint16), sizeof(s));
+      pcm->planes[c][i] = (gint32)((guint32)(guint16)s << 16);
+    }
+  }
+
+  // Less than one sample frame left: consumed stays 0 until more input arrives.
+  *consumed = (guint64)n * frame;
+  *planes = (const gint32 * const *)pcm->planes;
+  *nchannels = pcm->nchannels;
+  *nsamples = n;
+
+  return MIX_RESULT_SUCCESS;
+}
+
+static void mix_audio_swdec_pcm_close(gpointer ctx)
+{
+  MixAudioSwDecPcm *pcm = (MixAudioSwDecPcm*)ctx;
+  guint c = 0;
+
+  for (c = 0; c < pcm->nchannels; c++)
+    g_free(pcm->planes[c]);
+  g_free(pcm);
+}
+
+const MixAudioSwDecoderOps mix_audio_swdec_pcm =
+{
+  "pcm",
+  mix_audio_swdec_pcm_probe,
+  mix_audio_swdec_pcm_open,
+  mix_audio_swdec_pcm_decode,
+  NULL,
+  mix_audio_swdec_pcm_close
+};
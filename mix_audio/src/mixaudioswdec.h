@@ -0,0 +1,102 @@
+/* 
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved. 
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+
+#ifndef __MIX_AUDIO_SWDEC_H__
+#define __MIX_AUDIO_SWDEC_H__
+
+#include "mixaudio.h"
+
+/**
+ * MixAudioSwDecoderOps:
+ * @name: Backend name, used for logging.
+ * @probe: Returns %TRUE if the backend can decode streams described by the #MixAudioConfigParams (e.g. #MixAudioConfigParamsMP3 or #MixAudioConfigParamsAAC).
+ * @open: Create a decoder instance for the given configuration. Returns %NULL on failure.
+ * @decode: Decode at most one frame from @in. Set @consumed to the number of input bytes used and @planes/@nsamples to the decoded PCM. Planes are owned by the backend and stay valid until the next call. Returning success with @consumed of 0 means more input is needed.
+ * @reset: Discard any internal state, e.g. after a seek. May be %NULL.
+ * @close: Destroy a decoder instance.
+ *
+ * Software decoder backend. Decoded samples are delivered as one plane per channel of
+ * signed 32-bit samples, full scale left aligned, and are converted by MixAudio to the
+ * interleaved layout selected by mix_acp_set_bps() and mix_acp_set_op_align().
+ *
+ * MP3 and AAC backends are registered by the application; MixAudio only ships the
+ * #mix_audio_swdec_pcm reference backend, and registers nothing by itself. Without a
+ * registered backend mix_audio_initialize() fails as before when the LPE device cannot
+ * be opened.
+ */
+typedef struct _MixAudioSwDecoderOps
+{
+  const gchar *name;
+  gboolean (*probe) (MixAudioConfigParams *acp);
+  gpointer (*open) (MixAudioConfigParams *acp);
+  MIX_RESULT (*decode) (gpointer ctx, const guchar *in, guint64 insize, guint64 *consumed, const gint32 * const **planes, guint *nchannels, guint *nsamples);
+  void (*reset) (gpointer ctx);
+  void (*close) (gpointer ctx);
+} MixAudioSwDecoderOps;
+
+/**
+ * mix_audio_swdec_register:
+ * @ops: Backend to register. Must stay valid until the process exits.
+ * @returns: #MIX_RESULT_SUCCESS or #MIX_RESULT_NULL_PTR.
+ *
+ * Register a software decoder backend. When the LPE device cannot be opened, mix_audio_initialize()
+ * falls back to software decoding and mix_audio_configure() picks the most recently registered
+ * backend whose @probe accepts the configuration. Software decoding is only available in
+ * #MIX_DECODE_DECODERETURN mode.
+ */
+MIX_RESULT mix_audio_swdec_register(const MixAudioSwDecoderOps *ops);
+
+/**
+ * mix_audio_swdec_pcm:
+ *
+ * Reference backend for 16-bit native endian interleaved PCM. Its @probe accepts a plain
+ * #MixAudioConfigParams (not one of the codec specific subclasses) with 1 to 8 channels
+ * set by #MIX_ACP_NUM_CHANNELS, and output is converted to the configured bps and alignment.
+ * Register it with mix_audio_swdec_register() to run the software path without a codec.
+ */
+extern const MixAudioSwDecoderOps mix_audio_swdec_pcm;
+
+/**
+ * mix_audio_swdec_is_available:
+ * @returns: %TRUE if at least one software decoder backend is registered.
+ */
+gboolean mix_audio_swdec_is_available(void);
+
+/**
+ * mix_audio_pcm_interleave:
+ * @planes: One plane of @nsamples samples per channel.
+ * @nchannels: Number of channels.
+ * @nsamples: Samples per channel.
+ * @bps: Output bits per sample.
+ * @op_align: Output alignment. Ignored for 16-bit output.
+ * @out: Destination, must hold mix_audio_pcm_frame_size() * @nsamples bytes.
+ * @returns: Number of bytes written to @out.
+ *
+ * Interleave and convert full scale 32-bit planar samples to the output PCM layout.
+ * 16-bit output is packed; 24-bit output uses 32-bit containers, either MSB or LSB aligned.
+ */
+guint64 mix_audio_pcm_interleave(const gint32 * const *planes, guint nchannels, guint nsamples, MixACPBPSType bps, MixACPOpAlign op_align, guchar *out);
+
+/**
+ * mix_audio_pcm_frame_size:
+ * @nchannels: Number of channels.
+ * @bps: Output bits per sample.
+ * @returns: Size in bytes of one interleaved sample frame.
+ */
+guint mix_audio_pcm_frame_size(guint nchannels, MixACPBPSType bps);
+
+/* Internal, used by MixAudio. */
+typedef struct _MixAudioSwDecoder MixAudioSwDecoder;
+
+MixAudioSwDecoder *mix_audio_swdec_new(MixAudioConfigParams *acp);
+void mix_audio_swdec_free(MixAudioSwDecoder *dec);
+void mix_audio_swdec_reset(MixAudioSwDecoder *dec);
+MIX_RESULT mix_audio_swdec_decode(MixAudioSwDecoder *dec, const MixIOVec *iovin, gint iovincnt, guint64 *insize, MixIOVec *iovout, gint iovoutcnt, guint64 *outsize);
+
+#endif
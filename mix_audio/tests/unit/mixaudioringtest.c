@@ -0,0 +1,382 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+/*
+ * MixAudioRing against a pipe standing in for the SST device: an empty
+ * ring, slots wrapping around, a full ring blocking the producer while
+ * the device refuses data, and a drop while a write is in flight.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gprintf.h>
+#include "mixaudioring.h"
+
+#define PATTERN(i) ((guchar)((i) * 7 + 3))
+
+static gint failures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      g_printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+// Read exactly size bytes from fd.
+static gboolean read_all(int fd, guchar *buf, gsize size)
+{
+  while (size > 0)
+  {
+    ssize_t n = read(fd, buf, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return FALSE;
+    buf += n;
+    size -= n;
+  }
+  return TRUE;
+}
+
+static void fill_pattern(guchar *buf, gsize size, gsize start)
+{
+  gsize i = 0;
+  for (i = 0; i < size; i++) buf[i] = PATTERN(start + i);
+}
+
+static gboolean check_pattern(const guchar *buf, gsize size, gsize start)
+{
+  gsize i = 0;
+  for (i = 0; i < size; i++)
+  {
+    if (buf[i] != PATTERN(start + i)) return FALSE;
+  }
+  return TRUE;
+}
+
+typedef struct
+{
+  int fd;
+  guchar *buf;
+  gsize size;
+  gboolean ok;
+} Reader;
+
+static gpointer reader_thread(gpointer data)
+{
+  Reader *reader = (Reader*)data;
+  reader->ok = read_all(reader->fd, reader->buf, reader->size);
+  return NULL;
+}
+
+typedef struct
+{
+  MixAudioRing *ring;
+  MixIOVec *iov;
+  gint iovcnt;
+  guint64 insize;
+  MIX_RESULT ret;
+  volatile gboolean done;
+} Producer;
+
+static gpointer producer_thread(gpointer data)
+{
+  Producer *producer = (Producer*)data;
+  producer->ret = mix_audio_ring_enqueue(producer->ring, producer->iov, producer->iovcnt, &producer->insize);
+  producer->done = TRUE;
+  return NULL;
+}
+
+typedef struct
+{
+  MixAudioRing *ring;
+  volatile gboolean done;
+} Dropper;
+
+static gpointer dropper_thread(gpointer data)
+{
+  Dropper *dropper = (Dropper*)data;
+  mix_audio_ring_drop(dropper->ring);
+  dropper->done = TRUE;
+  return NULL;
+}
+
+// Fill a pipe until a non-blocking write fails, return the bytes written.
+static gsize stuff_pipe(int fd)
+{
+  guchar filler[4096];
+  gsize stuffed = 0;
+
+  memset(filler, 0, sizeof(filler));
+  while (TRUE)
+  {
+    ssize_t n = write(fd, filler, sizeof(filler));
+    if (n <= 0) break;
+    stuffed += n;
+  }
+  while (TRUE)
+  {
+    ssize_t n = write(fd, filler, 1);
+    if (n <= 0) break;
+    stuffed += n;
+  }
+  return stuffed;
+}
+
+static void test_empty(void)
+{
+  int fds[2];
+  guint64 insize = 1;
+  MixIOVec iov;
+
+  g_printf("empty ring\n");
+  CHECK(pipe(fds) == 0);
+
+  MixAudioRing *ring = mix_audio_ring_new(fds[1], 4, 16, 1, 4);
+  CHECK(ring != NULL);
+  if (!ring) return;
+
+  // Nothing queued: drain returns at once and nothing reaches the device.
+  CHECK(mix_audio_ring_drain(ring) == MIX_RESULT_SUCCESS);
+  CHECK(mix_audio_ring_get_bytes_written(ring) == 0);
+
+  // An empty input element takes no slot.
+  iov.data = NULL;
+  iov.size = 0;
+  CHECK(mix_audio_ring_enqueue(ring, &iov, 1, &insize) == MIX_RESULT_SUCCESS);
+  CHECK(insize == 0);
+  CHECK(mix_audio_ring_drain(ring) == MIX_RESULT_SUCCESS);
+  CHECK(mix_audio_ring_get_bytes_written(ring) == 0);
+
+  // Dropping an empty ring leaves it usable.
+  mix_audio_ring_drop(ring);
+  CHECK(mix_audio_ring_drain(ring) == MIX_RESULT_SUCCESS);
+
+  mix_audio_ring_free(ring);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_wrap(void)
+{
+  // Input elements of odd sizes spread over 4 slots of 8 bytes many times over.
+  static const gsize sizes[] = { 1, 8, 13, 24, 3, 7, 9, 16, 31, 2, 17, 5 };
+  const gint count = sizeof(sizes) / sizeof(sizes[0]);
+  MixIOVec iov[sizeof(sizes) / sizeof(sizes[0])];
+  gsize total = 0;
+  guint64 insize = 0;
+  gint i = 0;
+  int fds[2];
+
+  g_printf("slots wrapping around\n");
+  CHECK(pipe(fds) == 0);
+
+  for (i = 0; i < count; i++)
+  {
+    iov[i].data = g_malloc(sizes[i]);
+    iov[i].size = sizes[i];
+    fill_pattern(iov[i].data, sizes[i], total);
+    total += sizes[i];
+  }
+
+  Reader reader;
+  reader.fd = fds[0];
+  reader.buf = g_malloc0(total);
+  reader.size = total;
+  reader.ok = FALSE;
+  GThread *thread = g_thread_create(reader_thread, &reader, TRUE, NULL);
+  CHECK(thread != NULL);
+
+  MixAudioRing *ring = mix_audio_ring_new(fds[1], 4, 8, 1, 4);
+  CHECK(ring != NULL);
+  if (ring && thread)
+  {
+    // Enqueue twice so that the second pass starts at an arbitrary slot.
+    CHECK(mix_audio_ring_enqueue(ring, iov, count / 2, &insize) == MIX_RESULT_SUCCESS);
+    gsize first = insize;
+    CHECK(mix_audio_ring_enqueue(ring, iov + count / 2, count - count / 2, &insize) == MIX_RESULT_SUCCESS);
+    CHECK(first + insize == total);
+    CHECK(mix_audio_ring_drain(ring) == MIX_RESULT_SUCCESS);
+    CHECK(mix_audio_ring_get_bytes_written(ring) == total);
+
+    g_thread_join(thread);
+    CHECK(reader.ok);
+    CHECK(check_pattern(reader.buf, total, 0));
+  }
+
+  if (ring) mix_audio_ring_free(ring);
+  for (i = 0; i < count; i++) g_free(iov[i].data);
+  g_free(reader.buf);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_full(void)
+{
+  const guint slots = 4;
+  const guint slot_size = 16;
+  const gsize size = slots * slot_size * 2;
+  gsize stuffed = 0;
+  int fds[2];
+
+  g_printf("full ring\n");
+  CHECK(pipe(fds) == 0);
+
+  // Fill the pipe so that the device refuses data (EAGAIN) until it is read.
+  CHECK(fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0);
+  stuffed = stuff_pipe(fds[1]);
+  CHECK(errno == EAGAIN);
+
+  MixAudioRing *ring = mix_audio_ring_new(fds[1], slots, slot_size, 1, slots);
+  CHECK(ring != NULL);
+  if (!ring) return;
+
+  // Twice the ring capacity, so the producer has to wait for the device.
+  MixIOVec iov;
+  iov.data = g_malloc(size);
+  iov.size = size;
+  fill_pattern(iov.data, size, 0);
+
+  Producer producer;
+  producer.ring = ring;
+  producer.iov = &iov;
+  producer.iovcnt = 1;
+  producer.insize = 0;
+  producer.ret = MIX_RESULT_FAIL;
+  producer.done = FALSE;
+  GThread *thread = g_thread_create(producer_thread, &producer, TRUE, NULL);
+  CHECK(thread != NULL);
+
+  // The producer blocks at the high watermark while the writer waits for the
+  // device.
+  g_usleep(200 * 1000);
+  CHECK(!producer.done);
+  CHECK(mix_audio_ring_get_bytes_written(ring) == 0);
+
+  // Read the filler, then everything the ring writes, in order.
+  guchar *buf = g_malloc(stuffed + size);
+  CHECK(read_all(fds[0], buf, stuffed + size));
+  CHECK(check_pattern(buf + stuffed, size, 0));
+
+  if (thread) g_thread_join(thread);
+  CHECK(producer.done);
+  CHECK(producer.ret == MIX_RESULT_SUCCESS);
+  CHECK(producer.insize == size);
+  CHECK(mix_audio_ring_drain(ring) == MIX_RESULT_SUCCESS);
+  CHECK(mix_audio_ring_get_bytes_written(ring) == size);
+
+  mix_audio_ring_free(ring);
+  g_free(buf);
+  g_free(iov.data);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_drop(void)
+{
+  const guint slots = 4;
+  const guint slot_size = 16;
+  const gsize size = slots * slot_size;
+  gsize stuffed = 0;
+  guint64 insize = 0;
+  int fds[2];
+
+  g_printf("drop during a write\n");
+  CHECK(pipe(fds) == 0);
+
+  // A full blocking pipe: the writer sits in writev() until it is read.
+  CHECK(fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0);
+  stuffed = stuff_pipe(fds[1]);
+  CHECK(fcntl(fds[1], F_SETFL, 0) == 0);
+
+  MixAudioRing *ring = mix_audio_ring_new(fds[1], slots, slot_size, 1, slots);
+  CHECK(ring != NULL);
+  if (!ring) return;
+
+  // Fill every slot, the writer takes them all into one writev().
+  MixIOVec first;
+  first.data = g_malloc(size);
+  first.size = size;
+  fill_pattern(first.data, size, 0);
+  CHECK(mix_audio_ring_enqueue(ring, &first, 1, &insize) == MIX_RESULT_SUCCESS);
+  CHECK(insize == size);
+  g_usleep(100 * 1000);
+
+  // Drop while that write is blocked, with a producer waiting for room.
+  MixIOVec second;
+  second.data = g_malloc(size);
+  second.size = size;
+  fill_pattern(second.data, size, size);
+
+  Dropper dropper;
+  dropper.ring = ring;
+  dropper.done = FALSE;
+  GThread *drop_thread = g_thread_create(dropper_thread, &dropper, TRUE, NULL);
+  CHECK(drop_thread != NULL);
+
+  Producer producer;
+  producer.ring = ring;
+  producer.iov = &second;
+  producer.iovcnt = 1;
+  producer.insize = 0;
+  producer.ret = MIX_RESULT_FAIL;
+  producer.done = FALSE;
+  GThread *thread = g_thread_create(producer_thread, &producer, TRUE, NULL);
+  CHECK(thread != NULL);
+
+  // Neither the drop nor the producer may get past the write in flight.
+  g_usleep(200 * 1000);
+  CHECK(!dropper.done);
+  CHECK(!producer.done);
+
+  // The device sees the dropped write unchanged, then the new data.
+  guchar *buf = g_malloc(stuffed + size * 2);
+  CHECK(read_all(fds[0], buf, stuffed + size));
+  CHECK(check_pattern(buf + stuffed, size, 0));
+
+  if (drop_thread) g_thread_join(drop_thread);
+  if (thread) g_thread_join(thread);
+  CHECK(dropper.done);
+  CHECK(producer.done);
+  CHECK(producer.ret == MIX_RESULT_SUCCESS);
+  CHECK(producer.insize == size);
+  CHECK(mix_audio_ring_drain(ring) == MIX_RESULT_SUCCESS);
+  CHECK(read_all(fds[0], buf + stuffed + size, size));
+  CHECK(check_pattern(buf + stuffed + size, size, size));
+
+  // Only the write that was not dropped is accounted for.
+  CHECK(mix_audio_ring_get_bytes_written(ring) == size);
+
+  mix_audio_ring_free(ring);
+  g_free(buf);
+  g_free(first.data);
+  g_free(second.data);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int main(int argc, char **argv)
+{
+  if (!g_thread_supported()) g_thread_init(NULL);
+
+  test_empty();
+  test_wrap();
+  test_full();
+  test_drop();
+
+  if (failures)
+  {
+    g_printf("%d checks failed\n", failures);
+    return 1;
+  }
+  g_printf("PASS\n");
+  return 0;
+}
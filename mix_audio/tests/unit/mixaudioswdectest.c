@@ -0,0 +1,127 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+/*
+ * mix_audio_pcm_interleave() against a plain scalar reference. On x86 the
+ * library is built with SSE2, so mono and stereo go through the vector
+ * loops and any frame count that is not a multiple of the vector width
+ * finishes in the scalar tail; other channel counts are scalar only.
+ */
+
+#include <string.h>
+#include <glib/gprintf.h>
+#include "mixaudioswdec.h"
+
+#define MAX_CHANNELS 3
+#define MAX_FRAMES 67
+
+static gint failures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      g_printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static void reference_interleave(const gint32 * const *planes, guint nchannels, guint nsamples, MixACPBPSType bps, MixACPOpAlign op_align, guchar *out)
+{
+  guint i = 0, c = 0;
+
+  for (i = 0; i < nsamples; i++)
+  {
+    for (c = 0; c < nchannels; c++)
+    {
+      gint32 s = planes[c][i];
+      if (bps == MIX_ACP_BPS_24)
+      {
+        gint32 v = (op_align == MIX_ACP_OUTPUT_ALIGN_LSB) ? (s >> 8) : (gint32)((guint32)s & 0xFFFFFF00);
+        memcpy(out + (i * nchannels + c) * sizeof(gint32), &v, sizeof(v));
+      }
+      else
+      {
+        gint16 v = (gint16)(s >> 16);
+        memcpy(out + (i * nchannels + c) * sizeof(gint16), &v, sizeof(v));
+      }
+    }
+  }
+}
+
+static void test_layout(const gint32 * const *planes, guint nchannels, guint nsamples, MixACPBPSType bps, MixACPOpAlign op_align)
+{
+  // One frame of slack on each side catches writes outside the output.
+  guchar got[(MAX_FRAMES + 2) * MAX_CHANNELS * sizeof(gint32)];
+  guchar want[(MAX_FRAMES + 2) * MAX_CHANNELS * sizeof(gint32)];
+  guint frame = mix_audio_pcm_frame_size(nchannels, bps);
+  guint64 size = (guint64)frame * nsamples;
+
+  memset(got, 0xA5, sizeof(got));
+  memset(want, 0xA5, sizeof(want));
+  reference_interleave(planes, nchannels, nsamples, bps, op_align, want + frame);
+
+  guint64 written = mix_audio_pcm_interleave(planes, nchannels, nsamples, bps, op_align, got + frame);
+  CHECK(written == size);
+
+  if (memcmp(got, want, sizeof(got)) != 0)
+  {
+    g_printf("%u channels, %u frames, bps %d, align %d: output differs\n", nchannels, nsamples, bps, op_align);
+    failures++;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  static gint32 data[MAX_CHANNELS][MAX_FRAMES];
+  const gint32 *planes[MAX_CHANNELS];
+  guint i = 0, c = 0, n = 0;
+
+  // Random samples, with both full scale extremes and sign boundaries mixed in.
+  GRand *rand = g_rand_new_with_seed(0x5EED);
+  for (c = 0; c < MAX_CHANNELS; c++)
+  {
+    planes[c] = data[c];
+    for (i = 0; i < MAX_FRAMES; i++)
+      data[c][i] = (gint32)g_rand_int(rand);
+  }
+  g_rand_free(rand);
+  data[0][0] = G_MININT32;
+  data[1][1] = G_MAXINT32;
+  data[0][5] = -1;
+  data[1][6] = 0;
+  data[2][2] = 0x7FFF8000;
+  data[0][9] = (gint32)0x80007FFF;
+
+  for (c = 1; c <= MAX_CHANNELS; c++)
+  {
+    for (n = 0; n <= MAX_FRAMES; n++)
+    {
+      test_layout(planes, c, n, MIX_ACP_BPS_16, MIX_ACP_OUTPUT_ALIGN_16);
+      test_layout(planes, c, n, MIX_ACP_BPS_24, MIX_ACP_OUTPUT_ALIGN_MSB);
+      test_layout(planes, c, n, MIX_ACP_BPS_24, MIX_ACP_OUTPUT_ALIGN_LSB);
+    }
+  }
+
+  // Odd frame counts starting at an unaligned sample, as with held-back PCM.
+  for (c = 0; c < MAX_CHANNELS; c++)
+    planes[c] = data[c] + 1;
+  test_layout(planes, 2, MAX_FRAMES - 2, MIX_ACP_BPS_16, MIX_ACP_OUTPUT_ALIGN_16);
+  test_layout(planes, 2, MAX_FRAMES - 2, MIX_ACP_BPS_24, MIX_ACP_OUTPUT_ALIGN_MSB);
+  test_layout(planes, 1, MAX_FRAMES - 4, MIX_ACP_BPS_16, MIX_ACP_OUTPUT_ALIGN_16);
+
+  CHECK(mix_audio_pcm_interleave(NULL, 2, 4, MIX_ACP_BPS_16, MIX_ACP_OUTPUT_ALIGN_16, (guchar*)data) == 0);
+  CHECK(mix_audio_pcm_interleave(planes, 0, 4, MIX_ACP_BPS_16, MIX_ACP_OUTPUT_ALIGN_16, (guchar*)data) == 0);
+
+  if (failures)
+  {
+    g_printf("%d checks failed\n", failures);
+    return 1;
+  }
+  g_printf("PASS\n");
+  return 0;
+}
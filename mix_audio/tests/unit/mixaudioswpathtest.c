@@ -0,0 +1,212 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+*/
+
+/*
+ * Software decode path through the public API, on a host without the LPE
+ * device: mix_audio_initialize() falls back to software decoding once a
+ * backend is registered, mix_audio_configure() selects the PCM reference
+ * backend, and mix_audio_decode() converts into output buffers too small
+ * for one decoded block, so converted PCM is held back between calls.
+ * Exits 77 (skipped) when the device can be opened.
+ */
+
+#include <string.h>
+#include <glib/gprintf.h>
+#include "mixaudio.h"
+#include "mixacp.h"
+#include "mixacpmp3.h"
+#include "mixaudioswdec.h"
+
+#define CHANNELS 2
+#define FRAMES 3001
+#define OUT_FRAME (CHANNELS * sizeof(gint32))
+
+static gint failures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      g_printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static MixAudioConfigParams *make_acp(MixDecodeMode mode)
+{
+  MixAudioConfigParams *acp = mix_acp_new();
+
+  mix_acp_set_streamname(acp, "swpath");
+  mix_acp_set_decodemode(acp, mode);
+  mix_acp_set_bps(acp, MIX_ACP_BPS_24);
+  mix_acp_set_op_align(acp, MIX_ACP_OUTPUT_ALIGN_MSB);
+  MIX_ACP_NUM_CHANNELS(acp) = CHANNELS;
+  MIX_ACP_SAMPLE_FREQ(acp) = 48000;
+
+  return acp;
+}
+
+/* 24-bit MSB aligned in a 32-bit container, as the PCM backend produces it. */
+static void expect_pcm(const gint16 *in, guint nsamples, guchar *out)
+{
+  guint i = 0;
+
+  for (i = 0; i < nsamples; i++)
+  {
+    gint32 v = (gint32)((guint32)(guint16)in[i] << 16);
+    memcpy(out + i * sizeof(gint32), &v, sizeof(v));
+  }
+}
+
+static void test_configure(MixAudio *mix)
+{
+  MixAudioConfigParams *acp = NULL;
+  MixAudioConfigParamsMP3 *mp3 = NULL;
+  guchar in[4] = { 0 };
+  guchar out[8];
+  MixIOVec iovin = { in, sizeof(in) };
+  MixIOVec iovout = { out, sizeof(out) };
+  guint64 insize = 0, outsize = 0;
+
+  // Nothing is configured yet.
+  CHECK(mix_audio_decode(mix, &iovin, 1, &insize, &iovout, 1, &outsize) == MIX_RESULT_WRONG_STATE);
+
+  // No registered backend takes MP3.
+  mp3 = mix_acp_mp3_new();
+  mix_acp_set_streamname(MIX_AUDIOCONFIGPARAMS(mp3), "swpath");
+  mix_acp_set_decodemode(MIX_AUDIOCONFIGPARAMS(mp3), MIX_DECODE_DECODERETURN);
+  MIX_ACP_NUM_CHANNELS(mp3) = CHANNELS;
+  CHECK(mix_audio_configure(mix, MIX_AUDIOCONFIGPARAMS(mp3), NULL) == MIX_RESULT_CODEC_NOTSUPPORTED);
+  mix_acp_mp3_unref(mp3);
+
+  // There is no device to render to.
+  acp = make_acp(MIX_DECODE_DIRECTRENDER);
+  CHECK(mix_audio_configure(mix, acp, NULL) == MIX_RESULT_WRONGMODE);
+  mix_acp_unref(acp);
+
+  acp = make_acp(MIX_DECODE_DECODERETURN);
+  CHECK(mix_audio_configure(mix, acp, NULL) == MIX_RESULT_SUCCESS);
+  CHECK(mix->swdec != NULL);
+  mix_acp_unref(acp);
+}
+
+static void test_decode(MixAudio *mix, const gint16 *pcm)
+{
+  // One trailing byte that never makes a whole sample frame.
+  const guint64 insize_total = (guint64)FRAMES * CHANNELS * sizeof(gint16) + 1;
+  const guchar *in = (const guchar*)pcm;
+  guchar *want = g_malloc((guint64)FRAMES * OUT_FRAME);
+  guchar *got = g_malloc0((guint64)FRAMES * OUT_FRAME + 64);
+  guchar out0[1000], out1[3003];
+  guint64 in_off = 0, got_size = 0;
+  gint calls = 0;
+
+  expect_pcm(pcm, FRAMES * CHANNELS, want);
+
+  while (calls++ < 1000)
+  {
+    // Split what is left at an odd offset so sample frames straddle the two input vectors.
+    guint64 left = insize_total - in_off;
+    guint64 first = MIN(left, 4001);
+    MixIOVec iovin[2] = { { (guchar*)in + in_off, (gint)first }, { (guchar*)in + in_off + first, (gint)(left - first) } };
+    MixIOVec iovout[2] = { { out0, sizeof(out0) }, { out1, sizeof(out1) } };
+    guint64 insize = 0, outsize = 0;
+
+    CHECK(mix_audio_decode(mix, iovin, 2, &insize, iovout, 2, &outsize) == MIX_RESULT_SUCCESS);
+    if ((insize == 0) && (outsize == 0)) break;
+
+    CHECK(insize <= left);
+    CHECK(outsize <= sizeof(out0) + sizeof(out1));
+    if (got_size + outsize > (guint64)FRAMES * OUT_FRAME) break;
+
+    memcpy(got + got_size, out0, MIN(outsize, sizeof(out0)));
+    if (outsize > sizeof(out0))
+      memcpy(got + got_size + sizeof(out0), out1, outsize - sizeof(out0));
+    got_size += outsize;
+    in_off += insize;
+  }
+
+  CHECK(in_off == insize_total - 1);
+  CHECK(got_size == (guint64)FRAMES * OUT_FRAME);
+  CHECK(memcmp(got, want, (guint64)FRAMES * OUT_FRAME) == 0);
+
+  g_free(want);
+  g_free(got);
+}
+
+static void test_drop(MixAudio *mix, const gint16 *pcm)
+{
+  guchar out[64 * OUT_FRAME];
+  guchar want[64 * OUT_FRAME];
+  MixIOVec iovin = { (guchar*)pcm, 100 * CHANNELS * sizeof(gint16) };
+  MixIOVec iovout = { out, OUT_FRAME };
+  guint64 insize = 0, outsize = 0;
+
+  // One frame of room: the other 99 are held back.
+  CHECK(mix_audio_decode(mix, &iovin, 1, &insize, &iovout, 1, &outsize) == MIX_RESULT_SUCCESS);
+  CHECK(insize == iovin.size);
+  CHECK(outsize == OUT_FRAME);
+
+  CHECK(mix_audio_stop_drop(mix) == MIX_RESULT_SUCCESS);
+
+  // Held back PCM is gone; output starts with the new input.
+  iovin.data = (guchar*)(pcm + 500 * CHANNELS);
+  iovin.size = 64 * CHANNELS * sizeof(gint16);
+  iovout.size = sizeof(out);
+  CHECK(mix_audio_decode(mix, &iovin, 1, &insize, &iovout, 1, &outsize) == MIX_RESULT_SUCCESS);
+  CHECK(insize == iovin.size);
+  CHECK(outsize == sizeof(out));
+  expect_pcm(pcm + 500 * CHANNELS, 64 * CHANNELS, want);
+  CHECK(memcmp(out, want, sizeof(out)) == 0);
+}
+
+int main(int argc, char **argv)
+{
+  static gint16 pcm[FRAMES * CHANNELS + 1];
+  MixAudio *mix = NULL;
+  MIX_RESULT ret = MIX_RESULT_SUCCESS;
+  guint i = 0;
+
+  g_type_init();
+
+  GRand *rand = g_rand_new_with_seed(0x5EED);
+  for (i = 0; i < G_N_ELEMENTS(pcm); i++)
+    pcm[i] = (gint16)g_rand_int(rand);
+  g_rand_free(rand);
+  pcm[0] = G_MININT16;
+  pcm[1] = G_MAXINT16;
+  pcm[2] = -1;
+
+  CHECK(mix_audio_swdec_register(&mix_audio_swdec_pcm) == MIX_RESULT_SUCCESS);
+
+  mix = mix_audio_new();
+  ret = mix_audio_initialize(mix, MIX_CODING_DECODE, NULL, NULL);
+  if (!MIX_SUCCEEDED(ret) || !mix->swdecode)
+  {
+    // The device (or the LPESTUB output file) opened; nothing to test here.
+    g_printf("SKIP: LPE device present (0x%08x)\n", ret);
+    if (MIX_SUCCEEDED(ret)) mix_audio_deinitialize(mix);
+    mix_audio_unref(mix);
+    return 77;
+  }
+
+  test_configure(mix);
+  test_decode(mix, pcm);
+  test_drop(mix, pcm);
+
+  CHECK(mix_audio_deinitialize(mix) == MIX_RESULT_SUCCESS);
+  CHECK(mix->swdec == NULL);
+  mix_audio_unref(mix);
+
+  if (failures)
+  {
+    g_printf("%d checks failed\n", failures);
+    return 1;
+  }
+  g_printf("PASS\n");
+  return 0;
+}
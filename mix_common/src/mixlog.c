@@ -7,6 +7,8 @@
  */
 
 #include <glib.h>
+#include <glib/gprintf.h>
+#include <stdlib.h>
 #include <string.h>
 #include "mixlog.h"
 
@@ -17,9 +19,16 @@
 #define MIX_DELOG_DELIMITERS " ,;"
 
 #define MIX_LOG_LEVEL "MIX_LOG_LEVEL"
+#define MIX_LOG_ASYNC "MIX_LOG_ASYNC"
 
 static GStaticMutex g_mutex = G_STATIC_MUTEX_INIT;
 
+volatile gint mix_log_threshold = G_MAXINT;
+
+void mix_log_set_level(gint level) {
+	g_atomic_int_set(&mix_log_threshold, level);
+}
+
 #ifdef MIX_LOG_USE_HT
 static GHashTable *g_defile_ht = NULL, *g_defunc_ht = NULL, *g_decom_ht = NULL;
 static gint g_mix_log_level = MIX_LOG_LEVEL_VERBOSE;
@@ -65,6 +74,7 @@ void mix_log_initialize_func() {
 		if (mix_log_level) {
 			g_mix_log_level = atoi(mix_log_level);
 		}
+		mix_log_set_level(g_mix_log_level);
 
 		mix_log_get_ht(&g_decom_ht, MIX_DELOG_COMPS);
 		mix_log_get_ht(&g_defile_ht, MIX_DELOG_FILES);
@@ -88,6 +98,7 @@ void mix_log_finalize_func() {
 		mix_log_destroy_ht(g_defunc_ht);
 
 		g_mix_log_level = MIX_LOG_LEVEL_VERBOSE;
+		mix_log_set_level(G_MAXINT);
 	}
 
 	if (g_refcount < 0) {
@@ -149,31 +160,44 @@ void mix_log_func(const gchar* comp, gint level, const gchar *file,
 
 #else /* MIX_LOG_USE_HT */
 
-gboolean mix_shall_delog(const gchar *name, const gchar *var) {
+/* Size of the async ring, must be a power of 2, and of one formatted line. */
+#define MIX_LOG_RING_SIZE 1024
+#define MIX_LOG_RECORD_SIZE 256
 
-	const char *delog_list = NULL;
-	char *item = NULL;
-	gboolean delog = FALSE;
+typedef struct {
+	volatile gint seq;
+	gchar text[MIX_LOG_RECORD_SIZE];
+} MixLogRecord;
 
-	if (!name || !var) {
-		return delog;
-	}
+/* Environment is parsed once, on the first mix_log_func() call. */
+static volatile gint g_initialized = 0;
+static gchar **g_delog_comps = NULL;
+static gchar **g_delog_files = NULL;
+static gchar **g_delog_funcs = NULL;
 
-	delog_list = g_getenv(var);
-	if (!delog_list) {
-		return delog;
+static volatile gint g_async = 0;
+static MixLogRecord *g_ring = NULL;
+static volatile gint g_ring_head = 0;
+static volatile gint g_ring_tail = 0;
+static volatile gint g_ring_dropped = 0;
+static volatile gint g_ring_stop = 0;
+static volatile gint g_ring_running = 0;
+
+gboolean mix_shall_delog(const gchar *name, gchar **list) {
+
+	gchar **item = NULL;
+
+	if (!name || !list) {
+		return FALSE;
 	}
 
-	item = strtok((char *) delog_list, MIX_DELOG_DELIMITERS);
-	while (item != NULL) {
-		if (strcmp(item, name) == 0) {
-			delog = TRUE;
-			break;
+	for (item = list; *item; item++) {
+		if (**item && strcmp(*item, name) == 0) {
+			return TRUE;
 		}
-		item = strtok(NULL, MIX_DELOG_DELIMITERS);
 	}
 
-	return delog;
+	return FALSE;
 }
 
 gboolean mix_log_enabled() {
@@ -190,48 +214,204 @@ gboolean mix_log_enabled() {
 	return TRUE;
 }
 
-void mix_log_func(const gchar* comp, gint level, const gchar *file,
-		const gchar *func, gint line, const gchar *format, ...) {
+static gchar **mix_log_get_list(const gchar *var) {
 
-	va_list args;
-	static gchar* loglevel[4] = { "**ERROR", "*WARNING", "INFO", "VERBOSE" };
+	const gchar *value = g_getenv(var);
+	if (!value) {
+		return NULL;
+	}
+
+	/* split a copy; strtok on the environment string would modify it */
+	return g_strsplit_set(value, MIX_DELOG_DELIMITERS, -1);
+}
+
+static void mix_log_initialize() {
+
+	const gchar *env = NULL;
+	gint threshold = MIX_LOG_LEVEL_VERBOSE;
+
+	g_static_mutex_lock(&g_mutex);
+
+	if (!g_initialized) {
+		if (!mix_log_enabled()) {
+			threshold = 0;
+		} else {
+			env = g_getenv(MIX_LOG_LEVEL);
+			if (env) {
+				threshold = atoi(env);
+			}
+		}
+
+		g_delog_comps = mix_log_get_list(MIX_DELOG_COMPS);
+		g_delog_files = mix_log_get_list(MIX_DELOG_FILES);
+		g_delog_funcs = mix_log_get_list(MIX_DELOG_FUNCS);
 
-	const gchar *env_mix_log_level = NULL;
-	gint mix_log_level_threhold = MIX_LOG_LEVEL_VERBOSE;
+		/* an explicit mix_log_set_level() wins over the environment */
+		g_atomic_int_compare_and_exchange(&mix_log_threshold, G_MAXINT, threshold);
 
-	if(!mix_log_enabled()) {
+		env = g_getenv(MIX_LOG_ASYNC);
+		g_atomic_int_set(&g_initialized, 1);
+
+		g_static_mutex_unlock(&g_mutex);
+
+		if (env && env[0] != '0') {
+			mix_log_set_async(TRUE);
+		}
 		return;
 	}
 
-	if (!format) {
-		return;
+	g_static_mutex_unlock(&g_mutex);
+}
+
+static gboolean mix_log_ring_push(const gchar *text) {
+
+	guint pos = (guint) g_atomic_int_get(&g_ring_head);
+	MixLogRecord *rec = NULL;
+
+	for (;;) {
+		gint dif = 0;
+		rec = &g_ring[pos & (MIX_LOG_RING_SIZE - 1)];
+		dif = (gint) ((guint) g_atomic_int_get(&rec->seq) - pos);
+		if (dif == 0) {
+			if (g_atomic_int_compare_and_exchange(&g_ring_head, (gint) pos, (gint) (pos + 1))) {
+				break;
+			}
+			pos = (guint) g_atomic_int_get(&g_ring_head);
+		} else if (dif < 0) {
+			/* full */
+			g_atomic_int_add(&g_ring_dropped, 1);
+			return FALSE;
+		} else {
+			pos = (guint) g_atomic_int_get(&g_ring_head);
+		}
 	}
 
+	g_strlcpy(rec->text, text, MIX_LOG_RECORD_SIZE);
+	g_atomic_int_set(&rec->seq, (gint) (pos + 1));
+
+	return TRUE;
+}
+
+static gpointer mix_log_ring_thread(gpointer data) {
+
+	guint tail = (guint) g_atomic_int_get(&g_ring_tail);
+
+	for (;;) {
+		MixLogRecord *rec = &g_ring[tail & (MIX_LOG_RING_SIZE - 1)];
+		gint dropped = 0;
+
+		if ((guint) g_atomic_int_get(&rec->seq) == tail + 1) {
+			g_print("%s", rec->text);
+			g_atomic_int_set(&rec->seq, (gint) (tail + MIX_LOG_RING_SIZE));
+			tail++;
+			g_atomic_int_set(&g_ring_tail, (gint) tail);
+			continue;
+		}
+
+		do {
+			dropped = g_atomic_int_get(&g_ring_dropped);
+		} while (dropped && !g_atomic_int_compare_and_exchange(&g_ring_dropped, dropped, 0));
+		if (dropped) {
+			g_print("*WARNING : mixlog : %d messages dropped\n", dropped);
+		}
+
+		if (g_atomic_int_get(&g_ring_stop)) {
+			break;
+		}
+		g_usleep(1000);
+	}
+
+	g_atomic_int_set(&g_ring_running, 0);
+	return NULL;
+}
+
+void mix_log_flush(void) {
+
+	while (g_atomic_int_get(&g_ring_running) &&
+			g_atomic_int_get(&g_ring_tail) != g_atomic_int_get(&g_ring_head)) {
+		g_usleep(1000);
+	}
+}
+
+void mix_log_set_async(gboolean async) {
+
+	gint i = 0;
+
 	g_static_mutex_lock(&g_mutex);
 
-	/* log level */
-	env_mix_log_level = g_getenv(MIX_LOG_LEVEL);
-	if (env_mix_log_level) {
-		mix_log_level_threhold = atoi(env_mix_log_level);
+	if (async && !g_atomic_int_get(&g_async)) {
+		if (!g_thread_supported()) {
+			/* the ring needs a thread; stay synchronous */
+			goto exit;
+		}
+
+		/* wait for a previous writer to finish before reusing the ring */
+		while (g_atomic_int_get(&g_ring_running)) {
+			g_usleep(1000);
+		}
+
+		if (!g_ring) {
+			g_ring = g_new0(MixLogRecord, MIX_LOG_RING_SIZE);
+			atexit(mix_log_flush);
+		}
+		for (i = 0; i < MIX_LOG_RING_SIZE; i++) {
+			g_ring[i].seq = i;
+		}
+		g_ring_head = 0;
+		g_ring_tail = 0;
+		g_ring_dropped = 0;
+		g_ring_stop = 0;
+		g_ring_running = 1;
+
+		if (!g_thread_create(mix_log_ring_thread, NULL, FALSE, NULL)) {
+			g_ring_running = 0;
+			goto exit;
+		}
+		g_atomic_int_set(&g_async, 1);
+	} else if (!async && g_atomic_int_get(&g_async)) {
+		/* new messages go to stdio directly; let the writer empty the ring and exit */
+		g_atomic_int_set(&g_async, 0);
+		mix_log_flush();
+		g_atomic_int_set(&g_ring_stop, 1);
 	}
 
-	if (level > mix_log_level_threhold) {
-		goto exit;
+exit:
+	g_static_mutex_unlock(&g_mutex);
+}
+
+void mix_log_func(const gchar* comp, gint level, const gchar *file,
+		const gchar *func, gint line, const gchar *format, ...) {
+
+	va_list args;
+	static gchar* loglevel[4] = { "**ERROR", "*WARNING", "INFO", "VERBOSE" };
+	gchar text[MIX_LOG_RECORD_SIZE];
+	gint len = 0;
+
+	if (G_UNLIKELY(!g_atomic_int_get(&g_initialized))) {
+		mix_log_initialize();
+	}
+
+	if (level > mix_log_threshold) {
+		return;
+	}
+
+	if (!format) {
+		return;
 	}
 
 	/* component */
-	if (mix_shall_delog(comp, MIX_DELOG_COMPS)) {
-		goto exit;
+	if (mix_shall_delog(comp, g_delog_comps)) {
+		return;
 	}
 
 	/* files */
-	if (mix_shall_delog(file, MIX_DELOG_FILES)) {
-		goto exit;
+	if (mix_shall_delog(file, g_delog_files)) {
+		return;
 	}
 
 	/* functions */
-	if (mix_shall_delog(func, MIX_DELOG_FUNCS)) {
-		goto exit;
+	if (mix_shall_delog(func, g_delog_funcs)) {
+		return;
 	}
 
 	if (level > MIX_LOG_LEVEL_VERBOSE) {
@@ -241,13 +421,29 @@ void mix_log_func(const gchar* comp, gint level, const gchar *file,
 		level = MIX_LOG_LEVEL_ERROR;
 	}
 
+	if (g_atomic_int_get(&g_async)) {
+		len = g_snprintf(text, sizeof(text), "%s : %s : %s : ", loglevel[level - 1], file, func);
+		if (len < (gint) sizeof(text)) {
+			va_start(args, format);
+			len += g_vsnprintf(text + len, sizeof(text) - len, format, args);
+			va_end(args);
+		}
+		if (len >= (gint) sizeof(text)) {
+			/* truncated, still end the record with a newline */
+			text[sizeof(text) - 2] = '\n';
+		}
+		mix_log_ring_push(text);
+		return;
+	}
+
+	g_static_mutex_lock(&g_mutex);
+
 	g_print("%s : %s : %s : ", loglevel[level - 1], file, func);
 
 	va_start(args, format);
 	g_vprintf(format, args);
 	va_end(args);
 
-exit:
 	g_static_mutex_unlock(&g_mutex);
 }
 
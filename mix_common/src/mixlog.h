@@ -32,11 +32,43 @@ void mix_log_func(const gchar* comp, gint level, const gchar *file,
 #define MIX_LOG_LEVEL_VERBOSE	4
 
 
+/* Levels above this are compiled out, e.g. -DMIX_LOG_COMPILE_LEVEL=MIX_LOG_LEVEL_WARNING */
+#ifndef MIX_LOG_COMPILE_LEVEL
+#define MIX_LOG_COMPILE_LEVEL	MIX_LOG_LEVEL_VERBOSE
+#endif
+
+/*
+ * Cached runtime threshold. Starts at G_MAXINT so the first call reaches
+ * mix_log_func(), which loads MIX_LOG_ENABLE/MIX_LOG_LEVEL and caches the
+ * result here; a disabled level then costs a single compare.
+ * Warning: don't write to it, use mix_log_set_level().
+ */
+extern volatile gint mix_log_threshold;
+
+/* Override the level read from MIX_LOG_LEVEL. 0 disables logging. */
+void mix_log_set_level(gint level);
+
+#ifndef MIX_LOG_USE_HT
+/*
+ * Queue messages to a ring buffer drained by a background thread instead
+ * of printing them from the caller. Also enabled by MIX_LOG_ASYNC=1.
+ * Messages are dropped (and counted) when the ring is full, and records
+ * are cut at 256 bytes. Not available with MIX_LOG_USE_HT.
+ */
+void mix_log_set_async(gboolean async);
+
+/* Wait until all queued messages have been printed. */
+void mix_log_flush(void);
+#endif
+
 /* MACROS for mixlog */
 #ifdef MIX_LOG_ENABLE
 
 #define mix_log(comp, level, format, ...) \
-	mix_log_func(comp, level, __FILE__, __FUNCTION__, __LINE__, format, ##__VA_ARGS__)
+	do { \
+		if ((level) <= MIX_LOG_COMPILE_LEVEL && (level) <= mix_log_threshold) \
+			mix_log_func(comp, level, __FILE__, __FUNCTION__, __LINE__, format, ##__VA_ARGS__); \
+	} while (0)
 
 #else
 
@@ -0,0 +1,104 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+ */
+
+
+/*
+ * Measures the cost of mix_log() per decoded frame, modelled as a fixed
+ * number of LOG_V style calls (surface pool get/put, frame manager, etc.).
+ *
+ * usage: mixlogbench [frames] [logs_per_frame] [threads]
+ *
+ * Log output goes to stdout, results to stderr:
+ *   ./mixlogbench 20000 16 4 > /dev/null
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include "mixlog.h"
+
+typedef struct {
+	gint frames;
+	gint logs_per_frame;
+} BenchParams;
+
+static gpointer bench_thread(gpointer data) {
+
+	BenchParams *p = (BenchParams *) data;
+	gint f = 0, i = 0;
+
+	for (f = 0; f < p->frames; f++) {
+		for (i = 0; i < p->logs_per_frame; i++) {
+			mix_log(MIX_VIDEO_COMP, MIX_LOG_LEVEL_VERBOSE,
+					"frame %d surface %d refcount %d\n", f, i, 1);
+		}
+	}
+
+	return NULL;
+}
+
+static void bench_run(const gchar *name, BenchParams *p, gint nthreads) {
+
+	GThread **threads = g_new0(GThread *, nthreads);
+	GTimer *timer = g_timer_new();
+	gdouble elapsed = 0;
+	gint i = 0;
+
+	g_timer_start(timer);
+	for (i = 0; i < nthreads; i++) {
+		threads[i] = g_thread_create(bench_thread, p, TRUE, NULL);
+	}
+	for (i = 0; i < nthreads; i++) {
+		g_thread_join(threads[i]);
+	}
+	elapsed = g_timer_elapsed(timer, NULL);
+
+#ifndef MIX_LOG_USE_HT
+	/* time to drain the async ring is not charged to the decode threads */
+	mix_log_flush();
+#endif
+
+	g_printerr("%-10s %10.1f ns/frame %10.1f ns/call\n", name,
+			elapsed * 1e9 / ((gdouble) p->frames * nthreads),
+			elapsed * 1e9 / ((gdouble) p->frames * nthreads * p->logs_per_frame));
+
+	g_timer_destroy(timer);
+	g_free(threads);
+}
+
+int main(int argc, char *argv[]) {
+
+	BenchParams p = { 20000, 16 };
+	gint nthreads = 1;
+
+	if (argc > 1) p.frames = atoi(argv[1]);
+	if (argc > 2) p.logs_per_frame = atoi(argv[2]);
+	if (argc > 3) nthreads = atoi(argv[3]);
+
+	if (p.frames <= 0 || p.logs_per_frame <= 0 || nthreads <= 0) {
+		g_printerr("usage: %s [frames] [logs_per_frame] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	g_thread_init(NULL);
+
+	g_printerr("%d frames x %d logs, %d thread(s)\n", p.frames, p.logs_per_frame, nthreads);
+
+	mix_log_set_level(MIX_LOG_LEVEL_WARNING);
+	bench_run("disabled", &p, nthreads);
+
+	mix_log_set_level(MIX_LOG_LEVEL_VERBOSE);
+	bench_run("sync", &p, nthreads);
+
+#ifndef MIX_LOG_USE_HT
+	mix_log_set_async(TRUE);
+	bench_run("async", &p, nthreads);
+	mix_log_set_async(FALSE);
+#endif
+
+	return 0;
+}
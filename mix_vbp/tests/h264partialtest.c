@@ -0,0 +1,533 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+ */
+
+
+
+/*
+ * Checks vbp_parse_partial against vbp_parse on a synthetic baseline H.264
+ * stream in the 4-byte length prefixed format: SPS, PPS and a recovery
+ * point SEI, an IDR picture of three slices and P pictures. Each picture is
+ * parsed whole with vbp_parse, then the stream is fed to vbp_parse_partial
+ * 1, 2 and 3 NALs at a time. For every chunk:
+ *   consumed    stops at the first NAL of the next frame (0 if the chunk
+ *               starts with it), the whole chunk otherwise
+ *   frame_done  set, and VBP_DONE returned, on the next frame or with
+ *               last_chunk on the last chunk, not before
+ *   pictures    none before the first slice of a frame, so no dummy
+ *               picture for a chunk of SPS/PPS/SEI only, then the slices
+ *               received so far
+ * A complete frame must match vbp_parse: picture and slice parameters and
+ * slice data addresses. The last P picture has more slices than the list
+ * items of a sample buffer (MAX_IBUFS_PER_SC), which only vbp_parse_partial
+ * can take, its slices are checked against the stream.
+ *
+ * The parser libraries are dlopen()ed by vbp_open, make check points
+ * LD_LIBRARY_PATH at viddec_fw/fw/parser/.libs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vbp_loader.h"
+#include "viddec_pm_utils_list.h"
+
+#define WIDTH_MBS		32
+#define HEIGHT_MBS		18
+#define MANY_SLICES		(MAX_IBUFS_PER_SC + 8)
+
+#define MAX_NALS		(MANY_SLICES + 16)
+#define MAX_FRAMES		8
+#define MAX_STREAM		(MAX_NALS * 32)
+
+#define NAL_SLICE		1
+#define NAL_IDR			5
+#define NAL_SEI			6
+#define NAL_SPS			7
+#define NAL_PPS			8
+
+#define SLICE_P			5
+#define SLICE_I			7
+
+typedef struct {
+	uint8 buf[64];
+	uint32 bits;
+} BitWriter;
+
+typedef struct {
+	uint32 offset;		/* of the length prefix in the stream */
+	uint32 size;		/* length prefix included */
+	uint32 first_mb;	/* for slices */
+	int is_slice;
+} Nal;
+
+/* what vbp_parse returned for a frame */
+typedef struct {
+	uint32 num_pictures;
+	uint32 num_slices;
+	uint8 idr_flag;
+	uint8 has_recovery_point;
+	VAPictureParameterBufferH264 pic_parms;
+	vbp_slice_data_h264 *slc_data;
+} Frame;
+
+static uint8 stream[MAX_STREAM];
+static uint32 stream_size = 0;
+static Nal nals[MAX_NALS];
+static int num_nals = 0;
+static int frame_start[MAX_FRAMES + 1];	/* first NAL of each frame */
+static int num_frames = 0;
+static Frame frames[MAX_FRAMES];
+static int many_frame = -1;
+
+static void put_bits(BitWriter *bw, uint32 value, int n)
+{
+	while (n-- > 0)
+	{
+		if ((value >> n) & 1)
+		{
+			bw->buf[bw->bits >> 3] |= 0x80 >> (bw->bits & 7);
+		}
+		bw->bits++;
+	}
+}
+
+static void put_ue(BitWriter *bw, uint32 value)
+{
+	uint32 code = value + 1;
+	int len = 0;
+
+	while ((code >> len) > 1) len++;
+	put_bits(bw, 0, len);
+	put_bits(bw, code, len + 1);
+}
+
+static void put_trailing_bits(BitWriter *bw)
+{
+	put_bits(bw, 1, 1);
+	while (bw->bits & 7) put_bits(bw, 0, 1);
+}
+
+/* escape the RBSP into the stream behind a 4-byte length prefix */
+static void add_nal(int type, int ref_idc, BitWriter *bw, int is_slice, uint32 first_mb)
+{
+	Nal *nal = &nals[num_nals++];
+	uint8 *p = stream + stream_size + 4;
+	uint32 zeros = 0;
+	uint32 i, size;
+
+	memset(nal, 0, sizeof(*nal));
+	nal->offset = stream_size;
+	nal->is_slice = is_slice;
+	nal->first_mb = first_mb;
+
+	*p++ = (uint8)((ref_idc << 5) | type);
+	for (i = 0; i < bw->bits / 8; i++)
+	{
+		if (zeros == 2 && bw->buf[i] <= 3)
+		{
+			*p++ = 3;
+			zeros = 0;
+		}
+		zeros = bw->buf[i] ? 0 : zeros + 1;
+		*p++ = bw->buf[i];
+	}
+
+	size = p - (stream + stream_size + 4);
+	stream[stream_size] = (uint8)(size >> 24);
+	stream[stream_size + 1] = (uint8)(size >> 16);
+	stream[stream_size + 2] = (uint8)(size >> 8);
+	stream[stream_size + 3] = (uint8)size;
+	nal->size = size + 4;
+	stream_size += nal->size;
+}
+
+static void start_frame(void)
+{
+	frame_start[num_frames++] = num_nals;
+}
+
+static void add_sps(void)
+{
+	BitWriter bw;
+
+	memset(&bw, 0, sizeof(bw));
+	put_bits(&bw, 66, 8);				/* profile_idc, baseline */
+	put_bits(&bw, 0xc0, 8);				/* constraint_set0/1_flag */
+	put_bits(&bw, 30, 8);				/* level_idc */
+	put_ue(&bw, 0);						/* seq_parameter_set_id */
+	put_ue(&bw, 0);						/* log2_max_frame_num_minus4 */
+	put_ue(&bw, 2);						/* pic_order_cnt_type */
+	put_ue(&bw, 1);						/* num_ref_frames */
+	put_bits(&bw, 0, 1);				/* gaps_in_frame_num_value_allowed_flag */
+	put_ue(&bw, WIDTH_MBS - 1);
+	put_ue(&bw, HEIGHT_MBS - 1);
+	put_bits(&bw, 1, 1);				/* frame_mbs_only_flag */
+	put_bits(&bw, 1, 1);				/* direct_8x8_inference_flag */
+	put_bits(&bw, 0, 1);				/* frame_cropping_flag */
+	put_bits(&bw, 0, 1);				/* vui_parameters_present_flag */
+	put_trailing_bits(&bw);
+	add_nal(NAL_SPS, 3, &bw, 0, 0);
+}
+
+static void add_pps(void)
+{
+	BitWriter bw;
+
+	memset(&bw, 0, sizeof(bw));
+	put_ue(&bw, 0);						/* pic_parameter_set_id */
+	put_ue(&bw, 0);						/* seq_parameter_set_id */
+	put_bits(&bw, 0, 1);				/* entropy_coding_mode_flag */
+	put_bits(&bw, 0, 1);				/* pic_order_present_flag */
+	put_ue(&bw, 0);						/* num_slice_groups_minus1 */
+	put_ue(&bw, 0);						/* num_ref_idx_l0_active_minus1 */
+	put_ue(&bw, 0);						/* num_ref_idx_l1_active_minus1 */
+	put_bits(&bw, 0, 1);				/* weighted_pred_flag */
+	put_bits(&bw, 0, 2);				/* weighted_bipred_idc */
+	put_ue(&bw, 0);						/* pic_init_qp_minus26 */
+	put_ue(&bw, 0);						/* pic_init_qs_minus26 */
+	put_ue(&bw, 0);						/* chroma_qp_index_offset */
+	put_bits(&bw, 1, 1);				/* deblocking_filter_control_present_flag */
+	put_bits(&bw, 0, 1);				/* constrained_intra_pred_flag */
+	put_bits(&bw, 0, 1);				/* redundant_pic_cnt_present_flag */
+	put_trailing_bits(&bw);
+	add_nal(NAL_PPS, 3, &bw, 0, 0);
+}
+
+static void add_recovery_point(void)
+{
+	BitWriter bw;
+
+	memset(&bw, 0, sizeof(bw));
+	put_bits(&bw, 6, 8);				/* payloadType, recovery point */
+	put_bits(&bw, 1, 8);				/* payloadSize */
+	put_ue(&bw, 0);						/* recovery_frame_cnt */
+	put_bits(&bw, 1, 1);				/* exact_match_flag */
+	put_bits(&bw, 0, 1);				/* broken_link_flag */
+	put_bits(&bw, 0, 2);				/* changing_slice_group_idc */
+	put_trailing_bits(&bw);				/* payload byte alignment */
+	put_trailing_bits(&bw);
+	add_nal(NAL_SEI, 0, &bw, 0, 0);
+}
+
+static void add_slice(int idr, uint32 first_mb, uint32 frame_num)
+{
+	BitWriter bw;
+
+	memset(&bw, 0, sizeof(bw));
+	put_ue(&bw, first_mb);
+	put_ue(&bw, idr ? SLICE_I : SLICE_P);
+	put_ue(&bw, 0);						/* pic_parameter_set_id */
+	put_bits(&bw, frame_num, 4);
+	if (idr)
+	{
+		put_ue(&bw, 0);					/* idr_pic_id */
+	}
+	else
+	{
+		put_bits(&bw, 0, 1);			/* num_ref_idx_active_override_flag */
+		put_bits(&bw, 0, 1);			/* ref_pic_list_reordering_flag_l0 */
+	}
+	put_bits(&bw, 0, idr ? 2 : 1);		/* dec_ref_pic_marking */
+	put_ue(&bw, 0);						/* slice_qp_delta */
+	put_ue(&bw, 1);						/* disable_deblocking_filter_idc */
+	/* slice data, the zeros need emulation prevention */
+	put_bits(&bw, 0, 24);
+	put_bits(&bw, first_mb, 16);
+	put_trailing_bits(&bw);
+	add_nal(idr ? NAL_IDR : NAL_SLICE, 3, &bw, 1, first_mb);
+}
+
+static void build_stream(void)
+{
+	uint32 i;
+
+	start_frame();
+	add_sps();
+	add_pps();
+	add_recovery_point();
+	add_slice(1, 0, 0);
+	add_slice(1, 200, 0);
+	add_slice(1, 400, 0);
+
+	start_frame();
+	add_slice(0, 0, 1);
+	add_slice(0, 300, 1);
+
+	start_frame();
+	add_slice(0, 0, 2);
+
+	/* last, so that the frames vbp_parse takes have the same references */
+	start_frame();
+	many_frame = num_frames - 1;
+	for (i = 0; i < MANY_SLICES; i++)
+	{
+		add_slice(0, i, 3);
+	}
+
+	frame_start[num_frames] = num_nals;
+}
+
+static uint32 frame_offset(int frame)
+{
+	return nals[frame_start[frame]].offset;
+}
+
+static uint32 frame_size(int frame)
+{
+	int last = frame_start[frame + 1] - 1;
+
+	return nals[last].offset + nals[last].size - frame_offset(frame);
+}
+
+static int parse_whole(void)
+{
+	Handle hcontext = NULL;
+	vbp_data_h264 *data = NULL;
+	vbp_picture_data_h264 *pic = NULL;
+	uint32 ret;
+	int frame;
+
+	if (vbp_open(VBP_H264, &hcontext) != VBP_OK)
+	{
+		printf("vbp_open failed\n");
+		return 0;
+	}
+
+	for (frame = 0; frame < num_frames; frame++)
+	{
+		Frame *f = &frames[frame];
+
+		/* more slices than a buffer takes */
+		if (frame == many_frame) break;
+
+		ret = vbp_parse(hcontext, stream + frame_offset(frame), frame_size(frame), 0);
+		if (ret == VBP_OK) ret = vbp_query(hcontext, (void **)&data);
+		if (ret != VBP_OK || data->num_pictures != 1)
+		{
+			printf("frame %d: vbp_parse returned %u\n", frame, ret);
+			vbp_close(hcontext);
+			return 0;
+		}
+
+		pic = &data->pic_data[0];
+		f->num_pictures = data->num_pictures;
+		f->num_slices = pic->num_slices;
+		f->idr_flag = pic->idr_flag;
+		f->has_recovery_point = data->has_recovery_point;
+		f->pic_parms = *pic->pic_parms;
+		f->slc_data = malloc(pic->num_slices * sizeof(vbp_slice_data_h264));
+		memcpy(f->slc_data, pic->slc_data, pic->num_slices * sizeof(vbp_slice_data_h264));
+	}
+
+	vbp_close(hcontext);
+	return 1;
+}
+
+static int slices_before(int nal_end, int frame)
+{
+	int i, n = 0;
+
+	for (i = frame_start[frame]; i < nal_end && i < frame_start[frame + 1]; i++)
+	{
+		n += nals[i].is_slice;
+	}
+	return n;
+}
+
+/* slice i of the picture is NAL first of the frame, as vbp_parse sees it */
+static int check_slices(int chunk, int frame, vbp_picture_data_h264 *pic, uint32 num_slices)
+{
+	uint32 i;
+	int first = frame_start[frame];
+
+	while (!nals[first].is_slice) first++;
+
+	for (i = 0; i < num_slices; i++)
+	{
+		const Nal *nal = &nals[first + i];
+		const vbp_slice_data_h264 *slc = &pic->slc_data[i];
+
+		if (slc->buffer_addr + slc->slice_offset != stream + nal->offset + 4 ||
+			slc->slice_size != nal->size - 4 ||
+			slc->slc_parms.first_mb_in_slice != nal->first_mb)
+		{
+			printf("chunk %d frame %d: slice %u at %ld size %u first mb %u, expected %u %u %u\n",
+					chunk, frame, i, (long)(slc->buffer_addr + slc->slice_offset - stream),
+					slc->slice_size, slc->slc_parms.first_mb_in_slice,
+					nal->offset + 4, nal->size - 4, nal->first_mb);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int check_frame(int chunk, int frame, vbp_data_h264 *data)
+{
+	const Frame *f = &frames[frame];
+	vbp_picture_data_h264 *pic = &data->pic_data[0];
+	uint32 i;
+
+	if (frame == many_frame)
+	{
+		if (data->num_pictures != 1 || pic->num_slices != MANY_SLICES)
+		{
+			printf("chunk %d frame %d: %u pictures, %u slices, expected 1, %d\n", chunk, frame,
+					data->num_pictures, data->num_pictures ? pic->num_slices : 0, MANY_SLICES);
+			return 0;
+		}
+		return check_slices(chunk, frame, pic, MANY_SLICES);
+	}
+
+	if (data->num_pictures != f->num_pictures || pic->num_slices != f->num_slices ||
+		pic->idr_flag != f->idr_flag || data->has_recovery_point != f->has_recovery_point)
+	{
+		printf("chunk %d frame %d: %u pictures, %u slices, idr %d, recovery point %d, "
+				"vbp_parse %u, %u, %d, %d\n", chunk, frame, data->num_pictures, pic->num_slices,
+				pic->idr_flag, data->has_recovery_point, f->num_pictures, f->num_slices,
+				f->idr_flag, f->has_recovery_point);
+		return 0;
+	}
+
+	if (memcmp(pic->pic_parms, &f->pic_parms, sizeof(f->pic_parms)) != 0)
+	{
+		printf("chunk %d frame %d: picture parameters differ from vbp_parse\n", chunk, frame);
+		return 0;
+	}
+
+	for (i = 0; i < f->num_slices; i++)
+	{
+		const vbp_slice_data_h264 *slc = &pic->slc_data[i];
+		const vbp_slice_data_h264 *ref = &f->slc_data[i];
+
+		if (slc->buffer_addr + slc->slice_offset != ref->buffer_addr + ref->slice_offset ||
+			slc->slice_size != ref->slice_size ||
+			memcmp(&slc->slc_parms, &ref->slc_parms, sizeof(ref->slc_parms)) != 0)
+		{
+			printf("chunk %d frame %d: slice %u differs from vbp_parse\n", chunk, frame, i);
+			return 0;
+		}
+	}
+	return check_slices(chunk, frame, pic, f->num_slices);
+}
+
+static int parse_partial(int nals_per_chunk)
+{
+	Handle hcontext = NULL;
+	vbp_data_h264 *data = NULL;
+	uint32 ret, consumed, frame_done;
+	uint32 offset, size, expected;
+	int pos = 0, end, frame = 0, chunk = 0, slices;
+	uint8 last, next_frame;
+
+	if (vbp_open(VBP_H264, &hcontext) != VBP_OK)
+	{
+		printf("vbp_open failed\n");
+		return 0;
+	}
+
+	while (pos < num_nals)
+	{
+		end = (pos + nals_per_chunk < num_nals) ? pos + nals_per_chunk : num_nals;
+		last = (end == num_nals);
+		offset = nals[pos].offset;
+		size = nals[end - 1].offset + nals[end - 1].size - offset;
+
+		ret = vbp_parse_partial(hcontext, stream + offset, size, last, &consumed);
+		if (ret != VBP_OK && ret != VBP_DONE)
+		{
+			printf("%d NALs a chunk, chunk %d: vbp_parse_partial returned %u\n",
+					nals_per_chunk, chunk, ret);
+			break;
+		}
+
+		/* the chunk up to the next frame is parsed */
+		next_frame = (frame + 1 < num_frames && frame_start[frame + 1] < end);
+		if (next_frame)
+		{
+			end = frame_start[frame + 1];
+			expected = (end > pos) ? nals[end].offset - offset : 0;
+			if (ret != VBP_DONE || consumed != expected)
+			{
+				printf("%d NALs a chunk, chunk %d: returned %u, consumed %u, expected %u up to frame %d\n",
+						nals_per_chunk, chunk, ret, consumed, expected, frame + 1);
+				break;
+			}
+		}
+		else if (consumed != size || ret != (last ? VBP_DONE : VBP_OK))
+		{
+			printf("%d NALs a chunk, chunk %d: returned %u, consumed %u of %u, last %d\n",
+					nals_per_chunk, chunk, ret, consumed, size, last);
+			break;
+		}
+
+		ret = vbp_query_incremental(hcontext, (void **)&data, &frame_done);
+		if (ret != VBP_OK || frame_done != (next_frame || last))
+		{
+			printf("%d NALs a chunk, chunk %d: query returned %u, frame_done %u\n",
+					nals_per_chunk, chunk, ret, frame_done);
+			break;
+		}
+
+		if (frame_done)
+		{
+			if (!check_frame(chunk, frame, data)) break;
+			frame++;
+		}
+		else
+		{
+			/* no dummy picture until the first slice */
+			slices = slices_before(end, frame);
+			if (data->num_pictures != (slices ? 1 : 0) ||
+				(slices && data->pic_data[0].num_slices != (uint32)slices))
+			{
+				printf("%d NALs a chunk, chunk %d frame %d: %u pictures, %u slices, expected %d slices\n",
+						nals_per_chunk, chunk, frame, data->num_pictures,
+						data->num_pictures ? data->pic_data[0].num_slices : 0, slices);
+				break;
+			}
+			if (slices && !check_slices(chunk, frame, &data->pic_data[0], slices)) break;
+		}
+
+		pos = end;
+		chunk++;
+	}
+
+	vbp_close(hcontext);
+
+	if (frame != num_frames)
+	{
+		printf("%d NALs a chunk: %d of %d frames\n", nals_per_chunk, frame, num_frames);
+		return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int n;
+
+	build_stream();
+
+	if (!parse_whole())
+	{
+		printf("FAIL\n");
+		return 1;
+	}
+
+	for (n = 1; n <= 3; n++)
+	{
+		if (!parse_partial(n))
+		{
+			printf("FAIL\n");
+			return 1;
+		}
+	}
+
+	printf("PASS\n");
+	return 0;
+}
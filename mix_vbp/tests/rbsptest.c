@@ -0,0 +1,255 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+ */
+
+
+
+/*
+ * Cross-checks the host RBSP reader against the byte engine of
+ * viddec_pm_utils_bstream. Random NAL payloads, dense in 0x00 and 0x03 so
+ * that emulation prevention sequences are frequent, are read by both
+ * engines with the same random sequence of peeks and skips. After every
+ * step the values, the au offsets, is_emul, the current byte and
+ * nomorerbspdata must agree, and emulation_byte_counter must count the
+ * emulation prevention bytes before the current position. The ue(v) fast
+ * path is checked on a known bit string.
+ *
+ * usage: rbsptest [iterations] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "viddec_pm_utils_bstream.h"
+
+#define MAX_NAL_SIZE	600
+#define MAX_STEPS	400
+
+static uint8_t data[MAX_NAL_SIZE + 64];
+static viddec_pm_utils_list_t list;
+
+/* byte engine over data[0..size-1], as set up for one NAL by vbp_utils */
+static void setup_byte_engine(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t size)
+{
+	memset(cxt, 0, sizeof(*cxt));
+	viddec_pm_utils_bstream_init(cxt, &list, 1);
+	cxt->bstrm_buf.buf = data;
+	cxt->bstrm_buf.buf_index = 0;
+	cxt->bstrm_buf.buf_st = 0;
+	cxt->bstrm_buf.buf_end = size;
+	list.total_bytes = size;
+}
+
+/* RBSP engine over the same bytes, its scratch buffers are reused across NALs */
+static void setup_rbsp_engine(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t size)
+{
+	viddec_pm_utils_bstream_rbsp_cxt_t rbsp = cxt->rbsp;
+
+	memset(cxt, 0, sizeof(*cxt));
+	cxt->rbsp = rbsp;
+	viddec_pm_utils_bstream_init(cxt, &list, 1);
+	cxt->bstrm_buf.buf = data;
+	cxt->bstrm_buf.buf_end = size;
+	viddec_pm_utils_bstream_rbsp_init(cxt, data, size);
+}
+
+/* emulation prevention bytes in data[0..end-1] */
+static uint32_t count_emulation_bytes(uint32_t end)
+{
+	uint32_t zeros = 0, count = 0, i = 0;
+
+	for (i = 0; i < end; i++)
+	{
+		if (zeros >= 2 && data[i] == 0x03)
+		{
+			count++;
+			zeros = 0;
+		}
+		else
+		{
+			zeros = (data[i] == 0) ? zeros + 1 : 0;
+		}
+	}
+	return count;
+}
+
+static int compare_state(viddec_pm_utils_bstream_cxt_t *a, viddec_pm_utils_bstream_cxt_t *b,
+	int iter, int step)
+{
+	uint32_t bit_a = 0, byte_a = 0, bit_b = 0, byte_b = 0;
+	uint8_t emul_a = 0, emul_b = 0;
+	uint8_t cur_a = 0, cur_b = 0;
+	int32_t ret_a = 0, ret_b = 0;
+
+	viddec_pm_utils_bstream_get_au_offsets(a, &bit_a, &byte_a, &emul_a);
+	viddec_pm_utils_bstream_get_au_offsets(b, &bit_b, &byte_b, &emul_b);
+	if (bit_a != bit_b || byte_a != byte_b || emul_a != emul_b)
+	{
+		printf("iter %d step %d: au offset %u.%u emul %d, rbsp %u.%u emul %d\n",
+			iter, step, byte_a, bit_a, emul_a, byte_b, bit_b, emul_b);
+		return 0;
+	}
+
+	/* the byte engine only tracks the bytes of its last read, so check against a scan */
+	if (b->emulation_byte_counter != count_emulation_bytes(byte_b))
+	{
+		printf("iter %d step %d: emulation_byte_counter %u, expected %u at %u.%u\n",
+			iter, step, b->emulation_byte_counter, count_emulation_bytes(byte_b), byte_b, bit_b);
+		return 0;
+	}
+
+	if (viddec_pm_utils_bstream_nomorerbspdata(a) != viddec_pm_utils_bstream_nomorerbspdata(b))
+	{
+		printf("iter %d step %d: nomorerbspdata differs at %u.%u\n", iter, step, byte_a, bit_a);
+		return 0;
+	}
+
+	ret_a = viddec_pm_utils_bstream_get_current_byte(a, &cur_a);
+	ret_b = viddec_pm_utils_bstream_get_current_byte(b, &cur_b);
+	if (ret_a != ret_b || (ret_a == 1 && cur_a != cur_b))
+	{
+		printf("iter %d step %d: current byte %d/%02x, rbsp %d/%02x at %u.%u\n",
+			iter, step, ret_a, cur_a, ret_b, cur_b, byte_a, bit_a);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int test_random(int iterations)
+{
+	viddec_pm_utils_bstream_cxt_t a, b;
+	long checks = 0;
+	int iter = 0;
+
+	memset(&b, 0, sizeof(b));
+
+	for (iter = 0; iter < iterations; iter++)
+	{
+		uint32_t size = 1 + rand() % MAX_NAL_SIZE;
+		uint32_t i = 0;
+		int step = 0;
+
+		for (i = 0; i < size; i++)
+		{
+			int r = rand() % 10;
+			data[i] = (r < 4) ? 0 : (r < 6) ? 3 : (rand() & 0xff);
+		}
+		memset(data + size, 0, sizeof(data) - size);
+
+		setup_byte_engine(&a, size);
+		setup_rbsp_engine(&b, size);
+
+		for (step = 0; step < MAX_STEPS; step++)
+		{
+			uint32_t num_bits = 1 + rand() % 32;
+			uint32_t val_a = 0, val_b = 0;
+			int32_t ret_a = 0, ret_b = 0;
+			int op = rand() % 3;
+
+			if (!compare_state(&a, &b, iter, step))
+			{
+				viddec_pm_utils_bstream_rbsp_free(&b);
+				return 0;
+			}
+
+			if (op == 2)
+			{
+				ret_a = viddec_pm_utils_bstream_skipbits(&a, num_bits);
+				ret_b = viddec_pm_utils_bstream_skipbits(&b, num_bits);
+			}
+			else
+			{
+				/* op 0 reads, op 1 peeks */
+				ret_a = viddec_pm_utils_bstream_peekbits(&a, &val_a, num_bits, op == 0);
+				ret_b = viddec_pm_utils_bstream_peekbits(&b, &val_b, num_bits, op == 0);
+			}
+
+			if (ret_a != ret_b || val_a != val_b)
+			{
+				printf("iter %d step %d: op %d of %u bits returned %d/%x, rbsp %d/%x\n",
+					iter, step, op, num_bits, ret_a, val_a, ret_b, val_b);
+				viddec_pm_utils_bstream_rbsp_free(&b);
+				return 0;
+			}
+			if (ret_a == -1)
+			{
+				/* end of the NAL */
+				break;
+			}
+			checks++;
+		}
+	}
+
+	viddec_pm_utils_bstream_rbsp_free(&b);
+	printf("random: %ld reads matched\n", checks);
+	return 1;
+}
+
+static int test_ue(void)
+{
+	/* ue(v) codes of 0..9: 1 010 011 00100 00101 00110 00111 0001000 0001001 0001010,
+	   then 65535 (16 zeros, 1, 16 zeros) with an emulation prevention byte after the zeros */
+	static const uint8_t bits[] = { 0xA6, 0x42, 0x98, 0xE2, 0x04, 0x8A, 0x00, 0x00, 0x03, 0x80, 0x00, 0x00 };
+	viddec_pm_utils_bstream_cxt_t cxt;
+	uint32_t codenum = 0;
+	uint32_t i = 0;
+	int ok = 1;
+
+	memset(data, 0, sizeof(data));
+	memcpy(data, bits, sizeof(bits));
+	memset(&cxt, 0, sizeof(cxt));
+	setup_rbsp_engine(&cxt, sizeof(bits));
+
+	for (i = 0; i < 10; i++)
+	{
+		if (viddec_pm_utils_bstream_get_ue(&cxt, &codenum) != 1 || codenum != i)
+		{
+			printf("ue: code %u decoded as %u\n", i, codenum);
+			ok = 0;
+			break;
+		}
+	}
+
+	if (ok && (viddec_pm_utils_bstream_get_ue(&cxt, &codenum) != 1 || codenum != 65535))
+	{
+		printf("ue: code across the emulation prevention byte decoded as %u\n", codenum);
+		ok = 0;
+	}
+
+	viddec_pm_utils_bstream_rbsp_free(&cxt);
+
+	/* the byte engine has no fast path */
+	setup_byte_engine(&cxt, sizeof(bits));
+	if (ok && viddec_pm_utils_bstream_get_ue(&cxt, &codenum) != 0)
+	{
+		printf("ue: fast path taken without the RBSP engine\n");
+		ok = 0;
+	}
+
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 20000;
+	unsigned int seed = 1;
+
+	if (argc > 1) iterations = atoi(argv[1]);
+	if (argc > 2) seed = (unsigned int) strtoul(argv[2], NULL, 0);
+
+	srand(seed);
+
+	if (!test_random(iterations) || !test_ue())
+	{
+		printf("FAIL (seed %u)\n", seed);
+		return 1;
+	}
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,682 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+ */
+
+
+
+/*
+ * Measures parser throughput of libmixvbp over a corpus of elementary
+ * streams (e.g. the conformance bitstreams of each codec).
+ *
+ * Each stream is split into pictures the way a demuxer would hand them
+ * to the decoder and fed through vbp_parse/vbp_query:
+ *   h264   Annex B, repacked as 4-byte length prefixed samples with an
+ *          AVCDecoderConfigurationRecord built from the first SPS/PPS
+ *   vc1    advanced profile with start codes, headers before the first
+ *          frame are the configuration data
+ *   mpeg4  MPEG-4 part 2, headers before the first VOP are the
+ *          configuration data
+ *   h263   short video header, one sample per picture start code
+ *   mpeg2  headers before the first picture are the configuration data
+ * Only the parse and query calls are timed. The time is split into start
+ * code scan, syntax parse and query data population with the library's
+ * VBP_OPTION_STATISTICS. Allocations made through glib during those
+ * calls are counted where glib still honours g_mem_set_vtable.
+ *
+ * usage: vbpbench [-n iterations] [-j] [-c codec] stream [[-c codec] stream ...]
+ *   -n  number of times each stream is parsed, default 10
+ *   -j  JSON report on stdout
+ *   -c  codec of the streams that follow, otherwise taken from the extension
+ *
+ * The parser libraries are dlopen()ed by vbp_open, so run from the build
+ * tree with LD_LIBRARY_PATH pointing at viddec_fw/fw/parser/.libs. Build
+ * once as is and once with CFLAGS=-DH264_FW_PRIMITIVES to compare the host
+ * and the firmware arithmetic/memory helpers of the H.264 parser.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "vbp_loader.h"
+
+#define NAL_SEI		6
+#define NAL_SPS		7
+#define NAL_PPS		8
+#define NAL_AUD		9
+
+typedef enum {
+	BENCH_UNIT_OTHER,		/* belongs to the current sample */
+	BENCH_UNIT_HEADER,		/* starts a sample if the current one has a picture */
+	BENCH_UNIT_PICTURE		/* picture header */
+} BenchUnit;
+
+typedef struct {
+	const guint8 *data;
+	guint32 size;
+} BenchNal;
+
+typedef struct {
+	guint8 *config;
+	guint32 config_size;
+	GPtrArray *samples;	/* GByteArray per picture or access unit */
+	guint64 bytes;
+} BenchStream;
+
+typedef struct {
+	const gchar *name;
+	guint32 parser_type;
+	gboolean (*load)(const guint8 *buf, gsize size, BenchStream *stream);
+	const gchar *extensions;	/* space separated */
+} BenchCodec;
+
+typedef struct {
+	gdouble elapsed;
+	guint pictures;
+	guint64 allocs;
+	vbp_statistics stats;
+} BenchResult;
+
+static gboolean bench_counting = FALSE;
+static guint64 bench_allocs = 0;
+
+static gpointer bench_malloc(gsize n) {
+	if (bench_counting)
+		bench_allocs++;
+	return malloc(n);
+}
+
+static gpointer bench_realloc(gpointer mem, gsize n) {
+	if (bench_counting)
+		bench_allocs++;
+	return realloc(mem, n);
+}
+
+static void bench_free(gpointer mem) {
+	free(mem);
+}
+
+static GMemVTable bench_vtable = {
+	bench_malloc, bench_realloc, bench_free, NULL, NULL, NULL
+};
+
+/* start code delimited units, the 00 00 01 prefix is part of each unit */
+static GArray *bench_split_units(const guint8 *buf, gsize size) {
+
+	GArray *units = g_array_new(FALSE, FALSE, sizeof(BenchNal));
+	gsize i = 0, start = 0;
+	gboolean in_unit = FALSE;
+
+	while (i + 3 <= size) {
+		if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1) {
+			if (in_unit) {
+				BenchNal unit;
+				unit.data = buf + start;
+				unit.size = i - start;
+				g_array_append_val(units, unit);
+			}
+			start = i;
+			in_unit = TRUE;
+			i += 3;
+		} else {
+			i++;
+		}
+	}
+
+	if (in_unit && size > start) {
+		BenchNal unit;
+		unit.data = buf + start;
+		unit.size = size - start;
+		g_array_append_val(units, unit);
+	}
+
+	return units;
+}
+
+static GArray *bench_split_nals(const guint8 *buf, gsize size) {
+
+	GArray *nals = bench_split_units(buf, size);
+	guint i = 0;
+
+	/* drop the prefix, and the trailing zero of a 4-byte start code that
+	 * belongs to the next NAL */
+	for (i = 0; i < nals->len; i++) {
+		BenchNal *nal = &g_array_index(nals, BenchNal, i);
+		nal->data += 3;
+		nal->size -= 3;
+		while (nal->size > 0 && nal->data[nal->size - 1] == 0)
+			nal->size--;
+		if (nal->size == 0)
+			g_array_remove_index(nals, i--);
+	}
+
+	return nals;
+}
+
+static gboolean bench_is_vcl(guint8 type) {
+	return type >= 1 && type <= 5;
+}
+
+static void bench_append_nal(GByteArray *sample, const BenchNal *nal) {
+
+	guint8 len[4];
+
+	len[0] = (nal->size >> 24) & 0xff;
+	len[1] = (nal->size >> 16) & 0xff;
+	len[2] = (nal->size >> 8) & 0xff;
+	len[3] = nal->size & 0xff;
+	g_byte_array_append(sample, len, 4);
+	g_byte_array_append(sample, nal->data, nal->size);
+}
+
+static guint8 *bench_build_config(const BenchNal *sps, const BenchNal *pps,
+		guint32 *size) {
+
+	guint8 *cfg = NULL;
+	guint8 *p = NULL;
+
+	/* the profile and level come from the SPS, the lengths are 16 bits */
+	if (sps->size < 4 || sps->size > 0xffff || pps->size > 0xffff)
+		return NULL;
+
+	cfg = g_malloc(11 + sps->size + pps->size);
+	p = cfg;
+
+	*p++ = 1;				/* configurationVersion */
+	*p++ = sps->data[1];	/* AVCProfileIndication */
+	*p++ = sps->data[2];	/* profile_compatibility */
+	*p++ = sps->data[3];	/* AVCLevelIndication */
+	*p++ = 0xff;			/* lengthSizeMinusOne = 3 */
+	*p++ = 0xe1;			/* one SPS */
+	*p++ = (sps->size >> 8) & 0xff;
+	*p++ = sps->size & 0xff;
+	memcpy(p, sps->data, sps->size);
+	p += sps->size;
+	*p++ = 1;				/* one PPS */
+	*p++ = (pps->size >> 8) & 0xff;
+	*p++ = pps->size & 0xff;
+	memcpy(p, pps->data, pps->size);
+	p += pps->size;
+
+	*size = p - cfg;
+	return cfg;
+}
+
+static gboolean bench_load_h264(const guint8 *buf, gsize size,
+		BenchStream *stream) {
+
+	GArray *nals = NULL;
+	GByteArray *sample = NULL;
+	BenchNal *sps = NULL, *pps = NULL;
+	gboolean prev_vcl = FALSE;
+	guint i = 0;
+
+	nals = bench_split_nals(buf, size);
+
+	for (i = 0; i < nals->len; i++) {
+
+		BenchNal *nal = &g_array_index(nals, BenchNal, i);
+		guint8 type = nal->data[0] & 0x1f;
+		gboolean new_au = FALSE;
+
+		if (type == NAL_SPS && !sps && nal->size >= 4)
+			sps = nal;
+		if (type == NAL_PPS && !pps)
+			pps = nal;
+
+		/* an access unit starts at the first non-VCL NAL after a picture, or at
+		 * a slice with first_mb_in_slice == 0 (ue(v) code '1') */
+		if (prev_vcl) {
+			if (!bench_is_vcl(type))
+				new_au = (type == NAL_AUD || type == NAL_SEI ||
+						type == NAL_SPS || type == NAL_PPS);
+			else
+				new_au = nal->size > 1 && (nal->data[1] & 0x80);
+		}
+
+		if (new_au || !sample) {
+			sample = g_byte_array_new();
+			g_ptr_array_add(stream->samples, sample);
+		}
+
+		bench_append_nal(sample, nal);
+		stream->bytes += nal->size;
+		prev_vcl = bench_is_vcl(type);
+	}
+
+	if (sps && pps)
+		stream->config = bench_build_config(sps, pps, &stream->config_size);
+
+	g_array_free(nals, TRUE);
+	return stream->config != NULL;
+}
+
+static BenchUnit bench_classify_vc1(guint8 code) {
+	switch (code) {
+	case 0x0F:	/* sequence header */
+	case 0x0E:	/* entry point */
+		return BENCH_UNIT_HEADER;
+	case 0x0D:	/* frame */
+		return BENCH_UNIT_PICTURE;
+	default:	/* field, slice, user data */
+		return BENCH_UNIT_OTHER;
+	}
+}
+
+static BenchUnit bench_classify_mpeg4(guint8 code) {
+	if (code == 0xB6)	/* VOP */
+		return BENCH_UNIT_PICTURE;
+	if (code <= 0x2F || code == 0xB0 || code == 0xB3 || code == 0xB5)
+		return BENCH_UNIT_HEADER;	/* VO, VOL, VOS, GOV, VO header */
+	return BENCH_UNIT_OTHER;
+}
+
+static BenchUnit bench_classify_mpeg2(guint8 code) {
+	if (code == 0x00)	/* picture */
+		return BENCH_UNIT_PICTURE;
+	if (code == 0xB3 || code == 0xB8)	/* sequence, GOP */
+		return BENCH_UNIT_HEADER;
+	return BENCH_UNIT_OTHER;	/* slices, extensions, user data */
+}
+
+/* group start code units into configuration data and one sample per picture */
+static gboolean bench_load_units(const guint8 *buf, gsize size,
+		BenchStream *stream, BenchUnit (*classify)(guint8 code)) {
+
+	GArray *units = bench_split_units(buf, size);
+	GByteArray *config = g_byte_array_new();
+	GByteArray *sample = NULL;
+	gboolean has_picture = FALSE;
+	guint i = 0;
+
+	for (i = 0; i < units->len; i++) {
+
+		BenchNal *unit = &g_array_index(units, BenchNal, i);
+		BenchUnit kind = unit->size > 3 ? classify(unit->data[3]) : BENCH_UNIT_OTHER;
+
+		if (!sample && kind != BENCH_UNIT_PICTURE) {
+			g_byte_array_append(config, unit->data, unit->size);
+			continue;
+		}
+
+		if (!sample || (kind != BENCH_UNIT_OTHER && has_picture)) {
+			sample = g_byte_array_new();
+			g_ptr_array_add(stream->samples, sample);
+			has_picture = FALSE;
+		}
+
+		g_byte_array_append(sample, unit->data, unit->size);
+		stream->bytes += unit->size;
+		has_picture |= (kind == BENCH_UNIT_PICTURE);
+	}
+
+	g_array_free(units, TRUE);
+
+	stream->config_size = config->len;
+	stream->config = (guint8 *) g_byte_array_free(config, FALSE);
+	return stream->samples->len > 0;
+}
+
+static gboolean bench_load_vc1(const guint8 *buf, gsize size,
+		BenchStream *stream) {
+	return bench_load_units(buf, size, stream, bench_classify_vc1) &&
+			stream->config_size > 0;
+}
+
+static gboolean bench_load_mpeg4(const guint8 *buf, gsize size,
+		BenchStream *stream) {
+	return bench_load_units(buf, size, stream, bench_classify_mpeg4) &&
+			stream->config_size > 0;
+}
+
+static gboolean bench_load_mpeg2(const guint8 *buf, gsize size,
+		BenchStream *stream) {
+	return bench_load_units(buf, size, stream, bench_classify_mpeg2) &&
+			stream->config_size > 0;
+}
+
+/* short video header: 22-bit picture start code 0000 0000 0000 0000 1000 00 */
+static gboolean bench_load_h263(const guint8 *buf, gsize size,
+		BenchStream *stream) {
+
+	gsize i = 0, start = 0;
+	gboolean in_picture = FALSE;
+
+	for (i = 0; i + 3 <= size; i++) {
+		if (buf[i] == 0 && buf[i + 1] == 0 && (buf[i + 2] & 0xFC) == 0x80) {
+			if (in_picture) {
+				GByteArray *sample = g_byte_array_new();
+				g_byte_array_append(sample, buf + start, i - start);
+				g_ptr_array_add(stream->samples, sample);
+				stream->bytes += i - start;
+			}
+			start = i;
+			in_picture = TRUE;
+			i += 2;
+		}
+	}
+
+	if (in_picture && size > start) {
+		GByteArray *sample = g_byte_array_new();
+		g_byte_array_append(sample, buf + start, size - start);
+		g_ptr_array_add(stream->samples, sample);
+		stream->bytes += size - start;
+	}
+
+	return stream->samples->len > 0;
+}
+
+static const BenchCodec bench_codecs[] = {
+	{ "h264", VBP_H264, bench_load_h264, "264 h264 jsv avc 26l jvt" },
+	{ "vc1", VBP_VC1, bench_load_vc1, "vc1" },
+	{ "mpeg4", VBP_MPEG4, bench_load_mpeg4, "m4v mp4v cmp bits" },
+	{ "h263", VBP_MPEG4, bench_load_h263, "263 h263" },
+	{ "mpeg2", VBP_MPEG2, bench_load_mpeg2, "m2v mpv mpg2" },
+};
+
+#define BENCH_NUM_CODECS (sizeof(bench_codecs) / sizeof(bench_codecs[0]))
+
+static const BenchCodec *bench_find_codec(const gchar *name) {
+
+	guint i = 0;
+
+	for (i = 0; i < BENCH_NUM_CODECS; i++) {
+		if (g_ascii_strcasecmp(bench_codecs[i].name, name) == 0)
+			return &bench_codecs[i];
+	}
+	return NULL;
+}
+
+static const BenchCodec *bench_codec_from_path(const gchar *path) {
+
+	const gchar *ext = strrchr(path, '.');
+	guint i = 0, j = 0;
+
+	if (!ext)
+		return NULL;
+	ext++;
+
+	for (i = 0; i < BENCH_NUM_CODECS; i++) {
+		gchar **exts = g_strsplit(bench_codecs[i].extensions, " ", 0);
+		gboolean found = FALSE;
+
+		for (j = 0; exts[j] && !found; j++)
+			found = g_ascii_strcasecmp(exts[j], ext) == 0;
+		g_strfreev(exts);
+		if (found)
+			return &bench_codecs[i];
+	}
+	return NULL;
+}
+
+static void bench_free_stream(BenchStream *stream) {
+
+	guint i = 0;
+
+	if (stream->samples) {
+		for (i = 0; i < stream->samples->len; i++)
+			g_byte_array_free(g_ptr_array_index(stream->samples, i), TRUE);
+		g_ptr_array_free(stream->samples, TRUE);
+	}
+	g_free(stream->config);
+}
+
+static guint bench_num_pictures(const BenchCodec *codec, void *data) {
+
+	switch (codec->parser_type) {
+	case VBP_H264:
+		return ((vbp_data_h264 *) data)->num_pictures;
+	case VBP_VC1:
+		return ((vbp_data_vc1 *) data)->num_pictures;
+	case VBP_MPEG4:
+		return ((vbp_data_mp42 *) data)->number_pictures;
+	default:
+		return 0;
+	}
+}
+
+static guint32 bench_parse(Handle hcontext, const BenchCodec *codec,
+		guint8 *buf, guint32 size, guint8 init, guint *pictures) {
+
+	void *data = NULL;
+	guint32 ret = VBP_OK;
+
+	bench_counting = TRUE;
+	ret = vbp_parse(hcontext, buf, size, init);
+	if (ret == VBP_OK)
+		ret = vbp_query(hcontext, &data);
+	bench_counting = FALSE;
+
+	if (ret == VBP_OK && !init)
+		*pictures += bench_num_pictures(codec, data);
+	return ret;
+}
+
+static guint32 bench_run(const BenchCodec *codec, BenchStream *stream,
+		BenchResult *result) {
+
+	Handle hcontext = NULL;
+	GTimer *timer = NULL;
+	vbp_statistics stats;
+	guint32 ret = VBP_OK;
+	guint i = 0;
+
+	ret = vbp_open(codec->parser_type, &hcontext);
+	if (ret != VBP_OK)
+		return ret;
+
+	vbp_set_option(hcontext, VBP_OPTION_STATISTICS, 1);
+	timer = g_timer_new();
+
+	if (stream->config_size > 0)
+		ret = bench_parse(hcontext, codec, stream->config,
+				stream->config_size, TRUE, &result->pictures);
+
+	for (i = 0; ret == VBP_OK && i < stream->samples->len; i++) {
+		GByteArray *sample = g_ptr_array_index(stream->samples, i);
+		ret = bench_parse(hcontext, codec, sample->data, sample->len, FALSE,
+				&result->pictures);
+	}
+
+	result->elapsed += g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	if (vbp_get_statistics(hcontext, &stats) == VBP_OK) {
+		result->stats.buffers += stats.buffers;
+		result->stats.units += stats.units;
+		result->stats.scan_time += stats.scan_time;
+		result->stats.parse_time += stats.parse_time;
+		result->stats.query_time += stats.query_time;
+	}
+	vbp_close(hcontext);
+
+	if (ret != VBP_OK)
+		fprintf(stderr, "parse failed at sample %u: %u\n", i, ret);
+	return ret;
+}
+
+static void bench_json_string(const gchar *s) {
+
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((guchar) *s < 0x20)
+			printf("\\u%04x", (guchar) *s);
+		else
+			putchar(*s);
+	}
+	putchar('"');
+}
+
+static void bench_report(const gchar *file, const gchar *codec,
+		const gchar *status, guint64 bytes, const BenchResult *r,
+		gint iterations, gboolean count_allocs, gboolean json, gboolean first) {
+
+	gdouble mbytes = r->elapsed > 0 ?
+			bytes * iterations / r->elapsed / (1024 * 1024) : 0;
+	gdouble pictures_s = r->elapsed > 0 ? r->pictures / r->elapsed : 0;
+	gdouble units_s = r->elapsed > 0 ? r->stats.units / r->elapsed : 0;
+	gdouble allocs = r->pictures > 0 ? (gdouble) r->allocs / r->pictures : 0;
+
+	if (!json) {
+		if (strcmp(status, "ok") != 0) {
+			fprintf(stderr, "%-40s %-6s %s\n", file, codec, status);
+			return;
+		}
+		fprintf(stderr, "%-40s %-6s %6u pictures %9.1f pictures/s %8.2f MB/s "
+				"%10.1f units/s  scan %.3f parse %.3f query %.3f ms/picture",
+				file, codec, r->pictures / iterations, pictures_s, mbytes, units_s,
+				r->pictures ? r->stats.scan_time * 1000 / r->pictures : 0,
+				r->pictures ? r->stats.parse_time * 1000 / r->pictures : 0,
+				r->pictures ? r->stats.query_time * 1000 / r->pictures : 0);
+		if (count_allocs)
+			fprintf(stderr, "  %.2f allocs/picture", allocs);
+		fprintf(stderr, "\n");
+		return;
+	}
+
+	printf("%s\n    {\"file\": ", first ? "" : ",");
+	bench_json_string(file);
+	printf(", \"codec\": \"%s\", \"status\": \"%s\"", codec, status);
+	if (strcmp(status, "ok") == 0) {
+		printf(", \"bytes\": %" G_GUINT64_FORMAT ", \"pictures\": %u, \"units\": %u",
+				bytes, r->pictures / iterations, r->stats.units / iterations);
+		printf(", \"seconds\": %.6f, \"pictures_per_s\": %.1f, \"mbytes_per_s\": %.3f"
+				", \"units_per_s\": %.1f", r->elapsed, pictures_s, mbytes, units_s);
+		printf(", \"scan_s\": %.6f, \"parse_s\": %.6f, \"query_s\": %.6f",
+				r->stats.scan_time, r->stats.parse_time, r->stats.query_time);
+		if (count_allocs)
+			printf(", \"allocs_per_picture\": %.3f", allocs);
+		else
+			printf(", \"allocs_per_picture\": null");
+	}
+	printf("}");
+}
+
+int main(int argc, char *argv[]) {
+
+	gint iterations = 10;
+	gboolean json = FALSE, count_allocs = FALSE, first = TRUE;
+	const BenchCodec *forced = NULL;
+	BenchResult total;
+	guint64 total_bytes = 0;
+	gint i = 0, n = 0, streams = 0;
+	gpointer probe = NULL;
+
+	/* must come before any glib allocation, ignored by newer glib */
+	g_mem_set_vtable(&bench_vtable);
+	bench_counting = TRUE;
+	probe = g_malloc(1);
+	count_allocs = bench_allocs > 0;
+	bench_counting = FALSE;
+	g_free(probe);
+
+	memset(&total, 0, sizeof(total));
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+			i++;
+		else if (strcmp(argv[i], "-j") == 0)
+			json = TRUE;
+		else
+			streams++;
+	}
+
+	if (streams == 0 || iterations <= 0) {
+		fprintf(stderr, "usage: %s [-n iterations] [-j] [-c h264|vc1|mpeg4|h263|mpeg2] "
+				"stream [[-c codec] stream ...]\n", argv[0]);
+		return 1;
+	}
+
+	if (json)
+		printf("{\n  \"iterations\": %d,\n  \"streams\": [", iterations);
+
+	for (i = 1; i < argc; i++) {
+
+		BenchStream stream;
+		BenchResult result;
+		const BenchCodec *codec = forced;
+		const gchar *status = "ok";
+		guint8 *file = NULL;
+		gsize size = 0;
+		guint32 ret = VBP_OK;
+
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			i++;
+			continue;
+		}
+		if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			forced = bench_find_codec(argv[++i]);
+			if (!forced) {
+				fprintf(stderr, "unknown codec %s\n", argv[i]);
+				return 1;
+			}
+			continue;
+		}
+		if (strcmp(argv[i], "-j") == 0)
+			continue;
+
+		memset(&stream, 0, sizeof(stream));
+		memset(&result, 0, sizeof(result));
+		bench_allocs = 0;
+
+		if (!codec)
+			codec = bench_codec_from_path(argv[i]);
+
+		if (!codec) {
+			status = "unknown codec";
+		} else if (!g_file_get_contents(argv[i], (gchar **) &file, &size, NULL)) {
+			status = "cannot read";
+		} else {
+			stream.samples = g_ptr_array_new();
+			if (!codec->load(file, size, &stream))
+				status = "no pictures or configuration data";
+		}
+
+		for (n = 0; strcmp(status, "ok") == 0 && n < iterations; n++) {
+			ret = bench_run(codec, &stream, &result);
+			if (ret == VBP_TYPE || ret == VBP_LOAD)
+				status = "not supported by libmixvbp";
+			else if (ret != VBP_OK)
+				status = "parse error";
+		}
+		result.allocs = bench_allocs;
+
+		bench_report(argv[i], codec ? codec->name : "?", status, stream.bytes,
+				&result, iterations, count_allocs, json, first);
+		first = FALSE;
+
+		if (strcmp(status, "ok") == 0) {
+			total.elapsed += result.elapsed;
+			total.pictures += result.pictures;
+			total.allocs += result.allocs;
+			total.stats.units += result.stats.units;
+			total.stats.scan_time += result.stats.scan_time;
+			total.stats.parse_time += result.stats.parse_time;
+			total.stats.query_time += result.stats.query_time;
+			total_bytes += stream.bytes;
+		}
+
+		bench_free_stream(&stream);
+		g_free(file);
+	}
+
+	if (json) {
+		printf("\n  ],\n  \"total\":");
+		bench_report("total", "all", "ok", total_bytes, &total, iterations,
+				count_allocs, TRUE, TRUE);
+		printf("\n}\n");
+	} else if (total.elapsed > 0) {
+		bench_report("total", "all", "ok", total_bytes, &total, iterations,
+				count_allocs, FALSE, TRUE);
+	}
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+ */
+
+
+
+/*
+ * Cross-checks the word at a time VC-1 bitplane code against the bit by
+ * bit implementations kept under VC1_BITPLANE_CHECK and
+ * VBP_CHECK_BITPLANE_VC1, on random planes from 1x1 to 130x70 MBs:
+ *   put_bits            ROWSKIP rows and NORM6 residual rows, against put_bit
+ *   vc1_InvertBitplane  against xor_bit on every MB
+ *   vc1_InverseDiff     against vc1_InverseDiff_ref, invert 0 and 1
+ *   vbp_pack_bitplane   against vbp_pack_bitplane_ref_vc1, every nibble bit
+ * The sources are included so that their static functions can be called,
+ * vbp_vc1_parser.c from vc1bitplanetest_pack.c as it needs <string.h>.
+ *
+ * usage: vc1bitplanetest [iterations] [seed]
+ */
+
+#define VC1_BITPLANE_CHECK
+
+#include "vc1parse_bitplane.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_WIDTH	130
+#define MAX_HEIGHT	70
+#define MAX_STRIDE	((MAX_WIDTH + 31) / 32)
+#define MAX_DWORDS	(MAX_STRIDE * MAX_HEIGHT + 1)
+#define MAX_BITS	(MAX_WIDTH * MAX_HEIGHT + MAX_HEIGHT)
+
+static uint8_t bits[MAX_BITS / 8 + 64];
+
+/* in vc1bitplanetest_pack.c */
+extern int test_pack(int iter, uint32_t *planes[4], uint32_t width, uint32_t height);
+
+/* random plane with the padding bits at the end of each row left clear */
+static void random_plane(uint32_t *plane, uint32_t width, uint32_t height)
+{
+	uint32_t stride = (width + 31) / 32;
+	uint32_t i, k, n;
+
+	memset(plane, 0, MAX_DWORDS * sizeof(uint32_t));
+	for (i = 0; i < height; i++)
+	{
+		for (k = 0; k < stride; k++)
+		{
+			n = width - k * 32;
+			plane[i * stride + k] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+			if (n < 32)
+			{
+				plane[i * stride + k] &= (1u << n) - 1;
+			}
+		}
+	}
+}
+
+/* vc1parse.h declares memset only, so <string.h> is not included here */
+static int same_plane(const uint32_t *a, const uint32_t *b)
+{
+	uint32_t i;
+
+	for (i = 0; i < MAX_DWORDS; i++)
+	{
+		if (a[i] != b[i]) return 0;
+	}
+	return 1;
+}
+
+static void copy_plane(uint32_t *to, const uint32_t *from)
+{
+	uint32_t i;
+
+	for (i = 0; i < MAX_DWORDS; i++)
+	{
+		to[i] = from[i];
+	}
+}
+
+/* byte engine reader over bits[], as for a VC-1 picture header */
+static void setup_reader(viddec_pm_cxt_t *cxt)
+{
+	memset(cxt, 0, sizeof(*cxt));
+	viddec_pm_utils_bstream_init(&(cxt->getbits), &(cxt->list), 0);
+	cxt->getbits.bstrm_buf.buf = bits;
+	cxt->getbits.bstrm_buf.buf_end = sizeof(bits);
+	cxt->list.total_bytes = sizeof(bits);
+}
+
+static int test_put_bits(int iter, uint32_t width, uint32_t height)
+{
+	static viddec_pm_cxt_t fast_cxt, ref_cxt;
+	uint32_t fast[MAX_DWORDS], ref[MAX_DWORDS];
+	void *ctxt;
+	uint32_t i, j, x, value;
+
+	for (i = 0; i < sizeof(bits); i++)
+	{
+		bits[i] = rand() & 0xff;
+	}
+	memset(fast, 0, sizeof(fast));
+	memset(ref, 0, sizeof(ref));
+	setup_reader(&fast_cxt);
+	setup_reader(&ref_cxt);
+
+	/* ROWSKIP: a flag per row, then the row. Odd rows are read from a
+	 * column offset like the NORM6 residual column rows. */
+	for (i = 0; i < height; i++)
+	{
+		x = (i & 1) ? (i % width) : 0;
+
+		ctxt = &fast_cxt;
+		VC1_GET_BITS(1, value);
+		if (value)
+		{
+			put_bits(ctxt, width - x, x, i, width, fast);
+		}
+
+		ctxt = &ref_cxt;
+		VC1_GET_BITS(1, value);
+		if (value)
+		{
+			for (j = x; j < width; j++)
+			{
+				VC1_GET_BITS(1, value);
+				put_bit(value, j, i, width, height, 0, ref);
+			}
+		}
+	}
+
+	if (!same_plane(fast, ref))
+	{
+		printf("iter %d: put_bits differs on %u x %u\n", iter, width, height);
+		return 0;
+	}
+	return 1;
+}
+
+static int test_invert(int iter, uint32_t width, uint32_t height)
+{
+	uint32_t fast[MAX_DWORDS], ref[MAX_DWORDS];
+	vc1_Bitplane bp;
+	uint32_t i, j;
+
+	random_plane(fast, width, height);
+	copy_plane(ref, fast);
+
+	bp.invert = 1;
+	bp.databits = fast;
+	vc1_InvertBitplane(&bp, width, height);
+
+	for (i = 0; i < height; i++)
+	{
+		for (j = 0; j < width; j++)
+		{
+			xor_bit(j, i, width, 1, ref);
+		}
+	}
+
+	if (!same_plane(fast, ref))
+	{
+		printf("iter %d: vc1_InvertBitplane differs on %u x %u\n", iter, width, height);
+		return 0;
+	}
+	return 1;
+}
+
+static int test_inverse_diff(int iter, uint32_t width, uint32_t height, uint8_t invert)
+{
+	uint32_t fast[MAX_DWORDS], ref[MAX_DWORDS];
+	vc1_Bitplane bp;
+
+	random_plane(fast, width, height);
+	copy_plane(ref, fast);
+
+	bp.invert = invert;
+	bp.databits = fast;
+	vc1_InverseDiff(&bp, width, height);
+	bp.databits = ref;
+	vc1_InverseDiff_ref(&bp, width, height);
+
+	if (!same_plane(fast, ref))
+	{
+		printf("iter %d: vc1_InverseDiff differs on %u x %u, invert %d\n", iter, width, height, invert);
+		return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 2000;
+	unsigned int seed = 1;
+	static uint32_t pack_planes[4][MAX_DWORDS];
+	uint32_t *planes[4] = { pack_planes[0], pack_planes[1], pack_planes[2], pack_planes[3] };
+	uint32_t width, height;
+	int iter, k;
+
+	if (argc > 1) iterations = atoi(argv[1]);
+	if (argc > 2) seed = (unsigned int) strtoul(argv[2], NULL, 0);
+
+	srand(seed);
+
+	for (iter = 0; iter < iterations; iter++)
+	{
+		/* the corners first, then random sizes */
+		width = (iter < 4) ? ((iter & 1) ? MAX_WIDTH : 1) : (uint32_t)(1 + rand() % MAX_WIDTH);
+		height = (iter < 4) ? ((iter & 2) ? MAX_HEIGHT : 1) : (uint32_t)(1 + rand() % MAX_HEIGHT);
+
+		for (k = 0; k < 4; k++)
+		{
+			random_plane(planes[k], width, height);
+		}
+
+		if (!test_put_bits(iter, width, height) ||
+			!test_invert(iter, width, height) ||
+			!test_inverse_diff(iter, width, height, 0) ||
+			!test_inverse_diff(iter, width, height, 1) ||
+			!test_pack(iter, planes, width, height))
+		{
+			printf("FAIL (seed %u)\n", seed);
+			return 1;
+		}
+	}
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ INTEL CONFIDENTIAL
+ Copyright 2009 Intel Corporation All Rights Reserved.
+ The source code contained or described herein and all documents related to the source code ("Material") are owned by Intel Corporation or its suppliers or licensors. Title to the Material remains with Intel Corporation or its suppliers and licensors. The Material contains trade secrets and proprietary and confidential information of Intel or its suppliers and licensors. The Material is protected by worldwide copyright and trade secret laws and treaty provisions. No part of the Material may be used, copied, reproduced, modified, published, uploaded, posted, transmitted, distributed, or disclosed in any way without Intel’s prior express written permission.
+
+ No license under any patent, copyright, trade secret or other intellectual property right is granted to or conferred upon you by disclosure or delivery of the Materials, either expressly, by implication, inducement, estoppel or otherwise. Any license under such intellectual property rights must be express and approved by Intel in writing.
+ */
+
+
+
+/*
+ * vbp_pack_bitplane_vc1 against vbp_pack_bitplane_ref_vc1, for
+ * vc1bitplanetest.c.
+ */
+
+#define VBP_CHECK_BITPLANE_VC1
+
+#include "vbp_vc1_parser.c"
+
+#include <stdio.h>
+
+/* maximum VA bitplane of the test, 130 x 70 MBs */
+#define MAX_PACKED	((130 * 70 + 1) / 2)
+
+/* pack the four planes into all nibble bits, as for the planes of a picture */
+int test_pack(int iter, uint32 *planes[4], uint32 width, uint32 height)
+{
+	static uint8 fast[MAX_PACKED + 4], ref[MAX_PACKED + 4];
+	uint32 shift;
+
+	memset(fast, 0, sizeof(fast));
+	memset(ref, 0, sizeof(ref));
+
+	for (shift = 0; shift < 4; shift++)
+	{
+		vbp_pack_bitplane_vc1(planes[shift], fast, width, height, shift);
+		vbp_pack_bitplane_ref_vc1(planes[shift], ref, width, height, shift);
+	}
+
+	if (memcmp(fast, ref, sizeof(fast)) != 0)
+	{
+		printf("iter %d: vbp_pack_bitplane_vc1 differs on %u x %u\n", iter, width, height);
+		return 0;
+	}
+	return 1;
+}
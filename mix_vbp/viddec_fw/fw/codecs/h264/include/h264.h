@@ -747,6 +747,22 @@ typedef struct _h264_Slice_Header
 	
 } h264_Slice_Header_t;
 
+#ifdef VBP
+//// SEI payload types interpreted by the host parser, types from 31 up share the top bit
+#define H264_SEI_TYPE_MASK(type)		(((type) < 31)? (1u << (type)): (1u << 31))
+#define H264_SEI_MASK_ALL				0xFFFFFFFF
+
+#define MAX_SEI_USER_DATA_PER_NAL		8
+
+//// User data SEI payload left in place, byte offsets are in the escaped NAL
+typedef struct _h264_SEI_User_Data_Pos
+{
+	uint32_t		payload_type;
+	uint32_t		byte_offset;
+	uint32_t		size;
+} h264_SEI_User_Data_Pos;
+#endif
+
 
 #define   MAX_USER_DATA_SIZE              1024
 typedef struct _h264_user_data_t
@@ -974,6 +990,21 @@ typedef struct _h264_Info
    uint32_t          OFFSET_REF_FRAME_PADDR_GL;
 	uint32_t				TMP_OFFSET_REFFRM_PADDR_GL;
 
+#ifdef VBP
+   //// Versions of the persistent SPS/PPS entries, bumped only when a parameter set NAL
+   //// changes the stored content of an id. active_sps_ver/active_pps_ver record the version
+   //// active_SPS/active_PPS were loaded from, 0 if they hold scratch data.
+   uint32_t          sps_ver[MAX_NUM_SPS];
+   uint32_t          pps_ver[MAX_NUM_PPS];
+   uint32_t          active_sps_ver;
+   uint32_t          active_pps_ver;
+   //// SEI payload types not in the mask are skipped, user data payloads in it are
+   //// recorded in sei_user_data for the current SEI NAL instead of being read
+   uint32_t          sei_interest_mask;
+   uint32_t          num_sei_user_data;
+   h264_SEI_User_Data_Pos sei_user_data[MAX_SEI_USER_DATA_PER_NAL];
+#endif
+
    uint32_t          h264_list_replacement;
 
    uint32_t          h264_pwt_start_byte_offset;
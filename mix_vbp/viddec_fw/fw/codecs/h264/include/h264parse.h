@@ -8,6 +8,13 @@
 #define false 0
 #endif
 
+/* The VBP host build maps the firmware arithmetic and memory helpers below to native
+   multiply/divide and libc memcpy/memset. Define H264_FW_PRIMITIVES to keep the
+   firmware versions, e.g. to compare parser throughput. */
+#if defined(VBP) && defined(HOST_ONLY) && !defined(H264_FW_PRIMITIVES)
+#define H264_HOST_PRIMITIVES
+#endif
+
 ////////////////////////////////////////////////////////////////////
 // The following part is only for Parser Debug
 ///////////////////////////////////////////////////////////////////
@@ -118,12 +125,14 @@ extern h264_Status h264_Parse_Dec_Ref_Pic_Marking(void *parent,h264_Info* pInfo,
 ////////////////////////////////////////////////////////////////////
 extern int32_t h264_is_new_picture_start(h264_Info* pInfo, h264_Slice_Header_t cur_slice, h264_Slice_Header_t old_slice);
 extern int32_t h264_is_second_field(h264_Info * pInfo);
+#ifndef H264_HOST_PRIMITIVES
 ///// Math functions
 uint32_t ldiv_mod_u(uint32_t a, uint32_t b, uint32_t * mod);
 uint32_t mult_u(uint32_t var1, uint32_t var2);
 ///// Mem functions
 extern void* h264_memset( void* buf, uint32_t c, uint32_t num );
 extern void* h264_memcpy( void* dest, void* src, uint32_t num );
+#endif
 
 extern void h264_Parse_Copy_Sps_To_DDR(h264_Info* pInfo, seq_param_set_used_ptr SPS, uint32_t nSPSId);
 extern void h264_Parse_Copy_Sps_From_DDR(h264_Info* pInfo, seq_param_set_used_ptr SPS, uint32_t nSPSId);
@@ -135,6 +144,9 @@ extern void h264_Parse_Copy_Offset_Ref_Frames_To_DDR(h264_Info* pInfo, int32_t*
 extern void h264_Parse_Copy_Offset_Ref_Frames_From_DDR(h264_Info* pInfo, int32_t* pOffset_ref_frames, uint32_t nSPSId);
 extern uint32_t h264_Parse_Check_Sps_Updated_Flag(h264_Info* pInfo, uint32_t nSPSId);
 extern void h264_Parse_Clear_Sps_Updated_Flag(h264_Info* pInfo, uint32_t nSPSId);
+#ifdef VBP
+extern uint32_t h264_Parse_Is_Active_Par_Set_Current(h264_Info* pInfo, uint32_t nPPSId);
+#endif
 
 
 ////////////////////////////////////////////////////////////////////
@@ -156,9 +168,52 @@ extern void h264_parse_emit_eos( void *parent, h264_Info *pInfo );
 
 extern void *memset(void *s, int32_t c, uint32_t n);
 extern void *memcpy(void *dest, const void *src, uint32_t n);
+
+#ifdef H264_HOST_PRIMITIVES
+///// Math functions, same results as the shift/subtract firmware versions
+static inline uint32_t mult_u(uint32_t var1, uint32_t var2)
+{
+   return var1 * var2;
+}
+
+static inline uint32_t ldiv_mod_u(uint32_t a, uint32_t b, uint32_t * mod)
+{
+   if(!b)
+   {
+      *mod = 0;
+      return 0xffffffff;   // Div by 0
+   }
+   *mod = a % b;
+   return a / b;
+}
+
+///// Mem functions, whole words only like the firmware versions (c is replicated per word)
+static inline void* h264_memset( void* buf, uint32_t c, uint32_t num )
+{
+   uint32_t* buf32 = buf;
+   uint32_t  i;
+
+   if(c == 0)
+   {
+      return memset(buf, 0, num & ~3);
+   }
+
+   for(i = 0; i < (num >> 2); i++)
+   {
+      buf32[i] = c;
+   }
+   return buf;
+}
+
+static inline void* h264_memcpy( void* dest, void* src, uint32_t num )
+{
+   return memcpy(dest, src, num & ~3);
+}
+#endif
 extern uint32_t cp_using_dma(uint32_t ddr_addr, uint32_t local_addr, uint32_t size, char to_ddr, char swap);
 extern int32_t viddec_pm_get_bits(void *parent, uint32_t *data, uint32_t num_bits);
 extern int32_t viddec_pm_peek_bits(void *parent, uint32_t *data, uint32_t num_bits);
+extern int32_t viddec_pm_skip_bits(void *parent, uint32_t num_bits);
 
 
 
@@ -75,8 +75,15 @@ h264_Status h264_active_par_set(h264_Info*pInfo,h264_Slice_Header_t* SliceHeader
 	// Reload SPS/PPS while
 	// 1) Start of Frame (in case of context switch)
 	// 2) PPS id changed
+	// 3) VBP: only if the persistent copies changed since
+	//    the active ones were loaded
 	///////////////////////////////////////////////////
+#ifdef VBP
+	if(((SliceHeader->first_mb_in_slice == 0) || (SliceHeader->pic_parameter_id != pInfo->active_PPS.pic_parameter_set_id)) &&
+	   !h264_Parse_Is_Active_Par_Set_Current(pInfo, SliceHeader->pic_parameter_id))
+#else
 	if((SliceHeader->first_mb_in_slice == 0) || (SliceHeader->pic_parameter_id != pInfo->active_PPS.pic_parameter_set_id)) 
+#endif
 	{
 #ifndef WIN32
 		h264_Parse_Copy_Pps_From_DDR(pInfo, &pInfo->active_PPS, SliceHeader->pic_parameter_id);
@@ -111,6 +118,14 @@ h264_Status h264_active_par_set(h264_Info*pInfo,h264_Slice_Header_t* SliceHeader
 		{
 			return H264_PPS_INVALID_PIC_ID;			//// Invalid SPS detected
 		} 
+
+#ifdef VBP
+		if(SliceHeader->pic_parameter_id < MAX_NUM_PPS)
+		{
+			pInfo->active_pps_ver = pInfo->pps_ver[SliceHeader->pic_parameter_id];
+			pInfo->active_sps_ver = pInfo->sps_ver[pInfo->active_SPS.seq_parameter_set_id];
+		}
+#endif
 	}
 	else {
 		if((pInfo->active_PPS.seq_parameter_set_id >= MAX_NUM_SPS)  || (pInfo->active_SPS.seq_parameter_set_id >= MAX_NUM_SPS))
@@ -327,6 +342,20 @@ void h264_init_sps_pps(struct h264_viddec_parser* parser, uint32_t *persist_mem)
 
     pInfo->active_SPS.seq_parameter_set_id = 0xff;
     pInfo->sps_valid = 0;
+
+#ifdef VBP
+    for(i=0;i<MAX_NUM_SPS;i++)
+    {
+        pInfo->sps_ver[i] = 1;
+    }
+    for(i=0;i<MAX_NUM_PPS;i++)
+    {
+        pInfo->pps_ver[i] = 1;
+    }
+    pInfo->active_sps_ver = 0;
+    pInfo->active_pps_ver = 0;
+    pInfo->sei_interest_mask = H264_SEI_MASK_ALL;
+#endif
     pInfo->got_start = 0;
 
     return;
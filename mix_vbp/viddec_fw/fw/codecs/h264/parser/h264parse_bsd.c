@@ -45,6 +45,19 @@ uint32_t h264_get_codeNum(void *parent, h264_Info* pInfo)
    //remove warning
    pInfo = pInfo;   
 
+#ifdef VBP
+   switch(viddec_pm_get_ue(parent, &codeNum))
+   {
+      case 1:
+         return codeNum;
+      case -1:
+         return MAX_INT32_VALUE;
+      default:
+         /* byte engine, decode below */
+         break;
+   }
+#endif
+
    ////// Step 1: parse through zero bits until we find a bit with value 1.
    viddec_pm_get_au_pos(parent, &bits_offset, &byte_offset, &is_emul);
 
@@ -1,6 +1,9 @@
 //#include "math.h"
 // Arithmatic functions using add & subtract
 
+// The VBP host build uses the native versions inlined from h264parse.h
+#if !(defined(VBP) && defined(HOST_ONLY)) || defined(H264_FW_PRIMITIVES)
+
 unsigned long mult_u(register unsigned long var1, register unsigned long var2)
 {
 
@@ -57,6 +60,7 @@ unsigned long ldiv_mod_u(register unsigned long a, register unsigned long b, uns
  	 *mod = a;
   	return res;
 }// ldiv_mod_u
+#endif
 
 
 unsigned ldiv_u(register unsigned a, register unsigned  b)
@@ -11,6 +11,7 @@
 #include "h264parse.h"
 
 
+#ifndef H264_HOST_PRIMITIVES
 // ---------------------------------------------------------------------------
 // IMPORTANT: note that in this implementation int c is an int not a char
 // ---------------------------------------------------------------------------
@@ -43,6 +44,40 @@ void* h264_memcpy( void* dest, void* src, uint32_t num )
 
 	return dest;
 }
+#endif
+
+
+#ifdef VBP
+// h264_Parse_Entry_Equal returns 1 if a stored parameter set entry matches the local one
+static uint32_t h264_Parse_Entry_Equal(uint32_t entry_ptr, void* local, uint32_t num)
+{
+	uint32_t*	entry32 = (uint32_t *)entry_ptr;
+	uint32_t*	local32 = local;
+	uint8_t*	entry8;
+	uint8_t*	local8;
+	uint32_t	i;
+
+	for ( i = 0; i < ( num >> 2 ); i++ )
+	{
+		if ( *entry32++ != *local32++ )
+		{
+			return 0;
+		}
+	}
+
+	entry8 = (uint8_t *)entry32;
+	local8 = (uint8_t *)local32;
+	for ( i = 0; i < ( num & 3 ); i++ )
+	{
+		if ( *entry8++ != *local8++ )
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+#endif
 
 
 #ifndef USER_MODE
@@ -55,6 +90,17 @@ void h264_Parse_Copy_Pps_To_DDR(h264_Info* pInfo, pic_param_set_ptr PPS, uint32_
 
    if(nPPSId < MAX_NUM_PPS)
    {
+#ifdef VBP
+	   // copy on write: a repeated PPS NAL leaves the stored entry and its version alone
+	   if(h264_Parse_Entry_Equal(pps_entry_ptr, PPS, copy_size))
+	   {
+		   return;
+	   }
+	   if(++pInfo->pps_ver[nPPSId] == 0)
+	   {
+		   pInfo->pps_ver[nPPSId] = 1;
+	   }
+#endif
 	   cp_using_dma(pps_entry_ptr, (uint32_t)PPS, copy_size, 1, 0);     
    }
 
@@ -89,6 +135,17 @@ void h264_Parse_Copy_Sps_To_DDR(h264_Info* pInfo, seq_param_set_used_ptr SPS, ui
 
    if(nSPSId < MAX_NUM_SPS)
    {
+#ifdef VBP
+		// copy on write: a repeated SPS NAL leaves the stored entry and its version alone
+		if(h264_Parse_Entry_Equal(sps_entry_ptr, SPS, copy_size))
+		{
+			return;
+		}
+		if(++pInfo->sps_ver[nSPSId] == 0)
+		{
+			pInfo->sps_ver[nSPSId] = 1;
+		}
+#endif
 		cp_using_dma(sps_entry_ptr, (uint32_t)SPS, copy_size, 1, 0);	  
    }
     
@@ -193,6 +250,32 @@ void h264_Parse_Clear_Sps_Updated_Flag(h264_Info* pInfo, uint32_t nSPSId)
 //end of h264_Parse_Clear_Sps_Updated_Flag
 
 
+#ifdef VBP
+// h264_Parse_Is_Active_Par_Set_Current returns 1 if active_PPS/active_SPS were loaded from the
+// current versions of pps nPPSId and of the sps it refers to, so activation can keep them
+uint32_t h264_Parse_Is_Active_Par_Set_Current(h264_Info* pInfo, uint32_t nPPSId)
+{
+   uint32_t nSPSId = pInfo->active_PPS.seq_parameter_set_id;
+
+   if((nPPSId >= MAX_NUM_PPS) || (nSPSId >= MAX_NUM_SPS))
+   {
+      return 0;
+   }
+
+   if((pInfo->active_pps_ver == 0) || (pInfo->active_sps_ver == 0))
+   {
+      return 0;
+   }
+
+   return (pInfo->active_PPS.pic_parameter_set_id == nPPSId) &&
+          (pInfo->active_pps_ver == pInfo->pps_ver[nPPSId]) &&
+          (pInfo->active_SPS.seq_parameter_set_id == nSPSId) &&
+          (pInfo->active_sps_ver == pInfo->sps_ver[nSPSId]);
+}
+//end of h264_Parse_Is_Active_Par_Set_Current
+#endif
+
+
 #endif
 
 
@@ -1093,6 +1093,56 @@ h264_Status h264_SEI_payload(void *parent, h264_Info* pInfo, h264_sei_payloadtyp
 	return status;
 }
 
+#ifdef VBP
+/* ------------------------------------------------------------------------------------------ */
+// Payloads start byte aligned, so one that is not of interest is skipped as a whole
+/* ------------------------------------------------------------------------------------------ */
+static h264_Status h264_sei_skip_payload(void *parent, uint32_t payload_size)
+{
+	uint32_t bits = payload_size << 3;
+	uint32_t n;
+
+	while(bits)
+	{
+		n = (bits > 32)? 32: bits;
+		if(-1 == viddec_pm_skip_bits(parent, n))
+		{
+			return H264_STATUS_SEI_ERROR;
+		}
+		bits -= n;
+	}
+	return H264_STATUS_OK;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+// User data is not read, its position is handed to vbp so the application gets it from the input buffer
+/* ------------------------------------------------------------------------------------------ */
+static h264_Status h264_sei_userdata_position(void *parent, h264_Info* pInfo, uint32_t payload_type, uint32_t payload_size)
+{
+	h264_Status status;
+	h264_SEI_User_Data_Pos *pos;
+	uint32_t bits_offset = 0, start = 0, end = 0;
+	uint8_t  is_emul = 0;
+
+	viddec_pm_get_au_pos(parent, &bits_offset, &start, &is_emul);
+
+	status = h264_sei_skip_payload(parent, payload_size);
+	if(status != H264_STATUS_OK)
+		return status;
+
+	viddec_pm_get_au_pos(parent, &bits_offset, &end, &is_emul);
+
+	if(pInfo->num_sei_user_data < MAX_SEI_USER_DATA_PER_NAL)
+	{
+		pos = &pInfo->sei_user_data[pInfo->num_sei_user_data++];
+		pos->payload_type = payload_type;
+		pos->byte_offset = start;
+		pos->size = end - start;
+	}
+	return H264_STATUS_OK;
+}
+#endif
+
 /* ------------------------------------------------------------------------------------------ */
 /* ------------------------------------------------------------------------------------------ */
 /* ------------------------------------------------------------------------------------------ */
@@ -1103,6 +1153,7 @@ h264_Status h264_Parse_Supplemental_Enhancement_Information_Message(void *parent
 	uint32_t next_8_bits = 0,bits_offset=0,byte_offset = 0;
 	uint8_t  is_emul = 0; 
 	int32_t  bits_operation_result = 0;
+
 	
 	do {
 		//// payload_type
@@ -1144,6 +1195,17 @@ h264_Status h264_Parse_Supplemental_Enhancement_Information_Message(void *parent
 		/////////////////////////////////
 		// Parse SEI payloads
 		/////////////////////////////////		
+#ifdef VBP
+		if(!(pInfo->sei_interest_mask & H264_SEI_TYPE_MASK(payload_type)))
+		{
+			status = h264_sei_skip_payload(parent, payload_size);
+		}
+		else if((payload_type == SEI_REG_USERDATA) || (payload_type == SEI_UNREG_USERDATA))
+		{
+			status = h264_sei_userdata_position(parent, pInfo, payload_type, payload_size);
+		}
+		else
+#endif
 		status = h264_SEI_payload(parent, pInfo, payload_type, payload_size);
 		if(status != H264_STATUS_OK)
 			break;
@@ -275,6 +275,9 @@ dump_slice_header(pInfo, &next_SliceHeader);
 			status = H264_STATUS_OK;
 
 			//OS_INFO("*****************************SEI**************************************\n"); 
+#ifdef VBP
+			pInfo->num_sei_user_data = 0;
+#endif
 			if(pInfo->sps_valid){
 				//h264_user_data_t user_data; /// Replace with tmp buffer while porting to FW
 				pInfo->number_of_first_au_info_nal_before_first_slice++;
@@ -296,6 +299,10 @@ dump_slice_header(pInfo, &next_SliceHeader);
 			
 			old_sps_id = pInfo->active_SPS.seq_parameter_set_id;			
 			h264_memset(&(pInfo->active_SPS), 0x0, sizeof(seq_param_set_used));
+#ifdef VBP
+			/// active_SPS is used as scratch, force a reload on next activation
+			pInfo->active_sps_ver = 0;
+#endif
 
 			
 			status = h264_Parse_SeqParameterSet(parent, pInfo, &(pInfo->active_SPS), &vui_seq_not_used, (int32_t *)pInfo->TMP_OFFSET_REFFRM_PADDR_GL);
@@ -339,6 +346,10 @@ dump_slice_header(pInfo, &next_SliceHeader);
 
 				h264_memset(&pInfo->active_PPS, 0x0, sizeof(pic_param_set));
 				pInfo->number_of_first_au_info_nal_before_first_slice++;
+#ifdef VBP
+				/// active_PPS is used as scratch, force a reload on next activation
+				pInfo->active_pps_ver = 0;
+#endif
 				
 				if (h264_Parse_PicParameterSet(parent, pInfo, &pInfo->active_PPS)== H264_STATUS_OK)	
 				{
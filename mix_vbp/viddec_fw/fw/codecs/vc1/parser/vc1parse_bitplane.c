@@ -105,7 +105,134 @@ static inline int get_bit(  int x, int y, int mbx, uint32_t* outp)
 
 }
 
+/* reverse the order of the n (1..32) least significant bits of v */
+static inline uint32_t reverse_bits(uint32_t v, int32_t n)
+{
+    v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+    v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+    v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+    v = (v >> 16) | (v << 16);
+    return v >> (32 - n);
+}
+
+/* read count bits from the bitstream into the MBs x to x+count-1 of row y,
+ * up to 32 bits at a time. The first bit read is the leftmost MB.
+ * input: count - number of bits
+ *        x   - x location (column) of the first MB in MB unit
+ *        y   - y location (row) of MB in MB unit
+ *        mbx - image width in MB
+ * output: outp - buffer to fill, assumed initialized with zeros
+ */
+static inline void put_bits(void* ctxt, int32_t count, int x, int y, int mbx, uint32_t* outp)
+{
+    uint32_t *out;
+    uint32_t value;
+    int32_t bit, n;
+
+    out = outp + (( mbx + 31 ) >> 5) * y + (x >> 5);
+    bit = x & 0x1f;
+
+    while (count > 0)
+    {
+        n = 32 - bit;
+        if (n > count) n = count;
+        VC1_GET_BITS(n, value);
+        *out++ |= reverse_bits(value, n) << bit;
+        count -= n;
+        bit = 0;
+    }
+}
+
+/* invert the bits of the MBs x to x+count-1 of row y
+ * input: count - number of bits
+ *        x   - x location (column) of the first MB in MB unit
+ *        y   - y location (row) of MB in MB unit
+ *        mbx - image width in MB
+ * output: outp - buffer to update
+ */
+static inline void xor_bits(int32_t count, int x, int y, int mbx, uint32_t* outp)
+{
+    uint32_t *out;
+    int32_t bit, n;
+
+    out = outp + (( mbx + 31 ) >> 5) * y + (x >> 5);
+    bit = x & 0x1f;
+
+    while (count > 0)
+    {
+        n = 32 - bit;
+        if (n > count) n = count;
+        *out++ ^= ((n == 32) ? 0xFFFFFFFF : ((1u << n) - 1)) << bit;
+        count -= n;
+        bit = 0;
+    }
+}
+
+/* inverse differential bitplane decoding, SMPTE 421M 8.7.3
+ * Each bit is b(j) = d(j) ^ p(j). The predictor p(j) is b(j-1) on the top row,
+ * the bit above on the first column, and elsewhere b(j-1) if it equals the bit
+ * above t(j), invert if not: b(j-1) & t(j) if invert is 0, b(j-1) | t(j) if 1.
+ * So b(j) = (a(j) & b(j-1)) ^ r(j), and a row is the composition of these
+ * maps, computed for 32 MBs at a time in log2(32) shift steps.
+ */
 static void vc1_InverseDiff(vc1_Bitplane *pBitplane, int32_t widthMB, int32_t heightMB)
+{
+    int32_t i, k, d, n;
+    int32_t stride = ( widthMB + 31 ) >> 5;
+    uint32_t *row = pBitplane->databits;
+    uint32_t *top = NULL;
+    uint32_t a, r, b, carry;
+
+    for (i = 0; i < heightMB; i++)
+    {
+        carry = 0;
+        for (k = 0; k < stride; k++)
+        {
+            if (top == NULL)
+            {
+                a = 0xFFFFFFFF;
+                r = row[k];
+            }
+            else if (pBitplane->invert == 0)
+            {
+                a = top[k];
+                r = row[k];
+            }
+            else
+            {
+                a = ~top[k];
+                r = row[k] ^ top[k];
+            }
+
+            if (k == 0) /* first MB of the row has no left neighbour */
+            {
+                a &= ~1u;
+                r = (r & ~1u) | ((row[0] ^ (top ? top[0] : pBitplane->invert)) & 1);
+            }
+
+            /* prefix composition of (a, r) from bit 0 up */
+            for (d = 1; d < 32; d <<= 1)
+            {
+                r ^= a & (r << d);
+                a &= (a << d) | ((1u << d) - 1);
+            }
+
+            b = r ^ (carry ? a : 0);
+            n = widthMB - (k << 5); /* MBs in this word */
+            if (n < 32)
+                b &= (1u << n) - 1;
+            row[k] = b;
+            carry = b >> 31;
+        }
+        top = row;
+        row += stride;
+    }
+}
+
+#ifdef VC1_BITPLANE_CHECK
+/* bit by bit inverse differential decoding, to cross-check vc1_InverseDiff */
+static void vc1_InverseDiff_ref(vc1_Bitplane *pBitplane, int32_t widthMB, int32_t heightMB)
 {
     int32_t i, j, previousBit=0, temp;
 
@@ -144,6 +271,8 @@ static void vc1_InverseDiff(vc1_Bitplane *pBitplane, int32_t widthMB, int32_t he
 }
 
 
+#endif
+
 /*----------------------------------------------------------------------------*/
 /* implement normal 2 mode bitplane decoding, SMPTE 412M 8.7.3.2
  * width, height are in MB unit.
@@ -424,15 +553,15 @@ static void vc1_Norm6ModeDecode(void* ctxt, vc1_Bitplane *pBitplane,
     {
         int32_t RowSkip;
         VC1_GET_BITS(1, RowSkip);
-        Value = 0;
-		for (i = ResidualX; i < width; i++)
-		{
-        	if (1 == RowSkip)
-        	{
-                VC1_GET_BITS(1, Value);
-        	}
-			put_bit(Value, i, j, width, height,pBitplane->invert,
-                        pBitplane->databits);
+        if (1 == RowSkip)
+        {
+            put_bits(ctxt, width - ResidualX, ResidualX, j, width,
+                     pBitplane->databits);
+        }
+        if (pBitplane->invert)
+        {
+            xor_bits(width - ResidualX, ResidualX, j, width,
+                     pBitplane->databits);
         }
     }
  #endif
@@ -442,6 +571,56 @@ static void vc1_Norm6ModeDecode(void* ctxt, vc1_Bitplane *pBitplane,
 
 }
 
+/*----------------------------------------------------------------------------*/
+/* apply invert to a whole bitplane decoded without it, a row of words at a time
+ * width, height are in MB unit.
+ */
+static void vc1_InvertBitplane(vc1_Bitplane *pBitplane, int32_t width, int32_t height)
+{
+    int32_t i;
+
+    if (!pBitplane->invert) return;
+
+    for (i = 0; i < height; i++)
+    {
+        xor_bits(width, 0, i, width, pBitplane->databits);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/* inverse differential decoding of a DIFF2/DIFF6 bitplane
+ * width, height are in MB unit, size is the bitplane size in dwords.
+ * Build with VC1_BITPLANE_CHECK and VC1_VERBOSE to compare the result
+ * with the bit by bit decoding.
+ */
+static void vc1_DiffDecode(vc1_Bitplane *pBitplane, int32_t width, int32_t height, uint32_t size)
+{
+#ifdef VC1_BITPLANE_CHECK
+    uint32_t i, ref[4096];
+    uint32_t *databits = pBitplane->databits;
+
+    if (size > 4096) size = 0; /* does not fit, do not check */
+    for (i = 0; i < size; i++) ref[i] = databits[i];
+    if (size)
+    {
+        pBitplane->databits = ref;
+        vc1_InverseDiff_ref(pBitplane, width, height);
+        pBitplane->databits = databits;
+    }
+#endif
+
+    vc1_InverseDiff(pBitplane, width, height);
+
+#ifdef VC1_BITPLANE_CHECK
+    for (i = 0; i < size; i++)
+    {
+        VC1_ASSERT(ref[i] == databits[i]);
+    }
+#else
+    (void)size;
+#endif
+}
+
 /*----------------------------------------------------------------------------*/
 /* initialize bitplane to array of zeros
  * each row begins with a dword
@@ -507,7 +686,7 @@ vc1_Status vc1_DecodeBitplane(void* ctxt, vc1_Info *pInfo,
     else if (bpp->imode == VC1_BITPLANE_DIFF2_MODE)
     {
         vc1_Norm2ModeDecode(ctxt, bpp, width, height);
-        vc1_InverseDiff(bpp, width, height);
+        vc1_DiffDecode(bpp, width, height, biplaneSz);
     }
     else if (bpp->imode == VC1_BITPLANE_NORM6_MODE)
     {
@@ -517,55 +696,38 @@ vc1_Status vc1_DecodeBitplane(void* ctxt, vc1_Info *pInfo,
     else if (bpp->imode == VC1_BITPLANE_DIFF6_MODE)
     {
         vc1_Norm6ModeDecode(ctxt, bpp, width, height);
-        vc1_InverseDiff(bpp, width, height);
+        vc1_DiffDecode(bpp, width, height, biplaneSz);
     }
     else if (bpp->imode == VC1_BITPLANE_ROWSKIP_MODE)
     {
-
+        /* if tempValue==0, leave row of zeros Dwords */
         for (i = 0; i < height; i++)
         {
             VC1_GET_BITS(1, tempValue);
-            /* if tempValue==0,  put row of zeros Dwords*/
             if (tempValue == 1)
             {
-                for (j = 0; j < width; j++)
-                {
-                    VC1_GET_BITS(1, tempValue);
-                    put_bit( tempValue, j, i, width, height, bpp->invert,
-                             bpp->databits);
-                }
-            }
-            else if (bpp->invert) { //TO TEST
-                for (j = 0; j < width; j++) {
-                    put_bit( 0, j, i, width, height, bpp->invert,
-                             bpp->databits);
-                }
+                put_bits(ctxt, width, 0, i, width, bpp->databits);
             }
         }
-
+        vc1_InvertBitplane(bpp, width, height);
     }
     else if (bpp->imode == VC1_BITPLANE_COLSKIP_MODE)
     {
         for (i = 0; i < width; i++)
         {
             VC1_GET_BITS(1, tempValue);
-            /* if tempValue==0, and invert == 0, fill column with zeros */
+            /* if tempValue==0, leave column of zeros */
             if (tempValue == 1)
             {
                 for (j = 0; j < height; j++)
                 {
                     VC1_GET_BITS(1, tempValue);
-                    put_bit( tempValue, i, j, width, height, bpp->invert,
+                    put_bit( tempValue, i, j, width, height, 0,
                              bpp->databits);
                 }
             } 
-            else if (bpp->invert) { // fill column with ones
-                for (j = 0; j < height; j++) {
-                    put_bit( 0, i, j, width, height, bpp->invert,
-                             bpp->databits);
-                }
-            }//end for else  
         }
+        vc1_InvertBitplane(bpp, width, height);
     }
 
     if(bpp->imode != VC1_BITPLANE_RAW_MODE)
@@ -55,6 +55,14 @@ int32_t viddec_pm_peek_bits(void *parent, uint32_t *data, uint32_t num_bits);
  */
 int32_t viddec_pm_skip_bits(void *parent, uint32_t num_bits);
 
+#ifdef VBP
+/* This function reads an Exp-Golomb ue(v) code. Returns 0 if the fast path is not available, in which
+   case the caller has to fall back to bit reads.
+ */
+int32_t viddec_pm_get_ue(void *parent, uint32_t *codenum);
+#endif
+
+#ifndef VBP
 /* This function appends a work item to current workload.
  */
 int32_t viddec_pm_append_workitem(void *parent, viddec_workload_item_t *item);
@@ -62,12 +70,14 @@ int32_t viddec_pm_append_workitem(void *parent, viddec_workload_item_t *item);
 /* This function appends a work item to next workload.
  */
 int32_t viddec_pm_append_workitem_next(void *parent, viddec_workload_item_t *item);
+#endif
 
 /* This function gets current byte and bit positions and information on whether an emulation byte is present after
 current byte.
  */
 int32_t viddec_pm_get_au_pos(void *parent, uint32_t *bit, uint32_t *byte, unsigned char *is_emul);
 
+#ifndef VBP
 /* This function appends Pixel tag to current work load starting from current position to end of au unit.
  */
 int32_t viddec_pm_append_pixeldata(void *parent);
@@ -75,6 +85,7 @@ int32_t viddec_pm_append_pixeldata(void *parent);
 /* This function appends Pixel tag to next work load starting from current position to end of au unit.
  */
 int32_t viddec_pm_append_pixeldata_next(void *parent);
+#endif
 
 /* This function provides the workload header for pasers to fill in attribute values
  */
@@ -90,8 +101,44 @@ uint32_t viddec_pm_get_cur_byte(void *parent, uint8_t *byte);
 /* Tells us if there is more data that need to parse */
 int32_t viddec_pm_is_nomoredata(void *parent);
 
+#ifndef VBP
 /* This function appends misc tag to work load starting from start position to end position of au unit */
 int32_t viddec_pm_append_misc_tags(void *parent, uint32_t start, uint32_t end, viddec_workload_item_t *wi, uint32_t using_next);
+#else
+/* The host parser reads its results from the codec contexts (vbp_populate_query_data_*), so work items
+   are never consumed. Appending compiles to nothing; only the workload headers are kept for the frame
+   attributes some codecs still write through viddec_pm_get_header.
+ */
+static inline int32_t viddec_pm_append_workitem(void *parent, viddec_workload_item_t *item)
+{
+    (void)parent; (void)item;
+    return 1;
+}
+
+static inline int32_t viddec_pm_append_workitem_next(void *parent, viddec_workload_item_t *item)
+{
+    (void)parent; (void)item;
+    return 1;
+}
+
+static inline int32_t viddec_pm_append_pixeldata(void *parent)
+{
+    (void)parent;
+    return 1;
+}
+
+static inline int32_t viddec_pm_append_pixeldata_next(void *parent)
+{
+    (void)parent;
+    return 1;
+}
+
+static inline int32_t viddec_pm_append_misc_tags(void *parent, uint32_t start, uint32_t end, viddec_workload_item_t *wi, uint32_t using_next)
+{
+    (void)parent; (void)start; (void)end; (void)wi; (void)using_next;
+    return 1;
+}
+#endif
 
 void viddec_pm_set_next_frame_error_on_eos(void *parent, uint32_t error);
 
@@ -29,11 +29,35 @@ typedef struct
     uint32_t bitoff; /* bit offset in first valid byte */
 }viddec_pm_utils_bstream_scratch_cxt_t;
 
+#ifdef VBP
+/* Host only: emulation prevention bytes are removed once per NAL into buf (on demand, as the
+   reader advances) and bits are served from a 64-bit cache over the unescaped data. */
+typedef struct
+{
+    const uint8_t *raw; /* escaped NAL payload, first byte is au offset 0 */
+    uint32_t raw_size;
+    uint32_t raw_pos; /* next raw byte to unescape */
+    uint32_t zeros; /* emulation phase: number of preceding 0x00 bytes, max 2 */
+    uint8_t *buf; /* unescaped data followed by 8 zero bytes */
+    uint32_t size; /* unescaped bytes in buf */
+    uint32_t alloc;
+    uint32_t *emul; /* offset in buf of the byte that followed each removed 0x03, ascending */
+    uint32_t emul_count;
+    uint32_t emul_alloc;
+    uint32_t emul_idx; /* number of emul entries below the current byte, reads only move forward */
+    uint64_t cache; /* next bits, MSB first */
+    uint32_t cache_bits;
+    uint32_t rd; /* next byte in buf to load into cache */
+    uint32_t active;
+}viddec_pm_utils_bstream_rbsp_cxt_t;
+#endif
+
 typedef struct
 {
 #ifdef VBP
 	/* counter of emulation preventation byte */
 	uint32_t emulation_byte_counter;
+	viddec_pm_utils_bstream_rbsp_cxt_t rbsp;
 #endif	
     /* After First pass of scan we figure out how many bytes are in the current access unit(N bytes). We store
        the bstream buffer's first valid byte index wrt to accessunit in this variable */
@@ -64,10 +88,29 @@ uint8_t viddec_pm_utils_bstream_nomoredata(viddec_pm_utils_bstream_cxt_t *cxt);
 
 uint8_t viddec_pm_utils_bstream_nomorerbspdata(viddec_pm_utils_bstream_cxt_t *cxt);
 
+#ifdef VBP
+/* Switch the reader to the RBSP engine for the NAL at data[0..size-1]. Falls back to the byte engine if out of memory. */
+void viddec_pm_utils_bstream_rbsp_init(viddec_pm_utils_bstream_cxt_t *cxt, const uint8_t *data, uint32_t size);
+
+void viddec_pm_utils_bstream_rbsp_free(viddec_pm_utils_bstream_cxt_t *cxt);
+
+void viddec_pm_utils_bstream_rbsp_au_offsets(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t *bit, uint32_t *byte, uint8_t *is_emul);
+
+/* Exp-Golomb ue(v). Returns 1 on success, -1 on end of data, 0 if the RBSP engine is not active. */
+int32_t viddec_pm_utils_bstream_get_ue(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t *codenum);
+#endif
+
 static inline void viddec_pm_utils_bstream_get_au_offsets(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t *bit, uint32_t *byte, uint8_t *is_emul)
 {
     uint32_t phase=cxt->phase;
 
+#ifdef VBP
+    if(cxt->rbsp.active)
+    {
+        viddec_pm_utils_bstream_rbsp_au_offsets(cxt, bit, byte, is_emul);
+        return;
+    }
+#endif
     *bit = cxt->bstrm_buf.buf_bitoff;
     *byte = cxt->au_pos + (cxt->bstrm_buf.buf_index - cxt->bstrm_buf.buf_st);
     if(cxt->phase > 0)
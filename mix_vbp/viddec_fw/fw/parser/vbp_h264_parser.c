@@ -9,6 +9,7 @@
 
 #include <glib.h>
 #include <dlfcn.h>
+#include <string.h>
 
 #include "h264.h"
 #include "vbp_loader.h"
@@ -19,6 +20,22 @@
 /* number of bytes used to encode length of NAL payload. Default is 4 bytes. */
 static int NAL_length_size = 4;
 
+/* slice entries allocated per picture up front. The arrays double on demand
+ * (up to one slice per list item) and are kept across frames.
+ */
+#define INITIAL_NUM_SLICES 8
+#define INITIAL_NUM_SEI_USER_DATA 4
+
+/* query data handed out by vbp_query, followed by the capacity of the slice
+ * and SEI user data arrays which is not part of the public structure.
+ */
+typedef struct _vbp_data_h264_private
+{
+	vbp_data_h264 data;	/* must be first */
+	uint32 slc_capacity[MAX_NUM_PICTURES];
+	uint32 sei_capacity;
+} vbp_data_h264_private;
+
 /* default scaling list table */
 unsigned char Default_4x4_Intra[16] =
 {     
@@ -88,6 +105,69 @@ unsigned char* UseDefaultList[8] =
     Default_8x8_Inter
 };
 
+/**
+ *
+ * for incremental parsing: list item i starts the next access unit while the
+ * query data already holds a picture (7.4.1.2.3). No slice order is assumed
+ * beyond what vbp_add_pic_data_h264 does, a slice with first_mb_in_slice 0
+ * starts a new picture.
+ *
+ */
+static uint32 vbp_is_next_frame_h264(vbp_context *pcontext, int i)
+{
+	viddec_pm_cxt_t *cxt = pcontext->parser_cxt;
+	vbp_data_h264 *query_data = (vbp_data_h264 *)pcontext->query_data;
+	uint8 *nal = cxt->parse_cubby.buf + cxt->list.data[i].stpos;
+	uint32 size = cxt->list.data[i].edpos - cxt->list.data[i].stpos;
+
+	if ((0 == query_data->num_pictures) || (cxt->list.data[i].edpos <= cxt->list.data[i].stpos))
+	{
+		return 0;
+	}
+
+	switch (nal[0] & 0x1F)
+	{
+		case h264_NAL_UNIT_TYPE_SLICE:
+		case h264_NAL_UNIT_TYPE_IDR:
+		/* first_mb_in_slice is ue(v), a leading 1 codes 0 */
+		return (size > 1) && (nal[1] & 0x80);
+
+		case h264_NAL_UNIT_TYPE_SEI:
+		case h264_NAL_UNIT_TYPE_SPS:
+		case h264_NAL_UNIT_TYPE_PPS:
+		case h264_NAL_UNIT_TYPE_Acc_unit_delimiter:
+		case h264_NAL_UNIT_TYPE_Reserved1:
+		case h264_NAL_UNIT_TYPE_Reserved2:
+		case h264_NAL_UNIT_TYPE_Reserved3:
+		case h264_NAL_UNIT_TYPE_Reserved4:
+		case h264_NAL_UNIT_TYPE_Reserved5:
+		return 1;
+
+		default:
+		return 0;
+	}
+}
+
+/**
+ *
+ * options set through vbp_set_option
+ *
+ */
+static uint32 vbp_set_option_h264(vbp_context *pcontext, uint32 option, uint32 value)
+{
+	struct h264_viddec_parser* parser = (struct h264_viddec_parser *)&(pcontext->parser_cxt->codec_data[0]);
+
+	switch (option)
+	{
+		case VBP_OPTION_SEI_MASK:
+		parser->info.sei_interest_mask = value;
+		return VBP_OK;
+
+		default:
+		return VBP_IMPL;
+	}
+}
+
 /**
  *
  */
@@ -129,6 +209,11 @@ uint32 vbp_init_parser_entries_h264(vbp_context *pcontext)
 
 	/* entry point not needed */
 	pcontext->parser_ops->is_frame_start = NULL;
+
+	/* frames can be parsed incrementally */
+	pcontext->func_is_next_frame = vbp_is_next_frame_h264;
+
+	pcontext->func_set_option = vbp_set_option_h264;
 	return VBP_OK;
 }
 
@@ -145,12 +230,14 @@ uint32 vbp_allocate_query_data_h264(vbp_context *pcontext)
 
 	pcontext->query_data = NULL;
 	vbp_data_h264 *query_data = NULL;
+	vbp_data_h264_private *private_data = NULL;
 
-	query_data = g_try_new0(vbp_data_h264, 1);
-	if (NULL == query_data)
+	private_data = g_try_new0(vbp_data_h264_private, 1);
+	if (NULL == private_data)
 	{
 		goto cleanup;
 	}
+	query_data = &(private_data->data);
 
 	/* assign the pointer */
 	pcontext->query_data = (void *)query_data;
@@ -170,11 +257,12 @@ uint32 vbp_allocate_query_data_h264(vbp_context *pcontext)
 			goto cleanup;
 		} 
 		query_data->pic_data[i].num_slices = 0;
-		query_data->pic_data[i].slc_data = g_try_new0(vbp_slice_data_h264, MAX_NUM_SLICES);
+		query_data->pic_data[i].slc_data = g_try_new0(vbp_slice_data_h264, INITIAL_NUM_SLICES);
 		if (NULL == query_data->pic_data[i].slc_data)
 		{
 			goto cleanup;
 		}    
+		private_data->slc_capacity[i] = INITIAL_NUM_SLICES;
 	}
 
 
@@ -221,6 +309,8 @@ uint32 vbp_free_query_data_h264(vbp_context *pcontext)
 
 	g_free(query_data->IQ_matrix_buf);
 	g_free(query_data->codec_data);
+	g_free(query_data->sei_user_data);
+	/* query data is the first member of vbp_data_h264_private */
 	g_free(query_data);
 
 	pcontext->query_data = NULL;
@@ -807,6 +897,25 @@ static void vbp_set_codec_data_h264(
 	 
 	codec_data->video_format =
 		parser->info.active_SPS.sps_disp.vui_seq_parameters.video_signal_type_present_flag;  			
+
+	/* bitstream restriction */
+	codec_data->bitstream_restriction_flag =
+		parser->info.active_SPS.sps_disp.vui_parameters_present_flag &&
+		parser->info.active_SPS.sps_disp.vui_seq_parameters.bitstream_restriction_flag;
+
+	if (codec_data->bitstream_restriction_flag)
+	{
+		/* both are bounded by MaxDpbFrames (16) in a conforming stream */
+		codec_data->max_num_reorder_frames = (uint8)MIN(
+			parser->info.active_SPS.sps_disp.vui_seq_parameters.num_reorder_frames, 16);
+		codec_data->max_dec_frame_buffering = (uint8)MIN(
+			parser->info.active_SPS.sps_disp.vui_seq_parameters.max_dec_frame_buffering, 16);
+	}
+	else
+	{
+		codec_data->max_num_reorder_frames = 0;
+		codec_data->max_dec_frame_buffering = 0;
+	}
 }
 
 
@@ -932,6 +1041,8 @@ static uint32_t vbp_add_pic_data_h264(vbp_context *pcontext, int list_index)
 	  	pic_parms->pic_fields.bits.constrained_intra_pred_flag = parser->info.active_PPS.constrained_intra_pred_flag;
 	
 	  	pic_parms->frame_num = parser->info.SliceHeader.frame_num;			  	
+
+		pic_data->idr_flag = (parser->info.nal_unit_type == h264_NAL_UNIT_TYPE_IDR);
 	} 		
 
 			
@@ -1092,6 +1203,105 @@ static inline void vbp_update_reference_frames_h264_methodB(vbp_picture_data_h26
 #endif
 
 
+/**
+* make room for one more slice in the picture, growing its slice array geometrically
+*/
+static uint32_t vbp_reserve_slice_data_h264(vbp_data_h264 *query_data, int pic_data_index)
+{
+	vbp_data_h264_private *private_data = (vbp_data_h264_private *)query_data;
+	vbp_picture_data_h264 *pic_data = &(query_data->pic_data[pic_data_index]);
+	vbp_slice_data_h264 *slc_data = NULL;
+	uint32 capacity = private_data->slc_capacity[pic_data_index];
+	uint32 new_capacity = 0;
+	uint32 max_slices = 0;
+
+	if (pic_data->num_slices < capacity)
+	{
+		return VBP_OK;
+	}
+
+	/* A slice has at least one macroblock. vbp_parse_partial appends slices from
+	 * several buffers, so the list items of one buffer are no bound.
+	 */
+	max_slices = (pic_data->pic_parms->picture_width_in_mbs_minus1 + 1) *
+		(pic_data->pic_parms->picture_height_in_mbs_minus1 + 1);
+	max_slices = MAX(max_slices, MAX_IBUFS_PER_SC);
+	if (capacity >= max_slices)
+	{
+		ETRACE("number of slices per picture exceeds the limit (%d).", max_slices);
+		return VBP_DATA;
+	}
+
+	new_capacity = MIN(capacity * 2, max_slices);
+	slc_data = g_try_realloc(pic_data->slc_data, new_capacity * sizeof(vbp_slice_data_h264));
+	if (NULL == slc_data)
+	{
+		ETRACE("Failed to allocate memory");
+		return VBP_MEM;
+	}
+	memset(slc_data + capacity, 0, (new_capacity - capacity) * sizeof(vbp_slice_data_h264));
+
+	pic_data->slc_data = slc_data;
+	private_data->slc_capacity[pic_data_index] = new_capacity;
+
+	return VBP_OK;
+}
+
+/**
+* hand out the user data SEI payloads of list item index as ranges of the sample buffer.
+* The ranges are escaped, size includes the emulation prevention bytes in them.
+*/
+static uint32_t vbp_add_sei_user_data_h264(vbp_context *pcontext, int index)
+{
+	viddec_pm_cxt_t *cxt = pcontext->parser_cxt;
+	struct h264_viddec_parser* parser = (struct h264_viddec_parser *)&(cxt->codec_data[0]);
+	h264_Info *pInfo = &(parser->info);
+	vbp_data_h264 *query_data = (vbp_data_h264 *)pcontext->query_data;
+	vbp_data_h264_private *private_data = (vbp_data_h264_private *)query_data;
+	vbp_sei_user_data_h264 *user_data = NULL;
+	uint8 *nal = cxt->parse_cubby.buf + cxt->list.data[index].stpos;
+	uint32 new_capacity = 0;
+	uint32 offset, size;
+	uint32 n;
+
+	for (n = 0; n < pInfo->num_sei_user_data; n++)
+	{
+		if (query_data->num_sei_user_data >= private_data->sei_capacity)
+		{
+			new_capacity = private_data->sei_capacity ? private_data->sei_capacity * 2 : INITIAL_NUM_SEI_USER_DATA;
+			user_data = g_try_realloc(query_data->sei_user_data, new_capacity * sizeof(vbp_sei_user_data_h264));
+			if (NULL == user_data)
+			{
+				ETRACE("Failed to allocate memory");
+				return VBP_MEM;
+			}
+			query_data->sei_user_data = user_data;
+			private_data->sei_capacity = new_capacity;
+		}
+
+		offset = pInfo->sei_user_data[n].byte_offset;
+		size = pInfo->sei_user_data[n].size;
+
+		/* the position the parser reports for a payload that follows an emulation
+		 * prevention byte is that byte, which belongs to the bytes before it.
+		 */
+		if ((size > 0) && (offset >= 2) && (0x03 == nal[offset]) &&
+			(0 == nal[offset - 1]) && (0 == nal[offset - 2]))
+		{
+			offset++;
+			size--;
+		}
+
+		user_data = &(query_data->sei_user_data[query_data->num_sei_user_data++]);
+		user_data->buffer_addr = cxt->parse_cubby.buf;
+		user_data->offset = cxt->list.data[index].stpos + offset;
+		user_data->size = size;
+		user_data->payload_type = pInfo->sei_user_data[n].payload_type;
+	}
+
+	return VBP_OK;
+}
+
 static uint32_t vbp_add_slice_data_h264(vbp_context *pcontext, int index)
 {
   	viddec_pm_cxt_t *cxt = pcontext->parser_cxt;
@@ -1104,6 +1314,7 @@ static uint32_t vbp_add_slice_data_h264(vbp_context *pcontext, int index)
 	struct h264_viddec_parser* h264_parser = NULL;
 	h264_Slice_Header_t* slice_header = NULL;
 	vbp_picture_data_h264* pic_data = NULL;
+	uint32 error = VBP_OK;
   	
         
 	h264_parser = (struct h264_viddec_parser *)cxt->codec_data;
@@ -1114,6 +1325,12 @@ static uint32_t vbp_add_slice_data_h264(vbp_context *pcontext, int index)
 		return VBP_DATA;
 	}
 	
+	error = vbp_reserve_slice_data_h264(query_data, pic_data_index);
+	if (VBP_OK != error)
+	{
+		return error;
+	}
+
 	pic_data = &(query_data->pic_data[pic_data_index]);
 	
 	slc_data = &(pic_data->slc_data[pic_data->num_slices]);       
@@ -1223,11 +1440,6 @@ static uint32_t vbp_add_slice_data_h264(vbp_context *pcontext, int index)
 	pic_data->num_slices++;  
 	
 	//vbp_update_reference_frames_h264_methodB(pic_data);
-	if (pic_data->num_slices > MAX_NUM_SLICES)
-	{
-		ETRACE("number of slices per picture exceeds the limit (%d).", MAX_NUM_SLICES);
-		return VBP_DATA;
-	}
 	return VBP_OK;
 }
 
@@ -1416,15 +1628,22 @@ uint32 vbp_parse_start_code_h264(vbp_context *pcontext)
   	int32_t NAL_length = 0;
   	viddec_sc_parse_cubby_cxt_t* cubby = NULL;
 
-	/* reset query data for the new sample buffer */
+	/* reset query data for the new sample buffer, unless slices are
+	 * appended to a frame assembled from several buffers.
+	 */
 	vbp_data_h264* query_data = (vbp_data_h264*)pcontext->query_data;
 	int i;
 
-	for (i = 0; i < MAX_NUM_PICTURES; i++)
+	if (!pcontext->partial_frame)
 	{
-		query_data->pic_data[i].num_slices = 0;
+		for (i = 0; i < MAX_NUM_PICTURES; i++)
+		{
+			query_data->pic_data[i].num_slices = 0;
+		}
+		query_data->num_pictures = 0;
+		query_data->num_sei_user_data = 0;
+		query_data->has_recovery_point = 0;
 	}
-	query_data->num_pictures = 0;
 
 	
   	cubby = &(cxt->parse_cubby);
@@ -1469,11 +1688,6 @@ uint32 vbp_parse_start_code_h264(vbp_context *pcontext)
 */
 uint32 vbp_process_parsing_result_h264( vbp_context *pcontext, int i)
 {  	
-	if (i >= MAX_NUM_SLICES)
-	{
-		return VBP_PARM;
-	}
-	
 	uint32 error = VBP_OK;
 
   	struct h264_viddec_parser* parser = NULL;
@@ -1500,6 +1714,15 @@ uint32 vbp_process_parsing_result_h264( vbp_context *pcontext, int i)
        		
        	case h264_NAL_UNIT_TYPE_SEI:
 		/* ITRACE("SEI header is parsed."); */
+		error = vbp_add_sei_user_data_h264(pcontext, i);
+		if (parser->info.sei_information.recovery_point)
+		{
+			/* cleared again once the slice header of the next picture is parsed */
+			vbp_data_h264 *query_data = (vbp_data_h264 *)pcontext->query_data;
+			query_data->has_recovery_point = 1;
+			query_data->broken_link_flag = parser->info.sei_information.broken_link_pic;
+			query_data->recovery_frame_cnt = parser->info.sei_information.recovery_frame_cnt;
+		}
        	break;
        		
      	case h264_NAL_UNIT_TYPE_SPS:
@@ -1556,11 +1779,12 @@ uint32 vbp_populate_query_data_h264(vbp_context *pcontext)
 		* picture parameter buffer and slice parameter buffer have been populated
 		*/
 	}
-	else
+	else if (!pcontext->partial_frame || pcontext->frame_done)
 	{
 		/**
 		* add a dummy picture that contains picture parameters parsed
-		  from SPS and PPS.
+		  from SPS and PPS. Not while a frame is still being assembled,
+		  its first slice will add the picture.
 		*/
 		vbp_add_pic_data_h264(pcontext, 0);
 	}
@@ -134,6 +134,123 @@ uint32 vbp_query(Handle hcontext, void **data)
 		return error;
 }
 
+/**
+ *
+ */
+uint32 vbp_parse_partial(Handle hcontext, uint8 *data, uint32 size, uint8 last_chunk, uint32 *consumed)
+{
+	vbp_context *pcontext;
+	uint32 error = VBP_OK;
+
+	if ((NULL == hcontext) || (NULL == data) || (0 == size) || (NULL == consumed))
+	{
+		ETRACE("Invalid input parameters.");
+		return VBP_PARM;
+	}
+
+	pcontext = (vbp_context *)hcontext;
+
+	if (MAGIC_NUMBER != pcontext->identifier)
+	{
+		ETRACE("context is not initialized");
+		return VBP_INIT;
+	}
+
+	error = vbp_utils_parse_partial(pcontext, data, size, last_chunk, consumed);
+	
+	if ((VBP_OK != error) && (VBP_DONE != error))
+	{
+		ETRACE("Failed to parse buffer: %d.", error);
+	}
+	return error;
+}
+
+/**
+ *
+ */
+uint32 vbp_query_incremental(Handle hcontext, void **data, uint32 *frame_done)
+{
+	vbp_context *pcontext;
+	uint32 error = VBP_OK;
+
+	if ((NULL == hcontext) || (NULL == data) || (NULL == frame_done))
+	{
+		ETRACE("Invalid input parameters.");
+		return VBP_PARM;
+	}
+
+	pcontext = (vbp_context *)hcontext;
+
+	if (MAGIC_NUMBER != pcontext->identifier)
+	{
+		ETRACE("context is not initialized");
+		return VBP_INIT;
+	}
+
+	error = vbp_utils_query_incremental(pcontext, data, frame_done);
+
+	if (VBP_OK != error)
+	{
+		ETRACE("Failed to query parsing result: %d.", error);
+	}
+	return error;
+}
+
+/**
+ *
+ */
+uint32 vbp_set_option(Handle hcontext, uint32 option, uint32 value)
+{
+	vbp_context *pcontext;
+	uint32 error = VBP_OK;
+
+	if (NULL == hcontext)
+	{
+		ETRACE("Invalid input parameters.");
+		return VBP_PARM;
+	}
+
+	pcontext = (vbp_context *)hcontext;
+
+	if (MAGIC_NUMBER != pcontext->identifier)
+	{
+		ETRACE("context is not initialized");
+		return VBP_INIT;
+	}
+
+	error = vbp_utils_set_option(pcontext, option, value);
+
+	if (VBP_OK != error)
+	{
+		WTRACE("Failed to set option %d: %d.", option, error);
+	}
+	return error;
+}
+
+/**
+ *
+ */
+uint32 vbp_get_statistics(Handle hcontext, vbp_statistics *stats)
+{
+	vbp_context *pcontext;
+
+	if ((NULL == hcontext) || (NULL == stats))
+	{
+		ETRACE("Invalid input parameters.");
+		return VBP_PARM;
+	}
+
+	pcontext = (vbp_context *)hcontext;
+
+	if (MAGIC_NUMBER != pcontext->identifier)
+	{
+		ETRACE("context is not initialized");
+		return VBP_INIT;
+	}
+
+	return vbp_utils_get_statistics(pcontext, stats);
+}
+
 /**
  *
  */
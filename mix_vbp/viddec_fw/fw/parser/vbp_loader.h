@@ -110,6 +110,11 @@ typedef struct _vbp_codec_data_h264
 	/* video fromat */
 	uint8   	video_signal_type_present_flag; 	
 	uint8  		video_format;  		
+
+	/* bitstream restriction, valid if bitstream_restriction_flag is set */
+	uint8		bitstream_restriction_flag;
+	uint8		max_num_reorder_frames;
+	uint8		max_dec_frame_buffering;
 		
 } vbp_codec_data_h264;
 
@@ -133,8 +138,28 @@ typedef struct _vbp_slice_data_h264
      uint32 num_slices;           
 
      vbp_slice_data_h264* slc_data; 	
+
+     /* the picture is an IDR picture (nal_unit_type 5) */
+     uint8 idr_flag;
                
  } vbp_picture_data_h264;
+
+/* user data SEI payload (user_data_registered_itu_t_t35 or user_data_unregistered) */
+typedef struct _vbp_sei_user_data_h264
+{
+     uint8* buffer_addr;
+
+     uint32 offset; /* first byte of the payload, after payloadType and payloadSize */
+
+     /* payload size in the buffer. The payload is not copied, it still contains
+      * emulation prevention bytes (0x000003) that have to be removed before use.
+      * size counts those 0x03 bytes, so it is larger than the payloadSize coded
+      * in the SEI message by the number of them in the payload. */
+     uint32 size;
+
+     uint8 payload_type;
+
+} vbp_sei_user_data_h264;
  
 
 typedef struct _vbp_data_h264
@@ -154,6 +179,21 @@ typedef struct _vbp_data_h264
 
      vbp_codec_data_h264* codec_data;
 
+     /* user data SEI payloads in the buffer, see VBP_OPTION_SEI_MASK */
+     uint32 num_sei_user_data;
+
+     vbp_sei_user_data_h264* sei_user_data;
+
+     /* a recovery point SEI is in the buffer; it applies to the next picture */
+     uint8 has_recovery_point;
+
+     /* frames that follow the recovery point in decoding order but precede it in
+      * output order may refer to frames before it that are not available */
+     uint8 broken_link_flag;
+
+     /* pictures in decoding order until the output is correct, frame_num based */
+     uint32 recovery_frame_cnt;
+
 } vbp_data_h264; 
 
 /*
@@ -268,6 +308,30 @@ enum _vbp_parser_type
 	VBP_H264
 };
 
+enum _vbp_option
+{
+	/* H.264: mask of the SEI payload types to interpret, built with VBP_SEI_MASK().
+	 * Other payloads are skipped without being read. Defaults to VBP_SEI_MASK_ALL. */
+	VBP_OPTION_SEI_MASK,
+
+	/* all parsers: 1 to reset and start collecting vbp_statistics, 0 to stop. */
+	VBP_OPTION_STATISTICS
+};
+
+/* parser statistics, see VBP_OPTION_STATISTICS */
+typedef struct _vbp_statistics
+{
+	uint32 buffers;		/* buffers parsed */
+	uint32 units;		/* start code delimited units (NAL units for H.264) parsed */
+	double scan_time;	/* seconds spent finding start codes */
+	double parse_time;	/* seconds spent parsing syntax and filling query data */
+	double query_time;	/* seconds spent completing query data in vbp_query */
+} vbp_statistics;
+
+/* payload types from 31 up share the top bit */
+#define VBP_SEI_MASK(payload_type) ((payload_type) < 31 ? (1u << (payload_type)) : (1u << 31))
+#define VBP_SEI_MASK_ALL 0xFFFFFFFF
+
 /*
  * open video bitstream parser to parse a specific media type.
  * @param  parser_type: one of the types defined in #vbp_parser_type
@@ -306,6 +370,56 @@ uint32 vbp_parse(Handle hcontext, uint8 *data, uint32 size, uint8 init_data_flag
  */
 uint32 vbp_query(Handle hcontext, void **data);
 
+/*
+ * parse part of a frame as it arrives (currently H.264 only), so slices can be
+ * decoded before the whole access unit is received.
+ * Slices are appended to the query data of the current frame. Slice data points
+ * into the buffers passed in, which must stay valid until the slices are submitted.
+ * @param hcontext: handle to VBP context.
+ * @param data: pointer to bitstream buffer, whole NAL units in the format vbp_parse takes.
+ * @param size: size of bitstream buffer.
+ * @param last_chunk: 1 if the buffer ends the frame (e.g. RTP marker bit), 0 otherwise.
+ * @param consumed: number of bytes parsed. Less than size if the next frame starts
+ * 				in the buffer, pass the rest in again once the current frame is queried.
+ * @return VBP_DONE if the frame is complete, VBP_OK if more data is needed,
+ * 				anything else on failure.
+ * 
+ */
+uint32 vbp_parse_partial(Handle hcontext, uint8 *data, uint32 size, uint8 last_chunk, uint32 *consumed);
+
+/*
+ * query the frame being parsed by vbp_parse_partial.
+ * @param hcontext: handle to VBP context.
+ * @param data: pointer to hold the data blob, same as vbp_query. Until the frame is
+ * 				complete the number of slices only grows and slices already
+ * 				returned do not change.
+ * @param frame_done: set to 1 if the frame is complete, 0 otherwise.
+ * @return VBP_OK on success, anything else on failure.
+ * 
+ */
+uint32 vbp_query_incremental(Handle hcontext, void **data, uint32 *frame_done);
+
+/*
+ * set a parser option.
+ * @param hcontext: handle to VBP context.
+ * @param option: one of the options defined in #vbp_option
+ * @param value: value of the option.
+ * @return VBP_OK on success, VBP_IMPL if the parser does not support the option,
+ * 				anything else on failure.
+ * 
+ */
+uint32 vbp_set_option(Handle hcontext, uint32 option, uint32 value);
+
+/*
+ * get parser statistics collected since VBP_OPTION_STATISTICS was set.
+ * @param hcontext: handle to VBP context.
+ * @param stats: structure to fill in.
+ * @return VBP_OK on success, VBP_INIT if statistics are not collected,
+ * 				anything else on failure.
+ * 
+ */
+uint32 vbp_get_statistics(Handle hcontext, vbp_statistics *stats);
+
 
 /*
  * flush any un-parsed bitstream.
@@ -9,6 +9,7 @@
 
 #include <glib.h>
 #include <dlfcn.h>
+#include <string.h>
 
 #include "vc1.h"
 #include "h264.h"
@@ -169,6 +170,10 @@ static uint32 vbp_utils_free_parser_memory(vbp_context *pcontext)
 	g_free(pcontext->persist_mem);
 	pcontext->persist_mem = NULL;
 
+	if (pcontext->parser_cxt)
+	{
+		viddec_pm_utils_bstream_rbsp_free(&(pcontext->parser_cxt->getbits));
+	}
 	g_free(pcontext->parser_cxt);
 	pcontext->parser_cxt = NULL;
 	
@@ -187,7 +192,7 @@ static uint32 vbp_utils_allocate_parser_memory(vbp_context *pcontext)
 	uint32 error = VBP_OK;
 	viddec_parser_memory_sizes_t sizes;
 
-	pcontext->parser_cxt = g_try_new(viddec_pm_cxt_t, 1);
+	pcontext->parser_cxt = g_try_new0(viddec_pm_cxt_t, 1);
 	if (NULL == pcontext->parser_cxt)
 	{
 		ETRACE("Failed to allocate memory");
@@ -228,9 +233,10 @@ static uint32 vbp_utils_allocate_parser_memory(vbp_context *pcontext)
 		}
 	}
 
-	/* allocate a new workload with 1000 items. */
-	pcontext->workload1 = g_try_malloc(sizeof(viddec_workload_t) +
-		(MAX_WORKLOAD_ITEMS * sizeof(viddec_workload_item_t)));
+	/* work items are never emitted in the host build (see viddec_parser_ops.h),
+	 * only the workload headers are used for frame attributes.
+	 */
+	pcontext->workload1 = g_try_new0(viddec_workload_t, 1);
 	if (NULL == pcontext->workload1)
 	{
 		ETRACE("Failed to allocate memory");
@@ -238,9 +244,7 @@ static uint32 vbp_utils_allocate_parser_memory(vbp_context *pcontext)
 		goto cleanup;
 	}
 
-	/* allocate a second workload with 1000 items. */
-	pcontext->workload2 = g_try_malloc(sizeof(viddec_workload_t) +
-		(MAX_WORKLOAD_ITEMS * sizeof(viddec_workload_item_t)));
+	pcontext->workload2 = g_try_new0(viddec_workload_t, 1);
 	if (NULL == pcontext->workload2)
 	{	
 		ETRACE("Failed to allocate memory");
@@ -263,15 +267,44 @@ cleanup:
 
 /**
  *
- * parse the elementary sample buffer or codec configuration data
+ * time elapsed since *mark, which is moved on to now
+ *
+ */
+static inline double vbp_utils_lap(vbp_context *pcontext, double *mark)
+{
+	double now = g_timer_elapsed(pcontext->stats_timer, NULL);
+	double lap = now - *mark;
+
+	*mark = now;
+	return lap;
+}
+
+
+/**
+ *
+ * parse the elementary sample buffer or codec configuration data set up in
+ * the cubby. For incremental parsing next_frame_item is not NULL, parsing
+ * then stops at the first list item of the next frame and its index is
+ * returned there (-1 if the whole buffer belongs to the current frame).
  *
  */
-static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_flag)
+static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_flag, int *next_frame_item)
 {
 	viddec_pm_cxt_t *cxt = pcontext->parser_cxt;
 	viddec_parser_ops_t *ops = pcontext->parser_ops;
 	uint32 error = VBP_OK;
 	int i;
+	double mark = 0;
+
+	if (next_frame_item)
+	{
+		*next_frame_item = -1;
+	}
+
+	if (pcontext->stats)
+	{
+		mark = g_timer_elapsed(pcontext->stats_timer, NULL);
+	}
 
 	/* reset list number. func_parse_init_data or func_parse_start_code will
 	* set it equal to number of sequence headers, picture headers or slices headers
@@ -313,6 +346,11 @@ static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_f
 		return error;
 	}
 
+	if (pcontext->stats)
+	{
+		pcontext->stats->scan_time += vbp_utils_lap(pcontext, &mark);
+	}
+
 	/* set up bitstream buffer */
 	cxt->getbits.list = &(cxt->list);
 
@@ -326,6 +364,12 @@ static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_f
 
 	for (i = 0; i < cxt->list.num_items; i++)
 	{
+		if (next_frame_item && pcontext->func_is_next_frame(pcontext, i))
+		{
+			*next_frame_item = i;
+			break;
+		}
+
 		/* setup bitstream parser */
 		cxt->getbits.bstrm_buf.buf_index = cxt->list.data[i].stpos;
 		cxt->getbits.bstrm_buf.buf_st = cxt->list.data[i].stpos;
@@ -343,6 +387,10 @@ static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_f
 		cxt->list.end_offset = cxt->list.data[i].edpos;
 		cxt->list.total_bytes = cxt->list.data[i].edpos - cxt->list.data[i].stpos;
 
+		/* unescape once and read through the 64-bit cache */
+		viddec_pm_utils_bstream_rbsp_init(&(cxt->getbits),
+			cxt->parse_cubby.buf + cxt->list.data[i].stpos, cxt->list.total_bytes);
+
 		/* invoke parse entry point to parse the buffer */
 		error = ops->parse_syntax((void *)cxt, (void *)&(cxt->codec_data[0]));
 	
@@ -366,7 +414,15 @@ static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_f
 		}			
 	}
 
-	/* currently always assume a complete frame is supplied for parsing, so
+	if (pcontext->stats)
+	{
+		pcontext->stats->parse_time += vbp_utils_lap(pcontext, &mark);
+		pcontext->stats->buffers++;
+		pcontext->stats->units += i;
+	}
+
+	/* currently always assume a complete frame is supplied for parsing, or for
+	 * incremental parsing that func_is_next_frame tells where it ends, so
 	 * there is no need to check if workload is done
 	 */
 	 
@@ -387,6 +443,22 @@ static uint32 vbp_utils_parse_es_buffer(vbp_context *pcontext, uint8 init_data_f
 }
 
 
+/**
+ *
+ * stop collecting statistics
+ *
+ */
+static void vbp_utils_free_statistics(vbp_context *pcontext)
+{
+	if (pcontext->stats_timer)
+	{
+		g_timer_destroy(pcontext->stats_timer);
+		pcontext->stats_timer = NULL;
+	}
+	g_free(pcontext->stats);
+	pcontext->stats = NULL;
+}
+
 /**
  *
  * create the parser context
@@ -436,9 +508,7 @@ uint32 vbp_utils_create_context(uint32 parser_type, vbp_context **ppcontext)
 
 	viddec_emit_init(&(pcontext->parser_cxt->emitter));
 
-	/* overwrite init with our number of items. */
-	pcontext->parser_cxt->emitter.cur.max_items = MAX_WORKLOAD_ITEMS;
-	pcontext->parser_cxt->emitter.next.max_items = MAX_WORKLOAD_ITEMS;
+	/* header only workloads, max_items stays 0 from init. */
 
 	/* set up to find the first start code. */
 	pcontext->parser_cxt->sc_prefix_info.first_sc_detect = 1;
@@ -469,6 +539,7 @@ cleanup:
 uint32 vbp_utils_destroy_context(vbp_context *pcontext)
 {
 	/* entry point, not need to validate input parameters. */
+	vbp_utils_free_statistics(pcontext);
 	vbp_utils_free_parser_memory(pcontext);
 	vbp_utils_uninitialize_context(pcontext);
 	g_free(pcontext);
@@ -483,14 +554,8 @@ uint32 vbp_utils_destroy_context(vbp_context *pcontext)
  * parse the sample buffer or parser configuration data.
  *
  */
-uint32 vbp_utils_parse_buffer(vbp_context *pcontext, uint8 *data, uint32 size,  uint8 init_data_flag)
-{	
-	/* entry point, not need to validate input parameters. */
-
-	uint32 error = VBP_OK;
-
-	/* ITRACE("buffer counter: %d",buffer_counter);  */
-
+static void vbp_utils_setup_cubby(vbp_context *pcontext, uint8 *data, uint32 size)
+{
 	/* set up emitter. */
 	pcontext->parser_cxt->emitter.cur.data = pcontext->workload1;
 	pcontext->parser_cxt->emitter.next.data = pcontext->workload2;
@@ -503,8 +568,23 @@ uint32 vbp_utils_parse_buffer(vbp_context *pcontext, uint8 *data, uint32 size,
 	pcontext->parser_cxt->parse_cubby.buf = data;
 	pcontext->parser_cxt->parse_cubby.size = size;
 	pcontext->parser_cxt->parse_cubby.phase = 0;
+}
+
+uint32 vbp_utils_parse_buffer(vbp_context *pcontext, uint8 *data, uint32 size,  uint8 init_data_flag)
+{	
+	/* entry point, not need to validate input parameters. */
+
+	uint32 error = VBP_OK;
+
+	/* ITRACE("buffer counter: %d",buffer_counter);  */
+
+	/* a whole buffer ends any frame assembled by vbp_utils_parse_partial */
+	pcontext->partial_frame = 0;
+	pcontext->frame_done = 0;
+
+	vbp_utils_setup_cubby(pcontext, data, size);
 
-	error = vbp_utils_parse_es_buffer(pcontext, init_data_flag);
+	error = vbp_utils_parse_es_buffer(pcontext, init_data_flag, NULL);
 
 	/* rolling count of buffers. */
 	if (0 == init_data_flag)
@@ -514,6 +594,63 @@ uint32 vbp_utils_parse_buffer(vbp_context *pcontext, uint8 *data, uint32 size,
 	return error;
 }
 
+/**
+ *
+ * parse part of a frame. Slices are added to the query data of the current
+ * frame until it is complete, which is the case when the next frame starts
+ * in data or the caller says data ends it.
+ *
+ */
+uint32 vbp_utils_parse_partial(vbp_context *pcontext, uint8 *data, uint32 size, uint8 last_chunk, uint32 *consumed)
+{	
+	/* entry point, not need to validate input parameters. */
+
+	viddec_pm_cxt_t *cxt = pcontext->parser_cxt;
+	uint32 error = VBP_OK;
+	int next_frame_item = -1;
+
+	*consumed = 0;
+
+	if (NULL == pcontext->func_is_next_frame)
+	{
+		return VBP_IMPL;
+	}
+
+	if (pcontext->frame_done || !pcontext->partial_frame)
+	{
+		/* start a new frame, the format resets its query data */
+		pcontext->partial_frame = 0;
+		pcontext->frame_done = 0;
+		buffer_counter++;
+	}
+
+	vbp_utils_setup_cubby(pcontext, data, size);
+
+	error = vbp_utils_parse_es_buffer(pcontext, 0, &next_frame_item);
+
+	/* keep appending to this frame from now on */
+	pcontext->partial_frame = 1;
+
+	if (VBP_OK != error)
+	{
+		return error;
+	}
+
+	if (next_frame_item >= 0)
+	{
+		/* the rest of data is the next frame */
+		*consumed = (next_frame_item > 0) ? cxt->list.data[next_frame_item - 1].edpos : 0;
+		pcontext->frame_done = 1;
+	}
+	else
+	{
+		*consumed = size;
+		pcontext->frame_done = last_chunk ? 1 : 0;
+	}
+
+	return pcontext->frame_done ? VBP_DONE : VBP_OK;
+}
+
 /**
  *
  * provide query data back to the consumer
@@ -523,8 +660,20 @@ uint32 vbp_utils_query(vbp_context *pcontext, void **data)
 {
 	/* entry point, not need to validate input parameters. */
 	uint32 error = VBP_OK;
+	double mark = 0;
+
+	if (pcontext->stats)
+	{
+		mark = g_timer_elapsed(pcontext->stats_timer, NULL);
+	}
 
 	error = pcontext->func_populate_query_data(pcontext);
+
+	if (pcontext->stats)
+	{
+		pcontext->stats->query_time += vbp_utils_lap(pcontext, &mark);
+	}
+
 	if (VBP_OK == error)
 	{
 		*data = pcontext->query_data;
@@ -536,6 +685,79 @@ uint32 vbp_utils_query(vbp_context *pcontext, void **data)
 	return error;
 }
 
+/**
+ *
+ * provide the query data of the frame being assembled by vbp_utils_parse_partial
+ *
+ */
+uint32 vbp_utils_query_incremental(vbp_context *pcontext, void **data, uint32 *frame_done)
+{
+	/* entry point, not need to validate input parameters. */
+	uint32 error = VBP_OK;
+
+	*frame_done = pcontext->frame_done;
+
+	error = vbp_utils_query(pcontext, data);
+
+	return error;
+}
+
+/**
+ *
+ * set a parser specific option
+ *
+ */
+uint32 vbp_utils_set_option(vbp_context *pcontext, uint32 option, uint32 value)
+{
+	/* entry point, not need to validate input parameters. */
+	if (VBP_OPTION_STATISTICS == option)
+	{
+		if (value)
+		{
+			if (NULL == pcontext->stats)
+			{
+				pcontext->stats = g_try_new0(vbp_statistics, 1);
+				if (NULL == pcontext->stats)
+				{
+					return VBP_MEM;
+				}
+				pcontext->stats_timer = g_timer_new();
+			}
+			memset(pcontext->stats, 0, sizeof(vbp_statistics));
+			g_timer_start(pcontext->stats_timer);
+		}
+		else
+		{
+			vbp_utils_free_statistics(pcontext);
+		}
+		return VBP_OK;
+	}
+
+	if (NULL == pcontext->func_set_option)
+	{
+		return VBP_IMPL;
+	}
+
+	return pcontext->func_set_option(pcontext, option, value);
+}
+
+/**
+ *
+ * get the statistics collected since VBP_OPTION_STATISTICS was set
+ *
+ */
+uint32 vbp_utils_get_statistics(vbp_context *pcontext, vbp_statistics *stats)
+{
+	/* entry point, not need to validate input parameters. */
+	if (NULL == pcontext->stats)
+	{
+		return VBP_INIT;
+	}
+
+	*stats = *(pcontext->stats);
+	return VBP_OK;
+}
+
 /**
  *
  * flush parsing buffer. Currently it is no op.
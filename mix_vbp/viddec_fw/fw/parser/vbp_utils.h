@@ -15,7 +15,6 @@
 #include "vbp_trace.h"
 
 #define MAGIC_NUMBER 0x0DEADBEEF
-#define MAX_WORKLOAD_ITEMS 1000
 
 /* maximum 256 slices per sample buffer */
 #define MAX_NUM_SLICES 256
@@ -38,6 +37,8 @@ typedef uint32 (*function_parse_init_data)(vbp_context* cxt);
 typedef uint32 (*function_parse_start_code)(vbp_context* cxt);
 typedef uint32 (*function_process_parsing_result)(vbp_context* cxt, int i);
 typedef uint32 (*function_populate_query_data)(vbp_context* cxt);
+typedef uint32 (*function_is_next_frame)(vbp_context* cxt, int i);
+typedef uint32 (*function_set_option)(vbp_context* cxt, uint32 option, uint32 value);
 
 
 
@@ -76,6 +77,20 @@ struct vbp_context_t
 	function_process_parsing_result func_process_parsing_result;
 	function_populate_query_data 	func_populate_query_data;
 
+	/* optional, needed for incremental parsing: does list item i start the next frame? */
+	function_is_next_frame			func_is_next_frame;
+
+	/* optional, parser specific options set through vbp_set_option. */
+	function_set_option				func_set_option;
+
+	/* incremental parsing state */
+	uint8 partial_frame;	/* query data holds the frame being assembled, append to it */
+	uint8 frame_done;		/* that frame is complete, the next chunk starts a new one */
+
+	/* statistics, NULL unless VBP_OPTION_STATISTICS is set */
+	vbp_statistics *stats;
+	GTimer *stats_timer;
+
 };
 
 /**
@@ -93,11 +108,31 @@ uint32 vbp_utils_destroy_context(vbp_context *pcontext);
  */
 uint32 vbp_utils_parse_buffer(vbp_context *pcontext, uint8 *data, uint32 size, uint8 init_data_flag);
 
+/*
+ * parse part of a frame
+ */
+uint32 vbp_utils_parse_partial(vbp_context *pcontext, uint8 *data, uint32 size, uint8 last_chunk, uint32 *consumed);
+
 /*
  * query parsing result
  */
 uint32 vbp_utils_query(vbp_context *pcontext, void **data);
 
+/*
+ * query the frame being assembled by vbp_utils_parse_partial
+ */
+uint32 vbp_utils_query_incremental(vbp_context *pcontext, void **data, uint32 *frame_done);
+
+/*
+ * set parser option
+ */
+uint32 vbp_utils_set_option(vbp_context *pcontext, uint32 option, uint32 value);
+
+/*
+ * get parser statistics
+ */
+uint32 vbp_utils_get_statistics(vbp_context *pcontext, vbp_statistics *stats);
+
 /* 
  * flush un-parsed bitstream
  */
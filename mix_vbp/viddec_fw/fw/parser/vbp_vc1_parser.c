@@ -413,8 +413,25 @@ uint32_t vbp_parse_start_code_vc1(vbp_context *pcontext)
 }
 
 
+/* 
+ * spread the 8 bits of a byte over 4 bytes of packed nibbles, bits 2m and 2m+1
+ * go to bit 0 of the high and low nibble of byte m (see va.h).
+ */
+#define VBP_NIBBLE_PAIR(b) ((((b) & 1) << 4) | (((b) >> 1) & 1))
+#define VBP_SPREAD(b) (VBP_NIBBLE_PAIR(b) | (VBP_NIBBLE_PAIR((b) >> 2) << 8) | \
+	(VBP_NIBBLE_PAIR((b) >> 4) << 16) | (VBP_NIBBLE_PAIR((b) >> 6) << 24))
+#define VBP_SPREAD4(b) VBP_SPREAD(b), VBP_SPREAD((b) + 1), VBP_SPREAD((b) + 2), VBP_SPREAD((b) + 3)
+#define VBP_SPREAD16(b) VBP_SPREAD4(b), VBP_SPREAD4((b) + 4), VBP_SPREAD4((b) + 8), VBP_SPREAD4((b) + 12)
+#define VBP_SPREAD64(b) VBP_SPREAD16(b), VBP_SPREAD16((b) + 16), VBP_SPREAD16((b) + 32), VBP_SPREAD16((b) + 48)
+
+static const uint32 spread_table_vc1[256] =
+{
+	VBP_SPREAD64(0), VBP_SPREAD64(64), VBP_SPREAD64(128), VBP_SPREAD64(192)
+};
+
+#ifdef VBP_CHECK_BITPLANE_VC1
 /**
- *
+ * bit by bit packing, to cross-check vbp_pack_bitplane_vc1
  */
 static inline uint8 vbp_get_bit_vc1(uint32 *data, uint32 *current_word, uint32 *current_bit)
 {
@@ -440,7 +457,7 @@ static inline uint8 vbp_get_bit_vc1(uint32 *data, uint32 *current_word, uint32 *
 /**
  *
  */
-static uint32 vbp_pack_bitplane_vc1(
+static uint32 vbp_pack_bitplane_ref_vc1(
 	uint32 *from_plane, 
 	uint8 *to_plane,
 	uint32 width, 
@@ -486,6 +503,100 @@ static uint32 vbp_pack_bitplane_vc1(
 }
 
 
+#endif
+
+/**
+ * pack a bitplane decoded by the parser (one bit per MB, rows starting at a 
+ * dword) into bit nibble_shift of the VA nibble per MB layout, a byte of the
+ * parser bitplane at a time.
+ */
+static uint32 vbp_pack_bitplane_vc1(
+	uint32 *from_plane, 
+	uint8 *to_plane,
+	uint32 width, 
+	uint32 height, 
+	uint32 nibble_shift)
+{
+	uint32 error = VBP_OK;
+	uint32 stride = (width + 31) / 32;
+	uint32 i, j, k, count;
+	uint32 n = 0; /* MB number, two MBs per byte */
+	uint32 value, spread;
+	uint8 *out;
+
+	for (i = 0; i < height; i++)
+	{
+		for (k = 0; k < stride; k++)
+		{
+			value = from_plane[i * stride + k];
+			count = width - k * 32;
+			if (count > 32)
+			{
+				count = 32;
+			}
+
+			out = to_plane + n / 2;
+			if (n % 2)
+			{
+				/* odd MB, low nibble */
+				*out++ |= (value & 1) << nibble_shift;
+				value >>= 1;
+				count--;
+				n++;
+			}
+			n += count;
+
+			while (count >= 8)
+			{
+				spread = spread_table_vc1[value & 0xFF] << nibble_shift;
+				out[0] |= (uint8)spread;
+				out[1] |= (uint8)(spread >> 8);
+				out[2] |= (uint8)(spread >> 16);
+				out[3] |= (uint8)(spread >> 24);
+				out += 4;
+				value >>= 8;
+				count -= 8;
+			}
+
+			if (count)
+			{
+				spread = spread_table_vc1[value & ((1 << count) - 1)] << nibble_shift;
+				for (j = 0; j < (count + 1) / 2; j++)
+				{
+					out[j] |= (uint8)(spread >> (8 * j));
+				}
+			}
+		}
+	}
+
+#ifdef VBP_CHECK_BITPLANE_VC1
+	{
+		uint32 size = (width * height + 1) / 2;
+		uint8 *packed = g_try_malloc0(size);
+		uint8 *ref = g_try_malloc0(size);
+
+		if (packed && ref)
+		{
+			/* to_plane may already hold other bitplanes, pack this one alone */
+			vbp_pack_bitplane_ref_vc1(from_plane, ref, width, height, nibble_shift);
+			for (i = 0; i < size; i++)
+			{
+				packed[i] = to_plane[i] & ((0x10 | 0x01) << nibble_shift);
+			}
+			if (memcmp(packed, ref, size) != 0)
+			{
+				ETRACE("Bitplane packing mismatch (%d x %d, bit %d).", width, height, nibble_shift);
+			}
+		}
+		g_free(packed);
+		g_free(ref);
+	}
+#endif
+
+	return error;
+}
+
+
 /**
  *
  */
@@ -41,6 +41,17 @@ int32_t viddec_pm_skip_bits(void *parent, uint32_t num_bits)
     return ret;
 }
 
+#ifdef VBP
+int32_t viddec_pm_get_ue(void *parent, uint32_t *codenum)
+{
+    viddec_pm_cxt_t *cxt;
+
+    cxt = (viddec_pm_cxt_t *)parent;
+    return viddec_pm_utils_bstream_get_ue(&(cxt->getbits), codenum);
+}
+#endif
+
+#ifndef VBP
 int32_t viddec_pm_append_workitem(void *parent, viddec_workload_item_t *item)
 {
     int32_t ret = 1;
@@ -60,6 +71,7 @@ int32_t viddec_pm_append_workitem_next(void *parent, viddec_workload_item_t *ite
     ret = viddec_emit_append(&(cxt->emitter.next), item);
     return ret;
 }
+#endif
 
 int32_t viddec_pm_get_au_pos(void *parent, uint32_t *bit, uint32_t *byte, uint8_t *is_emul)
 {
@@ -73,6 +85,7 @@ int32_t viddec_pm_get_au_pos(void *parent, uint32_t *bit, uint32_t *byte, uint8_
     
 }
 
+#ifndef VBP
 static inline int32_t viddec_pm_append_restof_pixel_data(void *parent, uint32_t cur_wkld)
 {
     int32_t ret = 1;
@@ -100,6 +113,7 @@ int32_t viddec_pm_append_pixeldata_next(void *parent)
 {
     return viddec_pm_append_restof_pixel_data(parent,  0);
 }
+#endif
 
 viddec_workload_t* viddec_pm_get_header(void *parent)
 {
@@ -139,6 +153,7 @@ uint32_t viddec_pm_get_cur_byte(void *parent, uint8_t *byte)
     return ret;
 }
 
+#ifndef VBP
 int32_t viddec_pm_append_misc_tags(void *parent, uint32_t start, uint32_t end, viddec_workload_item_t *wi, uint32_t using_next)
 {
     int32_t ret = 1;
@@ -151,6 +166,7 @@ int32_t viddec_pm_append_misc_tags(void *parent, uint32_t start, uint32_t end, v
     return ret;
 
 }
+#endif
 
 void viddec_pm_set_next_frame_error_on_eos(void *parent, uint32_t error)
 {
@@ -1,5 +1,12 @@
 #include "viddec_pm_utils_bstream.h"
 #include "viddec_fw_debug.h"
+#ifdef VBP
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
 
 /* Internal data structure for calculating required bits. */
 typedef union
@@ -18,6 +25,225 @@ static inline uint32_t viddec_pm_utils_bstream_bytesincubby(viddec_pm_utils_bstr
     return (cxt->buf_end - cxt->buf_index);
 }
 
+#ifdef VBP
+/*
+  RBSP engine (host only). Each raw byte is unescaped at most once, in chunks, ahead of the reader.
+  The emul[] table keeps enough information to report positions as offsets into the escaped NAL,
+  which is what the codecs and slice_data_bit_offset expect from viddec_pm_get_au_pos.
+*/
+#define RBSP_FILL_AHEAD 64
+
+static inline int32_t viddec_pm_utils_rbsp_add_emul(viddec_pm_utils_bstream_rbsp_cxt_t *rb)
+{
+    if(rb->emul_count == rb->emul_alloc)
+    {
+        uint32_t n = (rb->emul_alloc == 0) ? 32 : rb->emul_alloc * 2;
+        uint32_t *p = (uint32_t *)realloc(rb->emul, n * sizeof(uint32_t));
+        if(p == NULL) return -1;
+        rb->emul = p;
+        rb->emul_alloc = n;
+    }
+    rb->emul[rb->emul_count++] = rb->size;
+    return 1;
+}
+
+/* Unescape raw data until buf holds at least want bytes or the NAL is exhausted. */
+static void viddec_pm_utils_rbsp_fill(viddec_pm_utils_bstream_rbsp_cxt_t *rb, uint32_t want, uint32_t emul_reqd)
+{
+    const uint8_t *raw = rb->raw;
+
+    while((rb->size < want) && (rb->raw_pos < rb->raw_size))
+    {
+#ifdef __SSE2__
+        /* A chunk without any 0x03 can't hold an emulation byte; copy it whole. */
+        if(rb->raw_pos + 16 <= rb->raw_size)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)(raw + rb->raw_pos));
+            if(!emul_reqd || (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(3))) == 0))
+            {
+                _mm_storeu_si128((__m128i *)(rb->buf + rb->size), chunk);
+                rb->size += 16;
+                rb->raw_pos += 16;
+                rb->zeros = (raw[rb->raw_pos - 1] != 0) ? 0 : ((raw[rb->raw_pos - 2] != 0) ? 1 : 2);
+                continue;
+            }
+        }
+#endif
+        {
+            uint8_t cur_byte = raw[rb->raw_pos++];
+            if(emul_reqd && (rb->zeros == 2) && (cur_byte == 0x3))
+            {
+                if(viddec_pm_utils_rbsp_add_emul(rb) == -1)
+                {/* Can't track the offset mapping; keep the byte rather than report wrong positions. */
+                    rb->buf[rb->size++] = cur_byte;
+                }
+                rb->zeros = 0;
+            }
+            else
+            {
+                rb->buf[rb->size++] = cur_byte;
+                rb->zeros = (cur_byte != 0) ? 0 : ((rb->zeros < 2) ? rb->zeros + 1 : 2);
+            }
+        }
+    }
+    /* loads past the end of data read zeros */
+    memset(rb->buf + rb->size, 0, 8);
+}
+
+static inline void viddec_pm_utils_rbsp_refill(viddec_pm_utils_bstream_cxt_t *cxt)
+{
+    viddec_pm_utils_bstream_rbsp_cxt_t *rb = &(cxt->rbsp);
+    uint32_t word;
+
+    if(rb->rd + 4 > rb->size)
+    {
+        viddec_pm_utils_rbsp_fill(rb, rb->rd + RBSP_FILL_AHEAD, cxt->is_emul_reqd);
+    }
+    word = ((uint32_t)rb->buf[rb->rd] << 24) | ((uint32_t)rb->buf[rb->rd + 1] << 16) |
+           ((uint32_t)rb->buf[rb->rd + 2] << 8) | (uint32_t)rb->buf[rb->rd + 3];
+    rb->cache |= (uint64_t)word << (32 - rb->cache_bits);
+    rb->cache_bits += 32;
+    rb->rd += 4;
+}
+
+/* Bit position of the reader in the unescaped data */
+static inline uint32_t viddec_pm_utils_rbsp_pos(viddec_pm_utils_bstream_rbsp_cxt_t *rb)
+{
+    return (rb->rd << 3) - rb->cache_bits;
+}
+
+static inline int32_t viddec_pm_utils_rbsp_peekbits(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t *out, uint32_t num_bits, uint8_t skip)
+{
+    viddec_pm_utils_bstream_rbsp_cxt_t *rb = &(cxt->rbsp);
+
+    if((num_bits > 32) || (num_bits == 0)) return -1;
+
+    if(rb->cache_bits < num_bits)
+    {
+        viddec_pm_utils_rbsp_refill(cxt);
+    }
+    /* buf always holds the bytes behind rd unless the NAL ran out */
+    if(viddec_pm_utils_rbsp_pos(rb) + num_bits > (rb->size << 3))
+    {
+        return -1;
+    }
+    if(out != NULL)
+    {
+        *out = (uint32_t)(rb->cache >> (64 - num_bits));
+    }
+    if(skip)
+    {
+        rb->cache <<= num_bits;
+        rb->cache_bits -= num_bits;
+    }
+    return 1;
+}
+
+/* Maps the reader position back to the escaped NAL. */
+static inline uint32_t viddec_pm_utils_rbsp_au_byte(viddec_pm_utils_bstream_rbsp_cxt_t *rb, uint32_t *bit)
+{
+    uint32_t pos = viddec_pm_utils_rbsp_pos(rb);
+    uint32_t byte = pos >> 3;
+    uint32_t skipped;
+
+    *bit = pos & 0x7;
+    while((rb->emul_idx < rb->emul_count) && (rb->emul[rb->emul_idx] < byte))
+    {
+        rb->emul_idx++;
+    }
+    skipped = rb->emul_idx;
+    /* The escaped reader steps over a 0x03 only when it starts reading the byte after it. */
+    if((*bit != 0) && (skipped < rb->emul_count) && (rb->emul[skipped] == byte))
+    {
+        skipped++;
+    }
+    return byte + skipped;
+}
+
+void viddec_pm_utils_bstream_rbsp_au_offsets(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t *bit, uint32_t *byte, uint8_t *is_emul)
+{
+    viddec_pm_utils_bstream_rbsp_cxt_t *rb = &(cxt->rbsp);
+    const uint8_t *raw = rb->raw;
+    uint32_t au_byte;
+
+    au_byte = viddec_pm_utils_rbsp_au_byte(rb, bit);
+    *byte = cxt->au_pos + au_byte;
+    /* H.264 slice_data_bit_offset subtracts this to get back to the unescaped position */
+    cxt->emulation_byte_counter = au_byte - (viddec_pm_utils_rbsp_pos(rb) >> 3);
+    /* same meaning as the byte engine: sitting on a 00 that is followed by the emulation byte */
+    *is_emul = (cxt->is_emul_reqd) && (au_byte > 0) && (au_byte + 1 < rb->raw_size) &&
+        (raw[au_byte - 1] == 0) && (raw[au_byte] == 0) && (raw[au_byte + 1] == 0x3);
+}
+
+int32_t viddec_pm_utils_bstream_get_ue(viddec_pm_utils_bstream_cxt_t *cxt, uint32_t *codenum)
+{
+    viddec_pm_utils_bstream_rbsp_cxt_t *rb = &(cxt->rbsp);
+    uint32_t word, lz, len;
+
+    if(!rb->active) return 0;
+
+    if(rb->cache_bits < 32)
+    {
+        viddec_pm_utils_rbsp_refill(cxt);
+    }
+    word = (uint32_t)(rb->cache >> 32);
+    if(word == 0)
+    {/* codeNum wider than 32 bits */
+        return -1;
+    }
+    lz = __builtin_clz(word);
+    len = (lz << 1) + 1;
+    if(len <= 32)
+    {/* whole code is in the top word */
+        if(viddec_pm_utils_rbsp_peekbits(cxt, NULL, len, 1) == -1) return -1;
+        *codenum = (word >> (32 - len)) - 1;
+    }
+    else
+    {
+        uint32_t info;
+        if(viddec_pm_utils_rbsp_peekbits(cxt, NULL, lz, 1) == -1) return -1;
+        if(viddec_pm_utils_rbsp_peekbits(cxt, &info, lz + 1, 1) == -1) return -1;
+        *codenum = info - 1;
+    }
+    return 1;
+}
+
+void viddec_pm_utils_bstream_rbsp_init(viddec_pm_utils_bstream_cxt_t *cxt, const uint8_t *data, uint32_t size)
+{
+    viddec_pm_utils_bstream_rbsp_cxt_t *rb = &(cxt->rbsp);
+
+    rb->active = 0;
+    if(rb->alloc < size + 16 + 8)
+    {
+        uint8_t *p = (uint8_t *)realloc(rb->buf, size + 16 + 8);
+        if(p == NULL) return;
+        rb->buf = p;
+        rb->alloc = size + 16 + 8;
+    }
+    rb->raw = data;
+    rb->raw_size = size;
+    rb->raw_pos = 0;
+    rb->zeros = 0;
+    rb->size = 0;
+    rb->emul_count = 0;
+    rb->emul_idx = 0;
+    rb->cache = 0;
+    rb->cache_bits = 0;
+    rb->rd = 0;
+    memset(rb->buf, 0, 8);
+    rb->active = 1;
+}
+
+void viddec_pm_utils_bstream_rbsp_free(viddec_pm_utils_bstream_cxt_t *cxt)
+{
+    viddec_pm_utils_bstream_rbsp_cxt_t *rb = &(cxt->rbsp);
+
+    free(rb->buf);
+    free(rb->emul);
+    memset(rb, 0, sizeof(*rb));
+}
+#endif
+
 /*
   This function checks to see if we are at the last valid byte for current access unit.
 */
@@ -26,6 +252,26 @@ uint8_t viddec_pm_utils_bstream_nomorerbspdata(viddec_pm_utils_bstream_cxt_t *cx
     uint32_t data_remaining = 0;
     uint8_t ret = false;
 
+#ifdef VBP
+    if(cxt->rbsp.active)
+    {
+        uint32_t bit, au_byte;
+        au_byte = viddec_pm_utils_rbsp_au_byte(&(cxt->rbsp), &bit);
+        data_remaining = cxt->list->total_bytes - (cxt->au_pos + au_byte);
+        switch(data_remaining)
+        {
+            case 2:
+                ret = (cxt->rbsp.raw[au_byte + 1] == 0x0);
+                break;
+            case 1:
+                ret = true;
+                break;
+            default:
+                break;
+        }
+        return ret;
+    }
+#endif
     /* How much data is remaining including current byte to be processed.*/
     data_remaining = cxt->list->total_bytes - (cxt->au_pos + (cxt->bstrm_buf.buf_index - cxt->bstrm_buf.buf_st));
 
@@ -332,6 +578,7 @@ void viddec_pm_utils_bstream_init(viddec_pm_utils_bstream_cxt_t *cxt, viddec_pm_
 {
 #ifdef VBP
 	cxt->emulation_byte_counter = 0;
+	cxt->rbsp.active = 0;
 #endif    
 
     cxt->au_pos = 0;
@@ -352,6 +599,19 @@ int32_t viddec_pm_utils_bstream_get_current_byte(viddec_pm_utils_bstream_cxt_t *
     uint32_t data_left=0;
     viddec_pm_utils_bstream_buf_cxt_t *bstream;
 
+#ifdef VBP
+    if(cxt->rbsp.active)
+    {/* raw byte at the current position, as the byte engine returns */
+        uint32_t bit, au_byte;
+        au_byte = viddec_pm_utils_rbsp_au_byte(&(cxt->rbsp), &bit);
+        if(au_byte < cxt->rbsp.raw_size)
+        {
+            *byte = cxt->rbsp.raw[au_byte];
+            ret = 1;
+        }
+        return ret;
+    }
+#endif
     bstream = &(cxt->bstrm_buf);
     viddec_pm_utils_check_bstream_reload(cxt, &data_left);
     if(data_left != 0)
@@ -371,6 +631,12 @@ int32_t viddec_pm_utils_bstream_skipbits(viddec_pm_utils_bstream_cxt_t *cxt, uin
     uint32_t data_left=0;
     viddec_pm_utils_bstream_buf_cxt_t *bstream;
 
+#ifdef VBP
+    if(cxt->rbsp.active)
+    {
+        return viddec_pm_utils_rbsp_peekbits(cxt, NULL, num_bits, 1);
+    }
+#endif
     bstream = &(cxt->bstrm_buf);
     viddec_pm_utils_check_bstream_reload(cxt, &data_left);
     if((num_bits <= 32) && (num_bits > 0) && (data_left != 0))
@@ -406,6 +672,12 @@ int32_t viddec_pm_utils_bstream_peekbits(viddec_pm_utils_bstream_cxt_t *cxt, uin
 {
     uint32_t data_left=0;
     int32_t ret = -1;
+#ifdef VBP
+    if(cxt->rbsp.active)
+    {
+        return viddec_pm_utils_rbsp_peekbits(cxt, out, num_bits, skip);
+    }
+#endif
     /* STEP 1: Make sure that we have at least minimum data before we calculate bits */
     viddec_pm_utils_check_bstream_reload(cxt, &data_left);
 
@@ -752,6 +752,29 @@ MIX_RESULT mix_framemanager_dequeue(MixFrameManager *fm, MixVideoFrame **mvf) {
 	return ret;
 }
 
+MIX_RESULT mix_framemanager_get_queue_depth(MixFrameManager *fm, guint *depth) {
+
+	if (!MIX_IS_FRAMEMANAGER(fm)) {
+		return MIX_RESULT_INVALID_PARAM;
+	}
+
+	if (!depth) {
+		return MIX_RESULT_INVALID_PARAM;
+	}
+
+	if (!fm->initialized) {
+		return MIX_RESULT_NOT_INIT;
+	}
+
+	g_mutex_lock(fm->lock);
+
+	*depth = g_queue_get_length(fm->frame_queue);
+
+	g_mutex_unlock(fm->lock);
+
+	return MIX_RESULT_SUCCESS;
+}
+
 MIX_RESULT mix_framemanager_eos(MixFrameManager *fm) {
 
 	MIX_RESULT ret = MIX_RESULT_FAIL;
@@ -155,6 +155,11 @@ MIX_RESULT mix_framemanager_enqueue(MixFrameManager *fm, MixVideoFrame *mvf);
  */
 MIX_RESULT mix_framemanager_dequeue(MixFrameManager *fm, MixVideoFrame **mvf);
 
+/*
+ * Number of decoded frames waiting to be dequeued by the client.
+ */
+MIX_RESULT mix_framemanager_get_queue_depth(MixFrameManager *fm, guint *depth);
+
 /*
  * End of stream.
  */
@@ -91,6 +91,10 @@ MIX_RESULT mix_video_get_config_default(MixVideo * mix,
 MIX_RESULT mix_video_decode_default(MixVideo * mix, MixBuffer * bufin[],
 		gint bufincnt, MixVideoDecodeParams * decode_params);
 
+MIX_RESULT mix_video_decode_batch_default(MixVideo * mix, MixBuffer * bufin[],
+		gint bufincnt, MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed);
+
 MIX_RESULT mix_video_get_frame_default(MixVideo * mix, MixVideoFrame ** frame);
 
 MIX_RESULT mix_video_release_frame_default(MixVideo * mix,
@@ -166,6 +170,7 @@ static void mix_video_class_init(MixVideoClass * klass) {
 	klass->get_mix_buffer_func = mix_video_get_mixbuffer_default;
 	klass->release_mix_buffer_func = mix_video_release_mixbuffer_default;
 	klass->get_max_coded_buffer_size_func = mix_video_get_max_coded_buffer_size_default;
+	klass->decode_batch_func = mix_video_decode_batch_default;
 }
 
 MixVideo *mix_video_new(void) {
@@ -1018,6 +1023,42 @@ MIX_RESULT mix_video_decode_default(MixVideo * mix, MixBuffer * bufin[],
 	return ret;
 }
 
+MIX_RESULT mix_video_decode_batch_default(MixVideo * mix, MixBuffer * bufin[],
+		gint bufincnt, MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed) {
+
+	MIX_RESULT ret = MIX_RESULT_FAIL;
+	MixVideoPrivate *priv = NULL;
+	gint i = 0;
+
+	LOG_V( "Begin\n");
+
+	if(!bufin || bufincnt <= 0 || !decode_params || !results || !consumed) {
+		LOG_E( "!bufin || bufincnt <= 0 || !decode_params || !results || !consumed\n");
+		return MIX_RESULT_NULL_PTR;
+	}
+
+	//Entries stay MIX_RESULT_FAIL if the batch is rejected before decoding
+	*consumed = 0;
+	for (i = 0; i < bufincnt; i++)
+		results[i] = MIX_RESULT_FAIL;
+
+	CHECK_INIT_CONFIG(mix, priv);
+
+	//Surfaces are checked by the format before each access unit, so that
+	//a batch stops where the pool runs out rather than losing a frame
+	g_mutex_lock(priv->objlock);
+
+	ret = mix_videofmt_decode_batch(priv->video_format, bufin, bufincnt,
+			decode_params, results, consumed);
+
+	g_mutex_unlock(priv->objlock);
+
+	LOG_V( "End\n");
+
+	return ret;
+}
+
 MIX_RESULT mix_video_get_frame_default(MixVideo * mix, MixVideoFrame ** frame) {
 
 	LOG_V( "Begin\n");
@@ -1521,6 +1562,21 @@ MIX_RESULT mix_video_decode(MixVideo * mix, MixBuffer * bufin[], gint bufincnt,
 
 }
 
+MIX_RESULT mix_video_decode_batch(MixVideo * mix, MixBuffer * bufin[], gint bufincnt,
+		MixVideoDecodeParams * decode_params[], MIX_RESULT results[],
+		gint * consumed) {
+
+	MixVideoClass *klass = NULL;
+	CHECK_AND_GET_MIX_CLASS(mix, klass);
+
+	if (klass->decode_batch_func) {
+		return klass->decode_batch_func(mix, bufin, bufincnt,
+				decode_params, results, consumed);
+	}
+	return MIX_RESULT_NOTIMPL;
+
+}
+
 MIX_RESULT mix_video_get_frame(MixVideo * mix, MixVideoFrame ** frame) {
 
 	MixVideoClass *klass = NULL;
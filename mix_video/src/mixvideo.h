@@ -56,6 +56,10 @@ typedef MIX_RESULT (*MixVideoGetConfigFunc)(MixVideo * mix,
 typedef MIX_RESULT (*MixVideoDecodeFunc)(MixVideo * mix, MixBuffer * bufin[],
 		gint bufincnt, MixVideoDecodeParams * decode_params);
 
+typedef MIX_RESULT (*MixVideoDecodeBatchFunc)(MixVideo * mix, MixBuffer * bufin[],
+		gint bufincnt, MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed);
+
 typedef MIX_RESULT (*MixVideoGetFrameFunc)(MixVideo * mix,
 		MixVideoFrame ** frame);
 
@@ -130,6 +134,7 @@ struct _MixVideoClass {
 	MixVideoGetMixBufferFunc get_mix_buffer_func;
 	MixVideoReleaseMixBufferFunc release_mix_buffer_func;
 	MixVideoGetMaxCodedBufferSizeFunc get_max_coded_buffer_size_func;
+	MixVideoDecodeBatchFunc decode_batch_func;
 };
 
 /**
@@ -184,6 +189,32 @@ MIX_RESULT mix_video_get_config(MixVideo * mix,
 MIX_RESULT mix_video_decode(MixVideo * mix, MixBuffer * bufin[], gint bufincnt,
 		MixVideoDecodeParams * decode_params);
 
+/**
+ * mix_video_decode_batch:
+ * @mix: #MixVideo object.
+ * @bufin: Array of #MixBuffer, one complete access unit per element.
+ * @bufincnt: Number of access units in @bufin.
+ * @decode_params: Array of #MixVideoDecodeParams, one per access unit.
+ * @results: Caller allocated array of @bufincnt entries receiving the status of each access unit.
+ * @consumed: Receives the number of access units taken by the decoder.
+ * @returns: #MIX_RESULT_SUCCESS if every access unit decoded or was dropped,
+ * #MIX_RESULT_OUTOFSURFACES if the batch stopped early, #MIX_RESULT_FAIL if any
+ * access unit failed.
+ *
+ * Decode several access units in one call. Formats that support it parse
+ * and submit the whole batch under a single lock acquisition.
+ *
+ * Decoding stops at the first access unit for which no surface is available.
+ * That access unit and the ones after it are not queued, their @results
+ * entries are #MIX_RESULT_OUTOFSURFACES and the caller resubmits them starting
+ * at bufin[*@consumed]. Every @results entry is set, also when the whole batch
+ * is rejected. An access unit skipped by the frame skip policy gets
+ * #MIX_RESULT_DROPFRAME, which does not count as a failure.
+ */
+MIX_RESULT mix_video_decode_batch(MixVideo * mix, MixBuffer * bufin[], gint bufincnt,
+		MixVideoDecodeParams * decode_params[], MIX_RESULT results[],
+		gint * consumed);
+
 MIX_RESULT mix_video_get_frame(MixVideo * mix, MixVideoFrame ** frame);
 
 MIX_RESULT mix_video_release_frame(MixVideo * mix, MixVideoFrame * frame);
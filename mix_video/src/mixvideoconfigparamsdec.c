@@ -49,6 +49,7 @@ static void mix_videoconfigparamsdec_init(MixVideoConfigParamsDec * self) {
 	self->rate_control = 0;
 	self->mixbuffer_pool_size = 0;
 	self->extra_surface_allocation = 0;
+	self->skip_queue_depth = 0;
 
 	/* TODO: initialize other properties */
 	self->reserved1 = NULL;
@@ -164,6 +165,7 @@ gboolean mix_videoconfigparamsdec_copy(MixParams * target, const MixParams * src
 		this_target->rate_control = this_src->rate_control;
 		this_target->mixbuffer_pool_size = this_src->mixbuffer_pool_size;
 		this_target->extra_surface_allocation = this_src->extra_surface_allocation;
+		this_target->skip_queue_depth = this_src->skip_queue_depth;
 
 		/* copy properties of non-primitive */
 
@@ -264,6 +266,10 @@ gboolean mix_videoconfigparamsdec_equal(MixParams * first, MixParams * second) {
 			goto not_equal;
 		}
 
+		if (this_first->skip_queue_depth != this_second->skip_queue_depth) {
+			goto not_equal;
+		}
+
 		/* check the equalitiy of the none-primitive type properties */
 
 		/* MixIOVec header */
@@ -529,6 +535,23 @@ MIX_RESULT mix_videoconfigparamsdec_get_extra_surface_allocation(
 
 }
 
+MIX_RESULT mix_videoconfigparamsdec_set_skip_queue_depth(
+		MixVideoConfigParamsDec * obj,
+                guint skip_queue_depth) {
 
+	MIX_VIDEOCONFIGPARAMSDEC_SETTER_CHECK_INPUT (obj);
 
+	obj->skip_queue_depth = skip_queue_depth;
+	return MIX_RESULT_SUCCESS;
 
+}
+
+MIX_RESULT mix_videoconfigparamsdec_get_skip_queue_depth(
+		MixVideoConfigParamsDec * obj,
+                guint *skip_queue_depth) {
+
+	MIX_VIDEOCONFIGPARAMSDEC_GETTER_CHECK_INPUT (obj, skip_queue_depth);
+	*skip_queue_depth = obj->skip_queue_depth;
+	return MIX_RESULT_SUCCESS;
+
+}
@@ -82,6 +82,10 @@ struct _MixVideoConfigParamsDec {
 
 	guint mixbuffer_pool_size;
 	guint extra_surface_allocation;
+
+	/* drop non-reference frames before decode when this many frames are
+	 * waiting in the output queue; 0 disables decode-time skipping */
+	guint skip_queue_depth;
 	
 	void *reserved1;
 	void *reserved2;
@@ -190,6 +194,12 @@ MIX_RESULT mix_videoconfigparamsdec_set_extra_surface_allocation(MixVideoConfigP
 MIX_RESULT mix_videoconfigparamsdec_get_extra_surface_allocation(MixVideoConfigParamsDec * obj,
 		guint *extra_surface_allocation);
 
+MIX_RESULT mix_videoconfigparamsdec_set_skip_queue_depth(MixVideoConfigParamsDec * obj,
+		guint skip_queue_depth);
+
+MIX_RESULT mix_videoconfigparamsdec_get_skip_queue_depth(MixVideoConfigParamsDec * obj,
+		guint *skip_queue_depth);
+
 /* TODO: Add getters and setters for other properties */
 
 #endif /* __MIX_VIDEOCONFIGPARAMSDEC_H__ */
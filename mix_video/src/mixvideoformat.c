@@ -26,6 +26,11 @@ static MIX_RESULT
 		mix_videofmt_decode_default(MixVideoFormat *mix, 
 		MixBuffer * bufin[], gint bufincnt, 
                 MixVideoDecodeParams * decode_params);
+static MIX_RESULT
+		mix_videofmt_decode_batch_default(MixVideoFormat *mix, 
+		MixBuffer * bufin[], gint bufincnt, 
+                MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed);
 static MIX_RESULT mix_videofmt_flush_default(MixVideoFormat *mix);
 static MIX_RESULT mix_videofmt_eos_default(MixVideoFormat *mix);
 static MIX_RESULT mix_videofmt_deinitialize_default(MixVideoFormat *mix);
@@ -58,6 +63,7 @@ static void mix_videoformat_init(MixVideoFormat * self) {
 	self->picture_height = 0;
 	self->parse_in_progress = FALSE;
 	self->current_timestamp = 0;
+	self->skip_queue_depth = 0;
 }
 
 static void mix_videoformat_class_init(MixVideoFormatClass * klass) {
@@ -72,6 +78,7 @@ static void mix_videoformat_class_init(MixVideoFormatClass * klass) {
 	klass->getcaps = mix_videofmt_getcaps_default;
 	klass->initialize = mix_videofmt_initialize_default;
 	klass->decode = mix_videofmt_decode_default;
+	klass->decode_batch = mix_videofmt_decode_batch_default;
 	klass->flush = mix_videofmt_flush_default;
 	klass->eos = mix_videofmt_eos_default;
 	klass->deinitialize = mix_videofmt_deinitialize_default;
@@ -249,6 +256,12 @@ static MIX_RESULT mix_videofmt_initialize_default(MixVideoFormat *mix,
 		LOG_E( "Error getting picture_res\n");
 		goto cleanup;
 	}
+	res = mix_videoconfigparamsdec_get_skip_queue_depth(config_params, &(mix->skip_queue_depth));
+	if (res != MIX_RESULT_SUCCESS)
+	{
+		LOG_E( "Error getting skip_queue_depth\n");
+		goto cleanup;
+	}
 
 	if (mix->inputbufqueue)
 	{
@@ -319,6 +332,33 @@ static MIX_RESULT mix_videofmt_decode_default(MixVideoFormat *mix,
 	return MIX_RESULT_SUCCESS;
 }
 
+static MIX_RESULT mix_videofmt_decode_batch_default(MixVideoFormat *mix, 
+		MixBuffer * bufin[], gint bufincnt, 
+                MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed) {
+
+	MixVideoFormatClass *klass = MIX_VIDEOFORMAT_GET_CLASS(mix);
+	MIX_RESULT ret = MIX_RESULT_SUCCESS;
+	gint i = 0;
+
+	//Formats without a batched path decode one access unit per call
+	for (i = 0; i < bufincnt; i++)
+	{
+		if (mix_surfacepool_check_available(mix->surfacepool) == MIX_RESULT_POOLEMPTY)
+		{
+			LOG_I( "Out of surface at access unit %d\n", i);
+			break;
+		}
+
+		results[i] = klass->decode(mix, &bufin[i], 1, decode_params[i]);
+		//A dropped frame is reported in results[i] but does not fail the batch
+		if (results[i] != MIX_RESULT_SUCCESS && results[i] != MIX_RESULT_DROPFRAME)
+			ret = MIX_RESULT_FAIL;
+	}
+
+	return mix_videofmt_decode_batch_stop(i, bufincnt, results, consumed, ret);
+}
+
 static MIX_RESULT mix_videofmt_flush_default(MixVideoFormat *mix) {
 	return MIX_RESULT_SUCCESS;
 }
@@ -373,6 +413,32 @@ MIX_RESULT mix_videofmt_decode(MixVideoFormat *mix, MixBuffer * bufin[],
 	return MIX_RESULT_FAIL;
 }
 
+MIX_RESULT mix_videofmt_decode_batch(MixVideoFormat *mix, MixBuffer * bufin[],
+                gint bufincnt, MixVideoDecodeParams * decode_params[],
+                MIX_RESULT results[], gint * consumed) {
+
+	MixVideoFormatClass *klass = MIX_VIDEOFORMAT_GET_CLASS(mix);
+	if (klass->decode_batch) {
+		return klass->decode_batch(mix, bufin, bufincnt, decode_params,
+				results, consumed);
+	}
+
+	return MIX_RESULT_FAIL;
+}
+
+MIX_RESULT mix_videofmt_decode_batch_stop(gint stop, gint bufincnt,
+		MIX_RESULT results[], gint * consumed, MIX_RESULT ret) {
+
+	gint i = 0;
+
+	//Access units from stop on were not queued, the caller resubmits them
+	*consumed = stop;
+	for (i = stop; i < bufincnt; i++)
+		results[i] = MIX_RESULT_OUTOFSURFACES;
+
+	return (stop < bufincnt) ? MIX_RESULT_OUTOFSURFACES : ret;
+}
+
 MIX_RESULT mix_videofmt_flush(MixVideoFormat *mix) {
 	MixVideoFormatClass *klass = MIX_VIDEOFORMAT_GET_CLASS(mix);
 	if (klass->flush) {
@@ -391,6 +457,23 @@ MIX_RESULT mix_videofmt_eos(MixVideoFormat *mix) {
 	return MIX_RESULT_FAIL;
 }
 
+gboolean mix_videofmt_skip_nonref_frame(MixVideoFormat *mix) {
+
+	guint depth = 0;
+
+	if (mix->skip_queue_depth == 0)
+		return FALSE;
+
+	if (mix_framemanager_get_queue_depth(mix->framemgr, &depth) != MIX_RESULT_SUCCESS)
+		return FALSE;
+
+	if (depth < mix->skip_queue_depth)
+		return FALSE;
+
+	LOG_V( "Output queue depth %d, skipping non-reference frame\n", depth);
+	return TRUE;
+}
+
 MIX_RESULT mix_videofmt_deinitialize(MixVideoFormat *mix) {
 	MixVideoFormatClass *klass = MIX_VIDEOFORMAT_GET_CLASS(mix);
 	if (klass->deinitialize) {
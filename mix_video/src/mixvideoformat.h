@@ -51,6 +51,10 @@ typedef MIX_RESULT (*MixVideoFmtInitializeFunc)(MixVideoFormat *mix,
 typedef MIX_RESULT (*MixVideoFmtDecodeFunc)(MixVideoFormat *mix, 
 		MixBuffer * bufin[], gint bufincnt, 
 		MixVideoDecodeParams * decode_params);
+typedef MIX_RESULT (*MixVideoFmtDecodeBatchFunc)(MixVideoFormat *mix, 
+		MixBuffer * bufin[], gint bufincnt, 
+		MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed);
 typedef MIX_RESULT (*MixVideoFmtFlushFunc)(MixVideoFormat *mix);
 typedef MIX_RESULT (*MixVideoFmtEndOfStreamFunc)(MixVideoFormat *mix);
 typedef MIX_RESULT (*MixVideoFmtDeinitializeFunc)(MixVideoFormat *mix);
@@ -80,6 +84,7 @@ struct _MixVideoFormat {
 	gboolean parse_in_progress;
 	gboolean discontinuity_frame_in_progress;
 	guint64 current_timestamp;
+	guint skip_queue_depth;
 	MixBufferPool *inputbufpool;
 	GQueue *inputbufqueue;
 };
@@ -99,6 +104,7 @@ struct _MixVideoFormatClass {
 	MixVideoFmtGetCapsFunc getcaps;
 	MixVideoFmtInitializeFunc initialize;
 	MixVideoFmtDecodeFunc decode;
+	MixVideoFmtDecodeBatchFunc decode_batch;
 	MixVideoFmtFlushFunc flush;
 	MixVideoFmtEndOfStreamFunc eos;
 	MixVideoFmtDeinitializeFunc deinitialize;
@@ -151,8 +157,21 @@ MIX_RESULT mix_videofmt_initialize(MixVideoFormat *mix,
 MIX_RESULT mix_videofmt_decode(MixVideoFormat *mix, MixBuffer * bufin[],
                 gint bufincnt, MixVideoDecodeParams * decode_params);
 
+MIX_RESULT mix_videofmt_decode_batch(MixVideoFormat *mix, MixBuffer * bufin[],
+                gint bufincnt, MixVideoDecodeParams * decode_params[],
+                MIX_RESULT results[], gint * consumed);
+
+/* used by decode_batch implementations that stop at access unit @stop
+ * because no surface is left */
+MIX_RESULT mix_videofmt_decode_batch_stop(gint stop, gint bufincnt,
+		MIX_RESULT results[], gint * consumed, MIX_RESULT ret);
+
 MIX_RESULT mix_videofmt_flush(MixVideoFormat *mix);
 
+/* Helper for derived classes: TRUE if a non-reference frame should be
+ * dropped before decode because the output queue is backed up */
+gboolean mix_videofmt_skip_nonref_frame(MixVideoFormat *mix);
+
 MIX_RESULT mix_videofmt_eos(MixVideoFormat *mix);
 
 MIX_RESULT mix_videofmt_deinitialize(MixVideoFormat *mix);
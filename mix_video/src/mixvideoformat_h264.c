@@ -64,6 +64,7 @@ static void mix_videoformat_h264_class_init(
 	video_format_class->getcaps = mix_videofmt_h264_getcaps;
 	video_format_class->initialize = mix_videofmt_h264_initialize;
 	video_format_class->decode = mix_videofmt_h264_decode;
+	video_format_class->decode_batch = mix_videofmt_h264_decode_batch;
 	video_format_class->flush = mix_videofmt_h264_flush;
 	video_format_class->eos = mix_videofmt_h264_eos;
 	video_format_class->deinitialize = mix_videofmt_h264_deinitialize;
@@ -562,62 +563,22 @@ MIX_RESULT mix_videofmt_h264_initialize(MixVideoFormat *mix,
 	return ret;
 }
 
-MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
-                gint bufincnt, MixVideoDecodeParams * decode_params) {
+/*
+ * Parse and decode one access unit spread over bufin[].  The caller must
+ * hold mix->objectlock; this is shared by _decode() and _decode_batch() so
+ * that a batch of access units is handled under a single lock acquisition.
+ */
+static MIX_RESULT mix_videofmt_h264_decode_locked(MixVideoFormat *mix,
+		MixBuffer * bufin[], gint bufincnt,
+		guint64 ts, gboolean discontinuity) {
 
         uint32 pret = 0;
 	int i = 0;
-        MixVideoFormat *parent = NULL;
+        MixVideoFormat *parent = MIX_VIDEOFORMAT(mix);
 	MIX_RESULT ret = MIX_RESULT_SUCCESS;
-	guint64 ts = 0;
 	vbp_data_h264 *data = NULL;
-	gboolean discontinuity = FALSE;
 	MixInputBufferEntry *bufentry = NULL;
 
-        LOG_V( "Begin\n");
-
-        if (mix == NULL || bufin == NULL || decode_params == NULL )
-	{
-		LOG_E( "NUll pointer passed in\n");
-                return MIX_RESULT_NULL_PTR;
-	}
-
-	/* Chainup parent method.
-		We are not chaining up to parent method for now.
-	 */
-
-#if 0
-        if (parent_class->decode) {
-                return parent_class->decode(mix, bufin, bufincnt,
-                                        decode_params);
-	}
-#endif
-
-	if (!MIX_IS_VIDEOFORMAT_H264(mix))
-		return MIX_RESULT_INVALID_PARAM;
-
-	parent = MIX_VIDEOFORMAT(mix);
-
-
-	ret = mix_videodecodeparams_get_timestamp(decode_params, 
-			&ts);
-	if (ret != MIX_RESULT_SUCCESS)
-	{
-		return MIX_RESULT_FAIL;
-	}
-
-	ret = mix_videodecodeparams_get_discontinuity(decode_params, 
-			&discontinuity);
-	if (ret != MIX_RESULT_SUCCESS)
-	{
-		return MIX_RESULT_FAIL;
-	}
-
-	//From now on, we exit this function through cleanup:
-
-	LOG_V( "Locking\n");
-        g_mutex_lock(parent->objectlock);
-
 	LOG_V( "parse in progress is %d\n", parent->parse_in_progress);
 	//If this is a new frame and we haven't retrieved parser
 	//  workload data from previous frame yet, do so
@@ -631,9 +592,8 @@ MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
 
 		if ((pret != VBP_OK) || (data == NULL))
         	{
-			ret = MIX_RESULT_FAIL;
 			LOG_E( "Error initializing parser\n");
-               		goto cleanup;
+               		return MIX_RESULT_FAIL;
         	}
 	
 		LOG_V( "Queried for last frame data\n");
@@ -680,9 +640,8 @@ MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
 
 			if ((pret != VBP_OK) || (data == NULL))
         		{
-				ret = MIX_RESULT_FAIL;
 				LOG_E( "Error getting parser data\n");
-               			goto cleanup;
+               			return MIX_RESULT_FAIL;
         		}
 
 			LOG_V( "Called query for current frame\n");
@@ -696,9 +655,8 @@ MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
 				MixInputBufferEntry));
 			if (bufentry == NULL)
         		{
-				ret = MIX_RESULT_NO_MEMORY;
 				LOG_E( "Error allocating bufentry\n");
-               			goto cleanup;
+               			return MIX_RESULT_NO_MEMORY;
         		}
 
 			bufentry->buf = bufin[i];
@@ -746,9 +704,8 @@ MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
 				(MixInputBufferEntry));
 			if (bufentry == NULL)
         		{
-				ret = MIX_RESULT_NO_MEMORY;
 				LOG_E( "Error allocating bufentry\n");
-               			goto cleanup;
+               			return MIX_RESULT_NO_MEMORY;
         		}
 			bufentry->buf = bufin[i];
 	LOG_V( "Setting bufentry %x for mixbuffer %x ts to %"G_GINT64_FORMAT"\n", (guint)bufentry, (guint)bufentry->buf, ts);
@@ -767,7 +724,147 @@ MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
 	}
 
 
-	cleanup:
+	return ret;
+}
+
+MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
+                gint bufincnt, MixVideoDecodeParams * decode_params) {
+
+        MixVideoFormat *parent = NULL;
+	MIX_RESULT ret = MIX_RESULT_SUCCESS;
+	guint64 ts = 0;
+	gboolean discontinuity = FALSE;
+
+        LOG_V( "Begin\n");
+
+        if (mix == NULL || bufin == NULL || decode_params == NULL )
+	{
+		LOG_E( "NUll pointer passed in\n");
+                return MIX_RESULT_NULL_PTR;
+	}
+
+	/* Chainup parent method.
+		We are not chaining up to parent method for now.
+	 */
+
+#if 0
+        if (parent_class->decode) {
+                return parent_class->decode(mix, bufin, bufincnt,
+                                        decode_params);
+	}
+#endif
+
+	if (!MIX_IS_VIDEOFORMAT_H264(mix))
+		return MIX_RESULT_INVALID_PARAM;
+
+	parent = MIX_VIDEOFORMAT(mix);
+
+
+	ret = mix_videodecodeparams_get_timestamp(decode_params, 
+			&ts);
+	if (ret != MIX_RESULT_SUCCESS)
+	{
+		return MIX_RESULT_FAIL;
+	}
+
+	ret = mix_videodecodeparams_get_discontinuity(decode_params, 
+			&discontinuity);
+	if (ret != MIX_RESULT_SUCCESS)
+	{
+		return MIX_RESULT_FAIL;
+	}
+
+	LOG_V( "Locking\n");
+        g_mutex_lock(parent->objectlock);
+
+	ret = mix_videofmt_h264_decode_locked(mix, bufin, bufincnt,
+			ts, discontinuity);
+
+	LOG_V( "Unlocking\n");
+ 	g_mutex_unlock(parent->objectlock);
+
+        LOG_V( "End\n");
+
+	return ret;
+}
+
+MIX_RESULT mix_videofmt_h264_decode_batch(MixVideoFormat *mix,
+		MixBuffer * bufin[], gint bufincnt,
+		MixVideoDecodeParams * decode_params[],
+		MIX_RESULT results[], gint * consumed) {
+
+        MixVideoFormat *parent = NULL;
+	MIX_RESULT ret = MIX_RESULT_SUCCESS;
+	MIX_RESULT au_ret = MIX_RESULT_SUCCESS;
+	guint64 ts = 0;
+	gboolean discontinuity = FALSE;
+	gint i = 0;
+
+        LOG_V( "Begin\n");
+
+        if (mix == NULL || bufin == NULL || decode_params == NULL || results == NULL || consumed == NULL)
+	{
+		LOG_E( "NUll pointer passed in\n");
+                return MIX_RESULT_NULL_PTR;
+	}
+
+	if (!MIX_IS_VIDEOFORMAT_H264(mix))
+		return MIX_RESULT_INVALID_PARAM;
+
+	parent = MIX_VIDEOFORMAT(mix);
+
+	LOG_V( "Locking for %d access units\n", bufincnt);
+        g_mutex_lock(parent->objectlock);
+
+	for (i = 0; i < bufincnt; i++)
+	{
+		//Stop before queueing an access unit that would find no surface;
+		//it and the rest of the batch are left to the caller
+		if (mix_surfacepool_check_available(parent->surfacepool) == MIX_RESULT_POOLEMPTY)
+		{
+			LOG_I( "Out of surface at access unit %d\n", i);
+			break;
+		}
+
+		if (bufin[i] == NULL || decode_params[i] == NULL)
+		{
+			LOG_E( "NUll pointer passed in for access unit %d\n", i);
+			results[i] = MIX_RESULT_NULL_PTR;
+			ret = MIX_RESULT_FAIL;
+			continue;
+		}
+
+		au_ret = mix_videodecodeparams_get_timestamp(decode_params[i], &ts);
+		if (au_ret == MIX_RESULT_SUCCESS)
+		{
+			au_ret = mix_videodecodeparams_get_discontinuity(
+					decode_params[i], &discontinuity);
+		}
+
+		if (au_ret == MIX_RESULT_SUCCESS)
+		{
+			//Each access unit is a complete frame, so the parser is
+			//driven once per element within the same vbp session
+			au_ret = mix_videofmt_h264_decode_locked(mix, &bufin[i], 1,
+					ts, discontinuity);
+		}
+
+		results[i] = au_ret;
+		if (au_ret == MIX_RESULT_DROPFRAME)
+		{
+			//A non-reference frame skipped while the client catches up
+			//is not a failure; results[i] tells the caller it was dropped
+			LOG_V( "Dropped access unit %d\n", i);
+		}
+		else if (au_ret != MIX_RESULT_SUCCESS)
+		{
+			//Keep going; the caller gets per access unit status
+			LOG_E( "Decode failed for access unit %d\n", i);
+			ret = MIX_RESULT_FAIL;
+		}
+	}
+
+	ret = mix_videofmt_decode_batch_stop(i, bufincnt, results, consumed, ret);
 
 	LOG_V( "Unlocking\n");
  	g_mutex_unlock(parent->objectlock);
@@ -1408,6 +1505,23 @@ MIX_RESULT mix_videofmt_h264_process_decode(MixVideoFormat *mix,
 		return MIX_RESULT_NULL_PTR;
 	}
 
+	//Drop non-reference pictures before any VA buffers are created
+	//if the client has fallen behind
+	if (mix->skip_queue_depth)
+	{
+		gboolean is_reference = FALSE;
+		for (i = 0; i < data->num_pictures; i++)
+		{
+			if (data->pic_data[i].pic_parms->pic_fields.bits.reference_pic_flag)
+				is_reference = TRUE;
+		}
+		if (!is_reference && mix_videofmt_skip_nonref_frame(mix))
+		{
+			mix_videofmt_h264_release_input_buffers(mix, timestamp);
+			return MIX_RESULT_DROPFRAME;
+		}
+	}
+
 	//Get a frame from the surface pool
 	MixVideoFrame *frame = NULL;
 
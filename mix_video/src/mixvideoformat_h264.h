@@ -96,6 +96,10 @@ MIX_RESULT mix_videofmt_h264_initialize(MixVideoFormat *mix,
 				  VADisplay va_display);
 MIX_RESULT mix_videofmt_h264_decode(MixVideoFormat *mix, MixBuffer * bufin[],
                 gint bufincnt, MixVideoDecodeParams * decode_params);
+MIX_RESULT mix_videofmt_h264_decode_batch(MixVideoFormat *mix,
+                MixBuffer * bufin[], gint bufincnt,
+                MixVideoDecodeParams * decode_params[],
+                MIX_RESULT results[], gint * consumed);
 MIX_RESULT mix_videofmt_h264_flush(MixVideoFormat *mix);
 MIX_RESULT mix_videofmt_h264_eos(MixVideoFormat *mix);
 MIX_RESULT mix_videofmt_h264_deinitialize(MixVideoFormat *mix);
@@ -609,6 +609,7 @@ MIX_RESULT mix_videofmt_mp42_process_decode(MixVideoFormat *mix,
 
 	MixBuffer *mix_buffer = NULL;
 	gboolean is_from_queued_data = FALSE;
+	gboolean is_skipped = FALSE;
 
 	LOG_V("Begin\n");
 
@@ -871,6 +872,16 @@ MIX_RESULT mix_videofmt_mp42_process_decode(MixVideoFormat *mix,
 			ret = MIX_RESULT_DROPFRAME;
 			goto cleanup;
 		}
+
+		/*
+		 * B-VOPs are never referenced, so drop them before any VA
+		 * buffers are created if the client has fallen behind
+		 */
+		if (mix_videofmt_skip_nonref_frame(mix)) {
+			is_skipped = TRUE;
+			ret = MIX_RESULT_DROPFRAME;
+			goto cleanup;
+		}
 	}
 
 	buffer_ids = g_malloc(sizeof(VABufferID) * buffer_id_number);
@@ -1097,7 +1108,8 @@ MIX_RESULT mix_videofmt_mp42_process_decode(MixVideoFormat *mix,
 		mix_videoframe_unref(frame);
 	}
 
-	if (ret != MIX_RESULT_SUCCESS) {
+	/* A skipped B-VOP leaves the rest of a packed frame intact */
+	if (ret != MIX_RESULT_SUCCESS && !is_skipped) {
 		mix_videoformat_mp42_flush_packed_stream_queue(
 				self->packed_stream_queue);
 	}
@@ -1376,6 +1376,16 @@ MIX_RESULT mix_videofmt_vc1_process_decode(
 		
 	}
 
+	//B and BI pictures are never referenced, so they can be dropped
+	//before any VA buffers are created if the client has fallen behind
+	if ((data->pic_data[0].pic_parms->picture_fields.bits.picture_type == VC1_PTYPE_B ||
+		data->pic_data[0].pic_parms->picture_fields.bits.picture_type == VC1_PTYPE_BI) &&
+		mix_videofmt_skip_nonref_frame(mix))
+	{
+		ret = MIX_RESULT_DROPFRAME;
+		goto cleanup;
+	}
+
 	ret = mix_surfacepool_get(mix->surfacepool, &frame);
 	if (ret != MIX_RESULT_SUCCESS)
 	{
@@ -0,0 +1,168 @@
+#include "../../src/mixvideoformat.h"
+
+/*
+ * A batch that runs out of surfaces partway stops at that access unit:
+ * earlier access units are decoded, the rest are not queued, report
+ * MIX_RESULT_OUTOFSURFACES and are decoded once resubmitted.
+ */
+
+#define NUM_SURFACES 4
+#define NUM_UNITS 6
+
+typedef struct _TestFormat TestFormat;
+typedef struct _TestFormatClass TestFormatClass;
+
+struct _TestFormat {
+	MixVideoFormat parent;
+};
+
+struct _TestFormatClass {
+	MixVideoFormatClass parent_class;
+};
+
+G_DEFINE_TYPE (TestFormat, test_format, MIX_TYPE_VIDEOFORMAT);
+
+/* frames held by decoded access units, and the order they were decoded in */
+static MixVideoFrame *held[NUM_UNITS];
+static MixBuffer *decoded[NUM_UNITS];
+static gint num_decoded = 0;
+
+static MIX_RESULT test_format_decode(MixVideoFormat *mix,
+		MixBuffer * bufin[], gint bufincnt,
+		MixVideoDecodeParams * decode_params) {
+
+	MIX_RESULT ret = mix_surfacepool_get(mix->surfacepool, &held[num_decoded]);
+	if (ret != MIX_RESULT_SUCCESS) {
+		g_print("access unit decoded without a surface\n");
+		return ret;
+	}
+	decoded[num_decoded++] = bufin[0];
+	return MIX_RESULT_SUCCESS;
+}
+
+static void test_format_init(TestFormat *self) {
+}
+
+static void test_format_class_init(TestFormatClass *klass) {
+	MixVideoFormatClass *video_format_class = MIX_VIDEOFORMAT_CLASS(klass);
+	/* the base class batch loop is under test */
+	video_format_class->decode = test_format_decode;
+}
+
+static gboolean check_batch(MIX_RESULT ret, MIX_RESULT expected_ret,
+		MIX_RESULT results[], gint count, gint consumed, gint expected_consumed) {
+
+	gint i = 0;
+	if (ret != expected_ret || consumed != expected_consumed) {
+		g_print("returned %d, consumed %d; expected %d, %d\n",
+				ret, consumed, expected_ret, expected_consumed);
+		return FALSE;
+	}
+	for (i = 0; i < count; i++) {
+		MIX_RESULT expected = (i < consumed) ?
+			MIX_RESULT_SUCCESS : MIX_RESULT_OUTOFSURFACES;
+		if (results[i] != expected) {
+			g_print("results[%d] = %d, expected %d\n", i, results[i], expected);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int main() {
+	MIX_RESULT ret;
+	MixVideoFormat *fmt = NULL;
+	MixSurfacePool *pool = NULL;
+	VASurfaceID surfaces[NUM_SURFACES];
+	MixBuffer *bufin[NUM_UNITS];
+	MixVideoDecodeParams *decode_params[NUM_UNITS];
+	MIX_RESULT results[NUM_UNITS];
+	gint consumed = 0;
+	gint expected = 0;
+	gint i = 0;
+	int failed = 1;
+
+	g_type_init();
+
+	for (i = 0; i < NUM_SURFACES; i++) {
+		surfaces[i] = i + 1;
+	}
+	for (i = 0; i < NUM_UNITS; i++) {
+		bufin[i] = mix_buffer_new();
+		decode_params[i] = mix_videodecodeparams_new();
+	}
+
+	pool = mix_surfacepool_new();
+	ret = mix_surfacepool_initialize(pool, surfaces, NUM_SURFACES);
+	if (ret != MIX_RESULT_SUCCESS) {
+		goto cleanup;
+	}
+
+	fmt = MIX_VIDEOFORMAT(g_object_new(test_format_get_type(), NULL));
+	fmt->surfacepool = pool;
+
+	/* the pool keeps one surface free, so the pool runs out after
+	 * NUM_SURFACES - 1 access units */
+	expected = NUM_SURFACES - 1;
+	ret = mix_videofmt_decode_batch(fmt, bufin, NUM_UNITS, decode_params,
+			results, &consumed);
+	if (!check_batch(ret, MIX_RESULT_OUTOFSURFACES, results, NUM_UNITS,
+			consumed, expected)) {
+		goto cleanup;
+	}
+	if (num_decoded != expected) {
+		g_print("%d access units reached the decoder, expected %d\n",
+				num_decoded, expected);
+		goto cleanup;
+	}
+
+	/* frames are returned, the caller resubmits the remaining units */
+	for (i = 0; i < num_decoded; i++) {
+		mix_surfacepool_put(pool, held[i]);
+		held[i] = NULL;
+	}
+
+	ret = mix_videofmt_decode_batch(fmt, bufin + consumed, NUM_UNITS - consumed,
+			decode_params + consumed, results, &consumed);
+	if (!check_batch(ret, MIX_RESULT_SUCCESS, results, NUM_UNITS - expected,
+			consumed, NUM_UNITS - expected)) {
+		goto cleanup;
+	}
+
+	/* every access unit was decoded exactly once, in order */
+	for (i = 0; i < NUM_UNITS; i++) {
+		if (decoded[i] != bufin[i]) {
+			g_print("access unit %d decoded out of order\n", i);
+			goto cleanup;
+		}
+	}
+
+	g_print("PASS\n");
+	failed = 0;
+
+cleanup:
+
+	for (i = 0; i < NUM_UNITS; i++) {
+		if (held[i]) {
+			mix_surfacepool_put(pool, held[i]);
+		}
+		mix_buffer_unref(bufin[i]);
+		mix_videodecodeparams_unref(decode_params[i]);
+	}
+
+	if (fmt) {
+		/* the pool is not owned by the format here */
+		fmt->surfacepool = NULL;
+		g_object_unref(fmt);
+	}
+
+	if (pool) {
+		mix_surfacepool_deinitialize(pool);
+		mix_surfacepool_unref(pool);
+	}
+
+	if (failed) {
+		g_print("FAIL\n");
+	}
+	return failed;
+}
@@ -13,6 +13,9 @@ LOCAL_SRC_FILES := \
     VideoDecoderMPEG4.cpp \
     VideoDecoderMPEG2.cpp \
     VideoDecoderAVC.cpp \
+    VideoSurfacePool.cpp \
+    VideoDecoderStats.cpp \
+    VideoDecoderGroup.cpp \
     VideoDecoderTrace.cpp
 
 # VideoDecoderHost.cpp includes VideoDecoderWMV.h,
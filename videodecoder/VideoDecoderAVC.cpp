@@ -29,7 +29,18 @@ VideoDecoderAVC::VideoDecoderAVC(const char *mimeType)
     : VideoDecoderBase(mimeType, VBP_H264),
       mToggleDPB(0),
       mErrorConcealment(false),
-      mAdaptive(false){
+      mAdaptive(false),
+      mBatchSlices(false),
+      mSliceParams(NULL),
+      mSliceParamsCapacity(0),
+      mFastResync(false),
+      mResyncState(RESYNC_NONE),
+      mRecoveryPointPending(false),
+      mRecoveryFrameCnt(0),
+      mRecoveryBrokenLink(false),
+      mRecoveryFrameNum(0),
+      mPrevRefFrameNum(-1),
+      mRecoveredPOC((int32_t)POC_DEFAULT){
 
     invalidateDPB(0);
     invalidateDPB(1);
@@ -38,6 +49,11 @@ VideoDecoderAVC::VideoDecoderAVC(const char *mimeType)
 
 VideoDecoderAVC::~VideoDecoderAVC() {
     stop();
+    if (mSliceParams) {
+        delete [] mSliceParams;
+        mSliceParams = NULL;
+    }
+    mSliceParamsCapacity = 0;
 }
 
 Decode_Status VideoDecoderAVC::start(VideoConfigBuffer *buffer) {
@@ -52,6 +68,12 @@ Decode_Status VideoDecoderAVC::start(VideoConfigBuffer *buffer) {
     VideoDecoderBase::setOutputMethod(OUTPUT_BY_POC);
 
     mErrorConcealment = buffer->flag & WANT_ERROR_CONCEALMENT;
+#ifndef USE_AVC_SHORT_FORMAT
+    // protected sessions are decoded by subclasses that override decodeSlice
+    mBatchSlices = (buffer->flag & WANT_BATCHED_SLICES) && !(buffer->flag & WANT_SURFACE_PROTECTION);
+#endif
+    // sync frame only mode drops more than a resync would
+    mFastResync = (buffer->flag & WANT_FAST_RESYNC) && !mSyncFrameOnly;
     if (buffer->data == NULL || buffer->size == 0) {
         WTRACE("No config data to start VA.");
         if ((buffer->flag & HAS_SURFACE_NUMBER) && (buffer->flag & HAS_VA_PROFILE)) {
@@ -77,7 +99,14 @@ void VideoDecoderAVC::stop(void) {
     invalidateDPB(1);
     mToggleDPB = 0;
     mErrorConcealment = false;
+    mBatchSlices = false;
     mLastPictureFlags = VA_PICTURE_H264_INVALID;
+    mFastResync = false;
+    mResyncState = RESYNC_NONE;
+    mRecoveryPointPending = false;
+    mPrevRefFrameNum = -1;
+    mRecoveredPOC = (int32_t)POC_DEFAULT;
+    mShowFrame = true;
 }
 
 void VideoDecoderAVC::flush(void) {
@@ -87,6 +116,11 @@ void VideoDecoderAVC::flush(void) {
     invalidateDPB(1);
     mToggleDPB = 0;
     mLastPictureFlags = VA_PICTURE_H264_INVALID;
+    mResyncState = RESYNC_NONE;
+    mRecoveryPointPending = false;
+    mPrevRefFrameNum = -1;
+    mRecoveredPOC = (int32_t)POC_DEFAULT;
+    mShowFrame = true;
 }
 
 Decode_Status VideoDecoderAVC::decode(VideoDecodeBuffer *buffer) {
@@ -153,6 +187,13 @@ Decode_Status VideoDecoderAVC::decodeFrame(VideoDecodeBuffer *buffer, vbp_data_h
         mVideoFormatInfo.flags |= IS_SINGLE_FIELD;
     }
 
+    if (mFastResync && data->has_recovery_point) {
+        // the SEI may come in a buffer of its own, it applies to the next frame
+        mRecoveryPointPending = true;
+        mRecoveryFrameCnt = data->recovery_frame_cnt;
+        mRecoveryBrokenLink = data->broken_link_flag != 0;
+    }
+
     if (data->new_sps || data->new_pps) {
         status = handleNewSequence(data);
         CHECK_STATUS("handleNewSequence");
@@ -176,8 +217,22 @@ Decode_Status VideoDecoderAVC::decodeFrame(VideoDecodeBuffer *buffer, vbp_data_h
     mCurrentPTS = buffer->timeStamp;
     //if (lastPTS != mCurrentPTS) {
     if (isNewFrame(data, lastPTS == mCurrentPTS)) {
+        bool showFrame = true;
+        if (mSyncFrameOnly) {
+            mSkippingFrame = !isIntraPicture(data->pic_data);
+        } else if (mFastResync) {
+            mSkippingFrame = skipForResync(buffer, data->pic_data, &showFrame);
+        }
+        if (mSkippingFrame) {
+            // drop the frame before any VA work, the parser still tracks SPS/PPS and POC
+            status = endDecodingFrame(false);
+            CHECK_STATUS("endDecodingFrame");
+            return DECODE_SUCCESS;
+        }
+
         if (mLowDelay) {
             // start decoding a new frame
+            mShowFrame = showFrame;
             status = beginDecodingFrame(data);
             if (status != DECODE_SUCCESS) {
                 Decode_Status st = status;
@@ -194,11 +249,16 @@ Decode_Status VideoDecoderAVC::decodeFrame(VideoDecodeBuffer *buffer, vbp_data_h
         CHECK_STATUS("endDecodingFrame");
 
         if (!mLowDelay) {
-            // start decoding a new frame
+            // start decoding a new frame, mShowFrame applies when it ends
+            mShowFrame = showFrame;
             status = beginDecodingFrame(data);
             CHECK_STATUS("beginDecodingFrame");
         }
     } else {
+        if (mSkippingFrame) {
+            // remaining slices or second field of a dropped frame
+            return DECODE_SUCCESS;
+        }
         status = continueDecodingFrame(data);
         CHECK_STATUS("continueDecodingFrame");
     }
@@ -276,6 +336,16 @@ Decode_Status VideoDecoderAVC::continueDecodingFrame(vbp_data_h264 *data) {
             return DECODE_MULTIPLE_FRAME;
         }
 
+        if (mBatchSlices && canBatchSlices(picData)) {
+            status = decodeSliceBatch(data, picIndex);
+            if (status != DECODE_SUCCESS) {
+                endDecodingFrame(true);
+                removeReferenceFromDPB(picData->pic_parms);
+                return status;
+            }
+            continue;
+        }
+
         for (uint32_t sliceIndex = 0; sliceIndex < picData->num_slices; sliceIndex++) {
             status = decodeSlice(data, picIndex, sliceIndex);
             if (status != DECODE_SUCCESS) {
@@ -290,74 +360,180 @@ Decode_Status VideoDecoderAVC::continueDecodingFrame(vbp_data_h264 *data) {
     return DECODE_SUCCESS;
 }
 
-Decode_Status VideoDecoderAVC::decodeSlice(vbp_data_h264 *data, uint32_t picIndex, uint32_t sliceIndex) {
+Decode_Status VideoDecoderAVC::startDecodingPicture(
+    vbp_data_h264 *data, uint32_t picIndex, uint32_t sliceIndex, VABufferID *bufferIDs, uint32_t *bufferIDCount) {
     Decode_Status status;
     VAStatus vaStatus;
-    uint32_t bufferIDCount = 0;
-    // maximum 4 buffers to render a slice: picture parameter, IQMatrix, slice parameter, slice data
-    VABufferID bufferIDs[4];
 
     vbp_picture_data_h264 *picData = &(data->pic_data[picIndex]);
-    vbp_slice_data_h264 *sliceData = &(picData->slc_data[sliceIndex]);
     VAPictureParameterBufferH264 *picParam = picData->pic_parms;
-    VASliceParameterBufferH264 *sliceParam = &(sliceData->slc_parms);
+    VASliceParameterBufferH264 *sliceParam = &(picData->slc_data[sliceIndex].slc_parms);
 
-    if (sliceParam->first_mb_in_slice == 0 || mDecodingFrame == false) {
-        // either condition indicates start of a new frame
-        if (sliceParam->first_mb_in_slice != 0) {
-            WTRACE("The first slice is lost.");
-            // TODO: handle the first slice lost
+    if (sliceParam->first_mb_in_slice != 0) {
+        WTRACE("The first slice is lost.");
+        // TODO: handle the first slice lost
+    }
+    if (mDecodingFrame) {
+        // interlace content, complete decoding the first field
+        vaStatus = vaEndPicture(mVADisplay, mVAContext);
+        CHECK_VA_STATUS("vaEndPicture");
+
+        // for interlace content, top field may be valid only after the second field is parsed
+        int32_t poc = getPOC(&(picParam->CurrPic));
+        if (poc < mAcquiredBuffer->pictureOrder) {
+            mAcquiredBuffer->pictureOrder = poc;
         }
-        if (mDecodingFrame) {
-            // interlace content, complete decoding the first field
-            vaStatus = vaEndPicture(mVADisplay, mVAContext);
-            CHECK_VA_STATUS("vaEndPicture");
-
-            // for interlace content, top field may be valid only after the second field is parsed
-            int32_t poc = getPOC(&(picParam->CurrPic));
-            if (poc < mAcquiredBuffer->pictureOrder) {
-                mAcquiredBuffer->pictureOrder = poc;
-            }
+    }
+
+    if (mSyncFrameOnly && isIntraPicture(picData)) {
+        // references of a sync frame are dropped pictures or older sync frames. None is
+        // used by intra slices, keeping them in the DPB would only pin surfaces.
+        for (int32_t i = 0; i < MAX_REF_NUMBER; i++) {
+            picParam->ReferenceFrames[i].picture_id = VA_INVALID_SURFACE;
+            picParam->ReferenceFrames[i].flags = VA_PICTURE_H264_INVALID;
         }
+    }
 
-        // Check there is no reference frame loss before decoding a frame
+    // Check there is no reference frame loss before decoding a frame
 
-        // Update  the reference frames and surface IDs for DPB and current frame
-        status = updateDPB(picParam);
-        CHECK_STATUS("updateDPB");
+    // Update  the reference frames and surface IDs for DPB and current frame
+    status = updateDPB(picParam);
+    CHECK_STATUS("updateDPB");
 
 #ifndef USE_AVC_SHORT_FORMAT
-        //We have to provide a hacked DPB rather than complete DPB for libva as workaround
-        status = updateReferenceFrames(picData);
-        CHECK_STATUS("updateReferenceFrames");
+    //We have to provide a hacked DPB rather than complete DPB for libva as workaround
+    status = updateReferenceFrames(picData);
+    CHECK_STATUS("updateReferenceFrames");
 #endif
-        vaStatus = vaBeginPicture(mVADisplay, mVAContext, mAcquiredBuffer->renderBuffer.surface);
-        CHECK_VA_STATUS("vaBeginPicture");
+    vaStatus = vaBeginPicture(mVADisplay, mVAContext, mAcquiredBuffer->renderBuffer.surface);
+    CHECK_VA_STATUS("vaBeginPicture");
 
-        // start decoding a frame
-        mDecodingFrame = true;
+    // start decoding a frame
+    mDecodingFrame = true;
 
-        vaStatus = vaCreateBuffer(
-            mVADisplay,
-            mVAContext,
-            VAPictureParameterBufferType,
-            sizeof(VAPictureParameterBufferH264),
-            1,
-            picParam,
-            &bufferIDs[bufferIDCount]);
-        CHECK_VA_STATUS("vaCreatePictureParameterBuffer");
-        bufferIDCount++;
-
-        vaStatus = vaCreateBuffer(
-            mVADisplay,
-            mVAContext,
-            VAIQMatrixBufferType,
-            sizeof(VAIQMatrixBufferH264),
-            1,
-            data->IQ_matrix_buf,
-            &bufferIDs[bufferIDCount]);
-        CHECK_VA_STATUS("vaCreateIQMatrixBuffer");
-        bufferIDCount++;
+    vaStatus = vaCreateBuffer(
+        mVADisplay,
+        mVAContext,
+        VAPictureParameterBufferType,
+        sizeof(VAPictureParameterBufferH264),
+        1,
+        picParam,
+        &bufferIDs[*bufferIDCount]);
+    CHECK_VA_STATUS("vaCreatePictureParameterBuffer");
+    (*bufferIDCount)++;
+
+    vaStatus = vaCreateBuffer(
+        mVADisplay,
+        mVAContext,
+        VAIQMatrixBufferType,
+        sizeof(VAIQMatrixBufferH264),
+        1,
+        data->IQ_matrix_buf,
+        &bufferIDs[*bufferIDCount]);
+    CHECK_VA_STATUS("vaCreateIQMatrixBuffer");
+    (*bufferIDCount)++;
+
+    return DECODE_SUCCESS;
+}
+
+bool VideoDecoderAVC::canBatchSlices(vbp_picture_data_h264 *picData) {
+    // Only the first slice of a picture may start a new frame, and all slices must lie
+    // in order in one input buffer so that a single data buffer can cover them.
+    vbp_slice_data_h264 *sliceData = picData->slc_data;
+    for (uint32_t i = 1; i < picData->num_slices; i++) {
+        if (sliceData[i].slc_parms.first_mb_in_slice == 0 ||
+            sliceData[i].buffer_addr != sliceData[0].buffer_addr ||
+            sliceData[i].slice_offset < sliceData[i - 1].slice_offset + sliceData[i - 1].slice_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Decode_Status VideoDecoderAVC::decodeSliceBatch(vbp_data_h264 *data, uint32_t picIndex) {
+    Decode_Status status;
+    VAStatus vaStatus;
+    uint32_t bufferIDCount = 0;
+    // picture parameter, IQMatrix, slice parameter array, slice data
+    VABufferID bufferIDs[4];
+
+    vbp_picture_data_h264 *picData = &(data->pic_data[picIndex]);
+    vbp_slice_data_h264 *sliceData = picData->slc_data;
+    uint32_t numSlices = picData->num_slices;
+
+    if (sliceData[0].slc_parms.first_mb_in_slice == 0 || mDecodingFrame == false) {
+        status = startDecodingPicture(data, picIndex, 0, bufferIDs, &bufferIDCount);
+        CHECK_STATUS("startDecodingPicture");
+    }
+
+    if (numSlices > mSliceParamsCapacity) {
+        if (mSliceParams) {
+            delete [] mSliceParams;
+        }
+        mSliceParamsCapacity = numSlices;
+        mSliceParams = new VASliceParameterBufferH264 [mSliceParamsCapacity];
+    }
+
+    // The data buffer starts at the first slice; each slice's parameters are copied and
+    // their data offset rebased on it, leaving the parser output untouched.
+    uint32_t base = sliceData[0].slice_offset;
+    for (uint32_t i = 0; i < numSlices; i++) {
+        status = setReference(&(sliceData[i].slc_parms));
+        CHECK_STATUS("setReference");
+
+        mSliceParams[i] = sliceData[i].slc_parms;
+        mSliceParams[i].slice_data_offset = sliceData[i].slice_offset - base;
+        mSliceParams[i].slice_data_size = sliceData[i].slice_size;
+    }
+
+    vaStatus = vaCreateBuffer(
+        mVADisplay,
+        mVAContext,
+        VASliceParameterBufferType,
+        sizeof(VASliceParameterBufferH264),
+        numSlices,
+        mSliceParams,
+        &bufferIDs[bufferIDCount]);
+    CHECK_VA_STATUS("vaCreateSliceParameterBuffer");
+    bufferIDCount++;
+
+    vbp_slice_data_h264 *lastSlice = &sliceData[numSlices - 1];
+    vaStatus = vaCreateBuffer(
+        mVADisplay,
+        mVAContext,
+        VASliceDataBufferType,
+        lastSlice->slice_offset + lastSlice->slice_size - base, //size
+        1,        //num_elements
+        sliceData[0].buffer_addr + base,
+        &bufferIDs[bufferIDCount]);
+    CHECK_VA_STATUS("vaCreateSliceDataBuffer");
+    bufferIDCount++;
+
+    vaStatus = vaRenderPicture(
+        mVADisplay,
+        mVAContext,
+        bufferIDs,
+        bufferIDCount);
+    CHECK_VA_STATUS("vaRenderPicture");
+
+    return DECODE_SUCCESS;
+}
+
+Decode_Status VideoDecoderAVC::decodeSlice(vbp_data_h264 *data, uint32_t picIndex, uint32_t sliceIndex) {
+    Decode_Status status;
+    VAStatus vaStatus;
+    uint32_t bufferIDCount = 0;
+    // maximum 4 buffers to render a slice: picture parameter, IQMatrix, slice parameter, slice data
+    VABufferID bufferIDs[4];
+
+    vbp_picture_data_h264 *picData = &(data->pic_data[picIndex]);
+    vbp_slice_data_h264 *sliceData = &(picData->slc_data[sliceIndex]);
+    VASliceParameterBufferH264 *sliceParam = &(sliceData->slc_parms);
+
+    if (sliceParam->first_mb_in_slice == 0 || mDecodingFrame == false) {
+        // either condition indicates start of a new frame
+        status = startDecodingPicture(data, picIndex, sliceIndex, bufferIDs, &bufferIDCount);
+        CHECK_STATUS("startDecodingPicture");
     }
 
 #ifndef USE_AVC_SHORT_FORMAT
@@ -502,6 +678,7 @@ Decode_Status VideoDecoderAVC::updateDPB(VAPictureParameterBufferH264 *picParam)
         dpb->surfaceBuffer = mAcquiredBuffer;
         dpb->surfaceBuffer->asReferernce = true;
     }
+    buildPOCIndex(!mToggleDPB);
     // invalidate the current used DPB
     invalidateDPB(mToggleDPB);
     mToggleDPB = !mToggleDPB;
@@ -604,6 +781,7 @@ void VideoDecoderAVC::removeReferenceFromDPB(VAPictureParameterBufferH264 *picPa
                 break;
             }
         }
+        buildPOCIndex(mToggleDPB);
     }
 }
 
@@ -624,37 +802,86 @@ VASurfaceID VideoDecoderAVC::findSurface(VAPictureH264 *pic) {
 }
 
 VideoSurfaceBuffer* VideoDecoderAVC::findSurfaceBuffer(VAPictureH264 *pic) {
-    DecodedPictureBuffer *dpb = mDPBs[mToggleDPB];
-    for (int32_t i = 0; i < DPB_SIZE; i++, dpb++) {
-        if (dpb->poc == pic->BottomFieldOrderCnt ||
-            dpb->poc == pic->TopFieldOrderCnt) {
-            // TODO: remove these debugging codes
-            if (dpb->surfaceBuffer == NULL) {
-                ETRACE("Invalid surface buffer in the DPB for poc %d.", getPOC(pic));
-            }
-            return dpb->surfaceBuffer;
-        }
+    int32_t index = findDPBIndex(mToggleDPB, pic, false);
+    if (index < 0) {
+        // ETRACE("Unable to find surface for poc %d", getPOC(pic));
+        return NULL;
     }
-    // ETRACE("Unable to find surface for poc %d", getPOC(pic));
-    return NULL;
+    DecodedPictureBuffer *dpb = &mDPBs[mToggleDPB][index];
+    // TODO: remove these debugging codes
+    if (dpb->surfaceBuffer == NULL) {
+        ETRACE("Invalid surface buffer in the DPB for poc %d.", getPOC(pic));
+    }
+    return dpb->surfaceBuffer;
 }
 
 VideoSurfaceBuffer* VideoDecoderAVC::findRefSurfaceBuffer(VAPictureH264 *pic) {
-    DecodedPictureBuffer *dpb = mDPBs[mToggleDPB];
     // always looking for the latest one in the DPB, in case ref frames have same POC
-    dpb += (DPB_SIZE - 1);
-    for (int32_t i = DPB_SIZE; i > 0; i--, dpb--) {
-        if (dpb->poc == pic->BottomFieldOrderCnt ||
-            dpb->poc == pic->TopFieldOrderCnt) {
-            // TODO: remove these debugging codes
-            if (dpb->surfaceBuffer == NULL) {
-                ETRACE("Invalid surface buffer in the DPB for poc %d.", getPOC(pic));
+    int32_t index = findDPBIndex(mToggleDPB, pic, true);
+    if (index < 0) {
+        ETRACE("Unable to find surface for poc %d", getPOC(pic));
+        return NULL;
+    }
+    DecodedPictureBuffer *dpb = &mDPBs[mToggleDPB][index];
+    // TODO: remove these debugging codes
+    if (dpb->surfaceBuffer == NULL) {
+        ETRACE("Invalid surface buffer in the DPB for poc %d.", getPOC(pic));
+    }
+    return dpb->surfaceBuffer;
+}
+
+static inline uint32_t hashPOC(int32_t poc) {
+    // multiplicative hash, top bits select one of the POC_INDEX_SIZE (64) slots
+    return ((uint32_t)poc * 2654435761u) >> 26;
+}
+
+void VideoDecoderAVC::buildPOCIndex(int toggle) {
+    POCIndexEntry *index = mPOCIndex[toggle];
+    for (int i = 0; i < POC_INDEX_SIZE; i++) {
+        index[i].poc = (int32_t)POC_DEFAULT;
+    }
+
+    DecodedPictureBuffer *dpb = mDPBs[toggle];
+    for (int i = 0; i < DPB_SIZE; i++, dpb++) {
+        if (dpb->poc == (int32_t)POC_DEFAULT) {
+            continue;
+        }
+        uint32_t slot = hashPOC(dpb->poc);
+        while (index[slot].poc != (int32_t)POC_DEFAULT && index[slot].poc != dpb->poc) {
+            slot = (slot + 1) & (POC_INDEX_SIZE - 1);
+        }
+        if (index[slot].poc == (int32_t)POC_DEFAULT) {
+            index[slot].poc = dpb->poc;
+            index[slot].first = i;
+        }
+        index[slot].last = i;
+    }
+}
+
+int32_t VideoDecoderAVC::findDPBIndex(int toggle, VAPictureH264 *pic, bool latest) {
+    // a DPB entry matches if its POC equals either field POC of the picture;
+    // return the first (or latest) matching position, as a scan of the DPB would
+    POCIndexEntry *index = mPOCIndex[toggle];
+    int32_t pocs[2] = {pic->BottomFieldOrderCnt, pic->TopFieldOrderCnt};
+    int32_t found = -1;
+
+    for (int i = 0; i < 2; i++) {
+        if (pocs[i] == (int32_t)POC_DEFAULT || (i == 1 && pocs[1] == pocs[0])) {
+            continue;
+        }
+        uint32_t slot = hashPOC(pocs[i]);
+        while (index[slot].poc != (int32_t)POC_DEFAULT) {
+            if (index[slot].poc == pocs[i]) {
+                int32_t pos = latest ? index[slot].last : index[slot].first;
+                if (found < 0 || (latest ? pos > found : pos < found)) {
+                    found = pos;
+                }
+                break;
             }
-            return dpb->surfaceBuffer;
+            slot = (slot + 1) & (POC_INDEX_SIZE - 1);
         }
     }
-    ETRACE("Unable to find surface for poc %d", getPOC(pic));
-    return NULL;
+    return found;
 }
 
 void VideoDecoderAVC::invalidateDPB(int toggle) {
@@ -664,6 +891,10 @@ void VideoDecoderAVC::invalidateDPB(int toggle) {
         p->surfaceBuffer = NULL;
         p++;
     }
+    POCIndexEntry *index = mPOCIndex[toggle];
+    for (int i = 0; i < POC_INDEX_SIZE; i++) {
+        index[i].poc = (int32_t)POC_DEFAULT;
+    }
 }
 
 void VideoDecoderAVC::clearAsReference(int toggle) {
@@ -704,7 +935,7 @@ Decode_Status VideoDecoderAVC::startVA(vbp_data_h264 *data) {
         }
     }
 
-    VideoDecoderBase::setOutputWindowSize(mConfigBuffer.flag & WANT_ADAPTIVE_PLAYBACK ? OUTPUT_WINDOW_SIZE : DPBSize);
+    VideoDecoderBase::setOutputWindowSize(mConfigBuffer.flag & WANT_ADAPTIVE_PLAYBACK ? OUTPUT_WINDOW_SIZE : getOutputWindowSize(data, DPBSize));
     updateFormatInfo(data);
 
    // for 1080p, limit the total surface to 19, according the hardware limitation
@@ -851,10 +1082,34 @@ bool VideoDecoderAVC::isWiDiStatusChanged() {
 
 Decode_Status VideoDecoderAVC::handleNewSequence(vbp_data_h264 *data) {
     Decode_Status status;
-    updateFormatInfo(data);
+    if (!(mConfigBuffer.flag & WANT_ADAPTIVE_PLAYBACK)) {
+        // the new SPS may declare a different reordering depth
+        VideoDecoderBase::setOutputWindowSize(getOutputWindowSize(data, getDPBSize(data)));
+    }
 
     bool rawDataMode = !(mConfigBuffer.flag & USE_NATIVE_GRAPHIC_BUFFER);
+    uint32_t codedWidth = (data->pic_data[0].pic_parms->picture_width_in_mbs_minus1 + 1) * 16;
+    uint32_t codedHeight = (data->pic_data[0].pic_parms->picture_height_in_mbs_minus1 + 1) * 16;
+    if (rawDataMode && mDecodingFrame &&
+        (codedWidth != alignMB(mVideoFormatInfo.width) || codedHeight != alignMB(mVideoFormatInfo.height))) {
+        // a new coded size starts with an IDR picture; complete the last frame while
+        // its raw data is still copied with the old format
+        status = endDecodingFrame(false);
+        CHECK_STATUS("endDecodingFrame");
+    }
+    updateFormatInfo(data);
+
     if (rawDataMode && mSizeChanged) {
+        if (codedWidth <= mVideoFormatInfo.surfaceWidth &&
+            codedHeight <= mVideoFormatInfo.surfaceHeight &&
+            getDPBSize(data) + AVC_EXTRA_SURFACE_NUMBER <= (int32_t)mVideoFormatInfo.surfaceNumber) {
+            // new size fits in the allocated surfaces, keep decoding into them. The next
+            // frame carries IS_RESOLUTION_CHANGE so the client picks up the new format.
+            ITRACE("Reusing %d x %d surfaces for %d x %d",
+                mVideoFormatInfo.surfaceWidth, mVideoFormatInfo.surfaceHeight,
+                mVideoFormatInfo.width, mVideoFormatInfo.height);
+            return DECODE_SUCCESS;
+        }
         flushSurfaceBuffers();
         mSizeChanged = false;
         return DECODE_FORMAT_CHANGE;
@@ -938,6 +1193,130 @@ bool VideoDecoderAVC::isNewFrame(vbp_data_h264 *data, bool equalPTS) {
     return newFrame;
 }
 
+bool VideoDecoderAVC::isIntraPicture(vbp_picture_data_h264 *picData) {
+    if (picData->num_slices == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < picData->num_slices; i++) {
+        // I slice is 2 or 7, SI slice is 4 or 9
+        uint8_t sliceType = picData->slc_data[i].slc_parms.slice_type % 5;
+        if (sliceType != 2 && sliceType != 4) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VideoDecoderAVC::isFrameNumGap(VAPictureParameterBufferH264 *picParam) {
+    if (mPrevRefFrameNum < 0 || picParam->seq_fields.bits.gaps_in_frame_num_value_allowed_flag) {
+        return false;
+    }
+    // frame_num is that of the previous reference frame or the one after it
+    uint32_t maxFrameNum = 1 << (picParam->seq_fields.bits.log2_max_frame_num_minus4 + 4);
+    uint32_t frameNum = picParam->frame_num;
+    return frameNum != (uint32_t)mPrevRefFrameNum &&
+           frameNum != ((uint32_t)mPrevRefFrameNum + 1) % maxFrameNum;
+}
+
+bool VideoDecoderAVC::isReferenceMissing(vbp_picture_data_h264 *picData) {
+    VAPictureH264 *ref = picData->pic_parms->ReferenceFrames;
+    for (int32_t i = 0; i < MAX_REF_NUMBER; i++, ref++) {
+        if (ref->flags & VA_PICTURE_H264_INVALID) {
+            continue;
+        }
+        int32_t poc = getPOC(ref);
+        // frames before the last recovery point may still be listed, they are never used
+        if (mRecoveredPOC != (int32_t)POC_DEFAULT && poc < mRecoveredPOC) {
+            continue;
+        }
+        if (findDPBIndex(mToggleDPB, ref, true) < 0) {
+            WTRACE("Reference frame %d is missing.", poc);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VideoDecoderAVC::skipForResync(VideoDecodeBuffer *buffer, vbp_picture_data_h264 *picData, bool *showFrame) {
+    VAPictureParameterBufferH264 *picParam = picData->pic_parms;
+    int32_t poc = getPOC(&(picParam->CurrPic));
+    bool reference = (picParam->CurrPic.flags & VA_PICTURE_H264_SHORT_TERM_REFERENCE) ||
+                     (picParam->CurrPic.flags & VA_PICTURE_H264_LONG_TERM_REFERENCE);
+    bool intra = isIntraPicture(picData);
+    bool idr = picData->idr_flag != 0;
+    bool recoveryPoint = mRecoveryPointPending;
+    mRecoveryPointPending = false;
+
+    if (idr) {
+        // POC restarts, nothing before it can be referenced
+        mRecoveredPOC = (int32_t)POC_DEFAULT;
+    } else if (mResyncState != RESYNC_WAITING) {
+        // references still in the DPB are kept, already queued output is not flushed
+        bool lost = false;
+        if (buffer->flag & HAS_DISCONTINUITY) {
+            WTRACE("Discontinuity at frame %d.", poc);
+            lost = true;
+        } else if (isFrameNumGap(picParam)) {
+            WTRACE("frame_num jumps from %d to %d.", mPrevRefFrameNum, picParam->frame_num);
+            lost = true;
+        } else if (mResyncState == RESYNC_NONE && !intra && isReferenceMissing(picData)) {
+            lost = true;
+        }
+        if (lost) {
+            ITRACE("Dropping frames up to the next sync frame or recovery point.");
+            mResyncState = RESYNC_WAITING;
+            mRecoveredPOC = (int32_t)POC_DEFAULT;
+        }
+    }
+
+    if (mResyncState == RESYNC_WAITING) {
+        if (!idr && !recoveryPoint && !(buffer->flag & IS_SYNC_FRAME)) {
+            return true;
+        }
+        if (!idr && recoveryPoint && mRecoveryFrameCnt > 0) {
+            // gradual decoding refresh, output is correct from recovery_frame_cnt frames on
+            uint32_t maxFrameNum = 1 << (picParam->seq_fields.bits.log2_max_frame_num_minus4 + 4);
+            mRecoveryFrameNum = (picParam->frame_num + mRecoveryFrameCnt) % maxFrameNum;
+            mResyncState = RESYNC_RECOVERING;
+        } else {
+            mResyncState = RESYNC_NONE;
+            mRecoveredPOC = idr ? (int32_t)POC_DEFAULT : poc;
+        }
+        ITRACE("Resync at frame %d.", poc);
+    } else if (mResyncState == RESYNC_NONE && !idr && recoveryPoint && mRecoveryBrokenLink) {
+        // no loss seen, but the stream was spliced at the recovery point: its leading
+        // frames refer to frames before the splice
+        ITRACE("Broken link at frame %d.", poc);
+        mRecoveredPOC = poc;
+    }
+
+    bool skip = false;
+    if (mResyncState == RESYNC_RECOVERING) {
+        if ((uint32_t)picParam->frame_num == mRecoveryFrameNum) {
+            mResyncState = RESYNC_NONE;
+            mRecoveredPOC = poc;
+        } else if (reference) {
+            // decoded for the frames that follow, but not correct enough to be shown
+            *showFrame = false;
+        } else {
+            skip = true;
+        }
+    } else if (mRecoveredPOC != (int32_t)POC_DEFAULT) {
+        if (poc < mRecoveredPOC) {
+            // leading frame of the recovery point, it predicts from frames that were dropped
+            skip = true;
+        } else if (intra && poc > mRecoveredPOC) {
+            // the next intra frame closes the group started at the recovery point
+            mRecoveredPOC = (int32_t)POC_DEFAULT;
+        }
+    }
+
+    if (reference) {
+        mPrevRefFrameNum = picParam->frame_num;
+    }
+    return skip;
+}
+
 int32_t VideoDecoderAVC::getDPBSize(vbp_data_h264 *data) {
     // 1024 * MaxDPB / ( PicWidthInMbs * FrameHeightInMbs * 384 ), 16
     struct DPBTable {
@@ -992,6 +1371,27 @@ int32_t VideoDecoderAVC::getDPBSize(vbp_data_h264 *data) {
     return maxDPBSize;
 }
 
+int32_t VideoDecoderAVC::getOutputWindowSize(vbp_data_h264 *data, int32_t DPBSize) {
+    if (!data->codec_data->bitstream_restriction_flag) {
+        return DPBSize;
+    }
+
+    // A frame can be output once more than max_num_reorder_frames frames wait for output
+    // (C.4.5.3), so the output queue never needs to hold more than that plus one.
+    int32_t reorder = data->codec_data->max_num_reorder_frames;
+    if (reorder > data->codec_data->max_dec_frame_buffering) {
+        // not conforming, reordering can't exceed DPB buffering
+        reorder = data->codec_data->max_dec_frame_buffering;
+    }
+    int32_t windowSize = reorder + 1;
+    if (windowSize > DPBSize) {
+        windowSize = DPBSize;
+    }
+    ITRACE("max_num_reorder_frames = %d, max_dec_frame_buffering = %d, output window = %d",
+        data->codec_data->max_num_reorder_frames, data->codec_data->max_dec_frame_buffering, windowSize);
+    return windowSize;
+}
+
 Decode_Status VideoDecoderAVC::checkHardwareCapability() {
 #ifndef USE_GEN_HW
     VAStatus vaStatus;
@@ -35,6 +35,9 @@ protected:
     virtual Decode_Status beginDecodingFrame(vbp_data_h264 *data);
     virtual Decode_Status continueDecodingFrame(vbp_data_h264 *data);
     virtual Decode_Status decodeSlice(vbp_data_h264 *data, uint32_t picIndex, uint32_t sliceIndex);
+    Decode_Status decodeSliceBatch(vbp_data_h264 *data, uint32_t picIndex);
+    bool canBatchSlices(vbp_picture_data_h264 *picData);
+    Decode_Status startDecodingPicture(vbp_data_h264 *data, uint32_t picIndex, uint32_t sliceIndex, VABufferID *bufferIDs, uint32_t *bufferIDCount);
     Decode_Status setReference(VASliceParameterBufferH264 *sliceParam);
     Decode_Status updateDPB(VAPictureParameterBufferH264 *picParam);
     Decode_Status updateReferenceFrames(vbp_picture_data_h264 *picData);
@@ -44,12 +47,19 @@ protected:
     inline VideoSurfaceBuffer* findSurfaceBuffer(VAPictureH264 *pic);
     inline VideoSurfaceBuffer* findRefSurfaceBuffer(VAPictureH264 *pic);
     inline void invalidateDPB(int toggle);
+    void buildPOCIndex(int toggle);
+    int32_t findDPBIndex(int toggle, VAPictureH264 *pic, bool latest);
     inline void clearAsReference(int toggle);
     Decode_Status startVA(vbp_data_h264 *data);
     void updateFormatInfo(vbp_data_h264 *data);
     Decode_Status handleNewSequence(vbp_data_h264 *data);
     bool isNewFrame(vbp_data_h264 *data, bool equalPTS);
+    bool isIntraPicture(vbp_picture_data_h264 *picData);
+    bool isFrameNumGap(VAPictureParameterBufferH264 *picParam);
+    bool isReferenceMissing(vbp_picture_data_h264 *picData);
+    bool skipForResync(VideoDecodeBuffer *buffer, vbp_picture_data_h264 *picData, bool *showFrame);
     int32_t getDPBSize(vbp_data_h264 *data);
+    int32_t getOutputWindowSize(vbp_data_h264 *data, int32_t DPBSize);
     virtual Decode_Status checkHardwareCapability();
 #ifdef USE_AVC_SHORT_FORMAT
     virtual Decode_Status getCodecSpecificConfigs(VAProfile profile, VAConfigID*config);
@@ -57,6 +67,11 @@ protected:
     bool isWiDiStatusChanged();
 
 private:
+    // test/DPBIndexTest.cpp checks the POC index against a scan of mDPBs
+    friend class DPBIndexTest;
+    // test/ResyncTest.cpp drives skipForResync with synthetic pictures
+    friend class ResyncTest;
+
     struct DecodedPictureBuffer {
         VideoSurfaceBuffer *surfaceBuffer;
         int32_t poc; // Picture Order Count
@@ -68,16 +83,48 @@ private:
         MAX_REF_NUMBER = 16,
         DPB_SIZE = 17,         // DPB_SIZE = MAX_REF_NUMBER + 1,
         REF_LIST_SIZE = 32,
+        // POC hash table size, power of 2 and well above DPB_SIZE
+        POC_INDEX_SIZE = 64,
+    };
+
+    // DPB entries with the same POC, as first and last position in the DPB
+    struct POCIndexEntry {
+        int32_t poc;
+        int8_t first;
+        int8_t last;
     };
 
     // maintain 2 ping-pong decoded picture buffers
     DecodedPictureBuffer mDPBs[2][DPB_SIZE];
+    // POC lookup for each DPB, rebuilt whenever the DPB changes
+    POCIndexEntry mPOCIndex[2][POC_INDEX_SIZE];
     uint8_t mToggleDPB; // 0 or 1
     bool mErrorConcealment;
     uint32_t mLastPictureFlags;
     VideoExtensionBuffer mExtensionBuffer;
     PackedFrameData mPackedFrame;
     bool mAdaptive;
+    // batched slice submission (WANT_BATCHED_SLICES): slice parameters of a picture are
+    // gathered here and sent as one slice parameter buffer
+    bool mBatchSlices;
+    VASliceParameterBufferH264 *mSliceParams;
+    uint32_t mSliceParamsCapacity;
+
+    // fast resync (WANT_FAST_RESYNC): after a loss, frames are dropped up to the next sync
+    // frame or recovery point, then decoded but not shown until the recovery frame
+    enum ResyncState {
+        RESYNC_NONE,
+        RESYNC_WAITING,     // dropping frames until a sync frame or recovery point
+        RESYNC_RECOVERING,  // decoding reference frames up to mRecoveryFrameNum
+    };
+    bool mFastResync;
+    ResyncState mResyncState;
+    bool mRecoveryPointPending; // recovery point SEI seen for the next frame
+    uint32_t mRecoveryFrameCnt;
+    bool mRecoveryBrokenLink; // broken_link_flag of the pending recovery point
+    uint32_t mRecoveryFrameNum;
+    int32_t mPrevRefFrameNum; // frame_num of the last reference frame, -1 if unknown
+    int32_t mRecoveredPOC; // frames before it in output order predate the recovery point
 };
 
 
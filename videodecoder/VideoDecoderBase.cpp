@@ -16,6 +16,7 @@
 
 #include "VideoDecoderBase.h"
 #include "VideoDecoderTrace.h"
+#include "VideoSurfacePool.h"
 #include <string.h>
 #include <va/va_android.h>
 #include <va/va_tpi.h>
@@ -32,6 +33,8 @@ VideoDecoderBase::VideoDecoderBase(const char *mimeType, _vbp_parser_type type)
     : mInitialized(false),
       mLowDelay(false),
       mStoreMetaData(false),
+      mSyncFrameOnly(false),
+      mSkippingFrame(false),
       mDisplay(NULL),
       mVADisplay(NULL),
       mVAContext(VA_INVALID_ID),
@@ -62,7 +65,16 @@ VideoDecoderBase::VideoDecoderBase(const char *mimeType, _vbp_parser_type type)
       mNextOutputPOC(MINIMUM_POC),
       mParserType(type),
       mParserHandle(NULL),
-      mSignalBufferSize(0) {
+      mSignalBufferSize(0),
+      mFreeSurfaceQueue(NULL),
+      mFreeSurfaceQueued(NULL),
+      mFreeSurfaceHead(0),
+      mFreeSurfaceCount(0),
+      mSurfaceAliasCount(NULL),
+      mUseSurfacePool(false),
+      mSurfaceFormat(VA_RT_FORMAT_YUV420),
+      mSharedDisplay(false),
+      mPoolDisplay(false) {
 
     memset(&mVideoFormatInfo, 0, sizeof(VideoFormatInfo));
     memset(&mConfigBuffer, 0, sizeof(mConfigBuffer));
@@ -71,6 +83,7 @@ VideoDecoderBase::VideoDecoderBase(const char *mimeType, _vbp_parser_type type)
     }
     pthread_mutex_init(&mLock, NULL);
     pthread_mutex_init(&mFormatLock, NULL);
+    pthread_mutex_init(&mFreeSurfaceLock, NULL);
     mVideoFormatInfo.mimeType = strdup(mimeType);
     mUseGEN = false;
     mMetaDataBuffersNum = 0;
@@ -87,6 +100,7 @@ VideoDecoderBase::~VideoDecoderBase() {
     pthread_mutex_destroy(&mLock);
     pthread_mutex_destroy(&mFormatLock);
     stop();
+    pthread_mutex_destroy(&mFreeSurfaceLock);
     free(mVideoFormatInfo.mimeType);
 }
 
@@ -139,6 +153,7 @@ Decode_Status VideoDecoderBase::start(VideoConfigBuffer *buffer) {
     mLowDelay = buffer->flag & WANT_LOW_DELAY;
     mStoreMetaData = buffer->flag & WANT_STORE_META_DATA;
     mRawOutput = buffer->flag & WANT_RAW_OUTPUT;
+    setSyncFrameOnly(buffer->flag);
     if (mRawOutput) {
         WTRACE("Output is raw data.");
     }
@@ -171,6 +186,7 @@ Decode_Status VideoDecoderBase::reset(VideoConfigBuffer *buffer) {
     mStoreMetaData = buffer->flag & WANT_STORE_META_DATA;
     mMetaDataBuffersNum = 0;
     mRawOutput = buffer->flag & WANT_RAW_OUTPUT;
+    setSyncFrameOnly(buffer->flag);
     if (mRawOutput) {
         WTRACE("Output is raw data.");
     }
@@ -180,6 +196,7 @@ Decode_Status VideoDecoderBase::reset(VideoConfigBuffer *buffer) {
 
 
 void VideoDecoderBase::stop(void) {
+    // pooled surfaces outlive the decoder; the next instance picks them up
     terminateVA();
 
     mCurrentPTS = INVALID_PTS;
@@ -192,6 +209,8 @@ void VideoDecoderBase::stop(void) {
     // private variables
     mLowDelay = false;
     mStoreMetaData = false;
+    mSyncFrameOnly = false;
+    mSkippingFrame = false;
     mRawOutput = false;
     mNumSurfaces = 0;
     mSurfaceAcquirePos = 0;
@@ -235,6 +254,7 @@ void VideoDecoderBase::flush(void) {
     mOutputHead = NULL;
     mOutputTail = NULL;
     mDecodingFrame = false;
+    mSkippingFrame = false;
 
     // flush vbp parser
     if (mParserHandle && (mParserFlush(mParserHandle) != VBP_OK)) {
@@ -285,6 +305,14 @@ int VideoDecoderBase::getOutputQueueLength(void) {
     return i;
 }
 
+Decode_Status VideoDecoderBase::getStatistics(VideoDecoderStatistics *stats) {
+    if (stats == NULL) {
+        return DECODE_INVALID_DATA;
+    }
+    mStats.getStatistics(stats);
+    return DECODE_SUCCESS;
+}
+
 const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBuffer *outErrBuf) {
     if (mVAStarted == false) {
         return NULL;
@@ -311,12 +339,14 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
         vaSetTimestampForSurface(mVADisplay, outputByPos->renderBuffer.surface, outputByPos->renderBuffer.timeStamp);
         if (useGraphicBuffer && !mUseGEN) {
             vaSyncSurface(mVADisplay, outputByPos->renderBuffer.surface);
+            mStats.endHardware(outputByPos - mSurfaceBuffers);
             fillDecodingErrors(&(outputByPos->renderBuffer));
         }
         if (draining && mOutputTail == NULL) {
             outputByPos->renderBuffer.flag |= IS_EOS;
         }
         drainDecodingErrors(outErrBuf, &(outputByPos->renderBuffer));
+        mStats.endOutput(outputByPos - mSurfaceBuffers, outputByPos->renderBuffer.timeStamp);
 
         return &(outputByPos->renderBuffer);
     }
@@ -357,6 +387,7 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
 
     if (useGraphicBuffer && !mUseGEN) {
         vaSyncSurface(mVADisplay, output->renderBuffer.surface);
+        mStats.endHardware(output - mSurfaceBuffers);
         fillDecodingErrors(&(output->renderBuffer));
     }
 
@@ -365,6 +396,7 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
     }
 
     drainDecodingErrors(outErrBuf, &(output->renderBuffer));
+    mStats.endOutput(output - mSurfaceBuffers, output->renderBuffer.timeStamp);
 
     return &(output->renderBuffer);
 }
@@ -568,21 +600,136 @@ bool VideoDecoderBase::checkBufferAvail(void) {
         return false;
     }
     // check whether there is buffer available for decoding
-    // TODO: check frame being referenced for frame skipping
-    VideoSurfaceBuffer *buffer = NULL;
     for (int32_t i = 0; i < mNumSurfaces; i++) {
-        buffer = mSurfaceBuffers + i;
-
-        if (buffer->asReferernce == false &&
-            buffer->renderBuffer.renderDone == true) {
-            querySurfaceRenderStatus(buffer);
-            if (buffer->renderBuffer.driverRenderDone == true)
-                return true;
+        if (isSurfaceBufferFree(i)) {
+            return true;
         }
-     }
+    }
     return false;
 }
 
+bool VideoDecoderBase::isSurfaceBufferFree(int32_t index) {
+    VideoSurfaceBuffer *buffer = mSurfaceBuffers + index;
+
+    if (buffer->asReferernce == true || buffer->renderBuffer.renderDone == false) {
+        return false;
+    }
+    querySurfaceRenderStatus(buffer);
+    if (buffer->renderBuffer.driverRenderDone == false) {
+        return false;
+    }
+    if (mSurfaceAliasCount[index] == 0) {
+        return true;
+    }
+
+    // surface is shown by a skipped frame; it is free once all of those are rendered.
+    // use mSurfaces[index] instead of buffer->renderBuffer.surface as its the actual surface to use.
+    int32_t aliases = 0;
+    bool referenced = false;
+    for (int32_t i = 0; i < mNumSurfaces; i++) {
+        if (i != index && mSurfaceBuffers[i].renderBuffer.surface == mSurfaces[index]) {
+            aliases++;
+            if (mSurfaceBuffers[i].renderBuffer.renderDone == false) {
+                referenced = true;
+            }
+        }
+    }
+    mSurfaceAliasCount[index] = aliases;
+    if (referenced) {
+        ITRACE("Surface is referenced by other surface buffer.");
+    }
+    return !referenced;
+}
+
+Decode_Status VideoDecoderBase::createPooledSurfaces(VASurfaceID *surfaces, int32_t count) {
+    // entries left VA_INVALID_SURFACE are skipped when the surfaces go back to the pool
+    for (int32_t i = 0; i < count; i++) {
+        surfaces[i] = VA_INVALID_SURFACE;
+    }
+
+    int32_t reused = VideoSurfacePool::getInstance()->acquireSurfaces(
+            mSurfaceFormat,
+            mVideoFormatInfo.surfaceWidth,
+            mVideoFormatInfo.surfaceHeight,
+            surfaces,
+            count);
+    if (reused == count) {
+        return DECODE_SUCCESS;
+    }
+
+    VAStatus vaStatus = vaCreateSurfaces(
+            mVADisplay,
+            mSurfaceFormat,
+            mVideoFormatInfo.surfaceWidth,
+            mVideoFormatInfo.surfaceHeight,
+            surfaces + reused,
+            count - reused,
+            NULL,
+            0);
+    if (vaStatus != VA_STATUS_SUCCESS) {
+        ETRACE("vaCreateSurfaces failed. vaStatus = 0x%x", vaStatus);
+        // VA is not started, terminateVA would not release the reused surfaces
+        VideoSurfacePool::getInstance()->releaseSurfaces(
+            mSurfaceFormat,
+            mVideoFormatInfo.surfaceWidth,
+            mVideoFormatInfo.surfaceHeight,
+            surfaces,
+            reused);
+        for (int32_t i = 0; i < count; i++) {
+            surfaces[i] = VA_INVALID_SURFACE;
+        }
+        return DECODE_DRIVER_FAIL;
+    }
+    return DECODE_SUCCESS;
+}
+
+int32_t VideoDecoderBase::findSurfaceIndex(VASurfaceID surface) {
+    for (int32_t i = 0; i < mNumSurfaces; i++) {
+        if (mSurfaces[i] == surface) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void VideoDecoderBase::pushFreeSurface(VideoSurfaceBuffer *buffer) {
+    if (mFreeSurfaceQueue == NULL || buffer == NULL) {
+        return;
+    }
+    int32_t index = buffer - mSurfaceBuffers;
+    pthread_mutex_lock(&mFreeSurfaceLock);
+    if (!mFreeSurfaceQueued[index]) {
+        // each buffer is queued at most once, so the ring never overflows
+        mFreeSurfaceQueue[(mFreeSurfaceHead + mFreeSurfaceCount) % mNumSurfaces] = index;
+        mFreeSurfaceQueued[index] = true;
+        mFreeSurfaceCount++;
+    }
+    pthread_mutex_unlock(&mFreeSurfaceLock);
+}
+
+int32_t VideoDecoderBase::popFreeSurface(void) {
+    int32_t index = -1;
+    pthread_mutex_lock(&mFreeSurfaceLock);
+    if (mFreeSurfaceCount > 0) {
+        index = mFreeSurfaceQueue[mFreeSurfaceHead];
+        mFreeSurfaceQueued[index] = false;
+        mFreeSurfaceHead = (mFreeSurfaceHead + 1) % mNumSurfaces;
+        mFreeSurfaceCount--;
+    }
+    pthread_mutex_unlock(&mFreeSurfaceLock);
+    return index;
+}
+
+void VideoDecoderBase::resetFreeSurfaces(void) {
+    pthread_mutex_lock(&mFreeSurfaceLock);
+    mFreeSurfaceHead = 0;
+    mFreeSurfaceCount = 0;
+    if (mFreeSurfaceQueued) {
+        memset(mFreeSurfaceQueued, 0, mNumSurfaces * sizeof(bool));
+    }
+    pthread_mutex_unlock(&mFreeSurfaceLock);
+}
+
 Decode_Status VideoDecoderBase::acquireSurfaceBuffer(void) {
     if (mVAStarted == false) {
         return DECODE_FAIL;
@@ -592,52 +739,60 @@ Decode_Status VideoDecoderBase::acquireSurfaceBuffer(void) {
         ETRACE("mAcquiredBuffer is not NULL. Implementation bug.");
         return DECODE_FAIL;
     }
+    mStats.beginAcquire();
 
-    int nextAcquire = mSurfaceAcquirePos;
-    VideoSurfaceBuffer *acquiredBuffer = NULL;
-    bool acquired = false;
+    // take the earliest released buffer first. Queue entries may have been reused since they
+    // were queued, so each is checked again; stale ones are dropped. A buffer that is still
+    // released but waits on the hardware (or on a skipped frame showing its surface) gets no
+    // further notification, so it goes back in the queue. Each entry is looked at once.
+    pthread_mutex_lock(&mFreeSurfaceLock);
+    int32_t queued = mFreeSurfaceCount;
+    pthread_mutex_unlock(&mFreeSurfaceLock);
 
-    while (acquired == false) {
-        acquiredBuffer = mSurfaceBuffers + nextAcquire;
-
-        querySurfaceRenderStatus(acquiredBuffer);
-
-        if (acquiredBuffer->asReferernce == false && acquiredBuffer->renderBuffer.renderDone == true && acquiredBuffer->renderBuffer.driverRenderDone == true) {
-            // this is potential buffer for acquisition. Check if it is referenced by other surface for frame skipping
-            VideoSurfaceBuffer *temp;
-            acquired = true;
-            for (int i = 0; i < mNumSurfaces; i++) {
-                if (i == nextAcquire) {
-                    continue;
-                }
-                temp = mSurfaceBuffers + i;
-                // use mSurfaces[nextAcquire] instead of acquiredBuffer->renderBuffer.surface as its the actual surface to use.
-                if (temp->renderBuffer.surface == mSurfaces[nextAcquire] &&
-                    temp->renderBuffer.renderDone == false) {
-                    ITRACE("Surface is referenced by other surface buffer.");
-                    acquired = false;
-                    break;
-                }
-            }
-        }
-        if (acquired) {
+    int32_t nextAcquire = -1;
+    for (; queued > 0; queued--) {
+        int32_t index = popFreeSurface();
+        if (index < 0) {
             break;
         }
-        nextAcquire++;
-        if (nextAcquire == mNumSurfaces) {
-            nextAcquire = 0;
+        if (isSurfaceBufferFree(index)) {
+            nextAcquire = index;
+            break;
         }
-        if (nextAcquire == mSurfaceAcquirePos) {
-            return DECODE_NO_SURFACE;
+        VideoSurfaceBuffer *buffer = mSurfaceBuffers + index;
+        if (buffer->asReferernce == false && buffer->renderBuffer.renderDone == true) {
+            pushFreeSurface(buffer);
         }
     }
 
-    if (acquired == false) {
-        return DECODE_NO_SURFACE;
+    if (nextAcquire < 0) {
+        // buffers made available without notification (renderDone set by the client or a
+        // reference dropped by the decoder) are found by scanning from the last position
+        nextAcquire = mSurfaceAcquirePos;
+        while (!isSurfaceBufferFree(nextAcquire)) {
+            nextAcquire++;
+            if (nextAcquire == mNumSurfaces) {
+                nextAcquire = 0;
+            }
+            if (nextAcquire == mSurfaceAcquirePos) {
+                mStats.countNoSurface();
+                return DECODE_NO_SURFACE;
+            }
+        }
     }
 
-    mAcquiredBuffer = acquiredBuffer;
+    mAcquiredBuffer = mSurfaceBuffers + nextAcquire;
     mSurfaceAcquirePos = nextAcquire;
+    mStats.endAcquire(nextAcquire);
+
+    // the buffer no longer shows the surface of a skipped frame
+    if (mAcquiredBuffer->renderBuffer.surface != VA_INVALID_SURFACE &&
+        mAcquiredBuffer->renderBuffer.surface != mSurfaces[mSurfaceAcquirePos]) {
+        int32_t aliased = findSurfaceIndex(mAcquiredBuffer->renderBuffer.surface);
+        if (aliased >= 0 && mSurfaceAliasCount[aliased] > 0) {
+            mSurfaceAliasCount[aliased]--;
+        }
+    }
 
     // set surface again as surface maybe reset by skipped frame.
     // skipped frame is a "non-coded frame" and decoder needs to duplicate the previous reference frame as the output.
@@ -662,6 +817,11 @@ Decode_Status VideoDecoderBase::outputSurfaceBuffer(void) {
         ETRACE("mAcquiredBuffer is NULL. Implementation bug.");
         return DECODE_FAIL;
     }
+    mStats.endSubmit(mAcquiredBuffer - mSurfaceBuffers);
+    if (mAcquiredBuffer->renderBuffer.errBuf.errorNumber &&
+        mAcquiredBuffer->renderBuffer.errBuf.errorArray[0].type == DecodeRefMissing) {
+        mStats.countReferenceMissing();
+    }
 
     if (mRawOutput) {
         status = getRawDataFromSurface();
@@ -673,6 +833,15 @@ Decode_Status VideoDecoderBase::outputSurfaceBuffer(void) {
         mAcquiredBuffer->renderBuffer.renderDone = false;
     } else {
         mAcquiredBuffer->renderBuffer.renderDone = true;
+        pushFreeSurface(mAcquiredBuffer);
+    }
+
+    // skipped frame shows the surface of the last reference frame
+    if (mAcquiredBuffer->renderBuffer.surface != mSurfaces[mAcquiredBuffer - mSurfaceBuffers]) {
+        int32_t aliased = findSurfaceIndex(mAcquiredBuffer->renderBuffer.surface);
+        if (aliased >= 0) {
+            mSurfaceAliasCount[aliased]++;
+        }
     }
 
     // decoder must set "asReference and referenceFrame" flags properly
@@ -685,6 +854,7 @@ Decode_Status VideoDecoderBase::outputSurfaceBuffer(void) {
             if (mForwardReference != NULL) {
                 // this foward reference is no longer needed
                 mForwardReference->asReferernce = false;
+                pushFreeSurface(mForwardReference);
             }
             // Forware reference for either P or B frame prediction
             mForwardReference = mLastReference;
@@ -719,8 +889,14 @@ Decode_Status VideoDecoderBase::releaseSurfaceBuffer(void) {
     }
 
     // frame is not decoded to the acquired buffer, current surface is invalid, and can't be output.
+    mStats.dropFrame(mAcquiredBuffer - mSurfaceBuffers);
+    if (mAcquiredBuffer->renderBuffer.errBuf.errorNumber &&
+        mAcquiredBuffer->renderBuffer.errBuf.errorArray[0].type == DecodeRefMissing) {
+        mStats.countReferenceMissing();
+    }
     mAcquiredBuffer->asReferernce = false;
     mAcquiredBuffer->renderBuffer.renderDone = true;
+    pushFreeSurface(mAcquiredBuffer);
     mAcquiredBuffer = NULL;
     return DECODE_SUCCESS;
 }
@@ -730,6 +906,7 @@ void VideoDecoderBase::flushSurfaceBuffers(void) {
     VideoSurfaceBuffer *p = NULL;
     while (mOutputHead) {
         mOutputHead->renderBuffer.renderDone = true;
+        pushFreeSurface(mOutputHead);
         p = mOutputHead;
         mOutputHead = mOutputHead->next;
         p->next = NULL;
@@ -808,6 +985,11 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
         }
     }
 
+    if (mSyncFrameOnly && !(mConfigBuffer.flag & USE_NATIVE_GRAPHIC_BUFFER)) {
+        // no inter frame is decoded, the DPB is never filled
+        numSurface = SYNC_FRAME_SURFACE_NUMBER;
+    }
+
     // TODO: validate profile
     if (numSurface == 0) {
         return DECODE_FAIL;
@@ -826,10 +1008,22 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
         return DECODE_FAIL;
     }
 
+#ifndef USE_HYBRID_DRIVER
+    // decoder allocated surfaces outlive the VA context in the surface pool
+    mUseSurfacePool = !(mConfigBuffer.flag & (USE_NATIVE_GRAPHIC_BUFFER | WANT_SURFACE_PROTECTION)) &&
+                      (int32_t)profile != VAProfileSoftwareDecoding;
+    // decoders of a group share the pool display whatever their surfaces are
+    mPoolDisplay = mUseSurfacePool || (mSharedDisplay && !(mConfigBuffer.flag & WANT_SURFACE_PROTECTION));
+#endif
+
     // Display is defined as "unsigned int"
 #ifndef USE_HYBRID_DRIVER
-    mDisplay = new Display;
-    *mDisplay = ANDROID_DISPLAY_HANDLE;
+    if (mPoolDisplay) {
+        mVADisplay = VideoSurfacePool::getInstance()->acquireDisplay(ANDROID_DISPLAY_HANDLE);
+    } else {
+        mDisplay = new Display;
+        *mDisplay = ANDROID_DISPLAY_HANDLE;
+    }
 #else
     if (profile >= VAProfileH264Baseline && profile <= VAProfileVC1Advanced) {
         ITRACE("Using GEN driver");
@@ -841,15 +1035,24 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
         mUseGEN = false;
     }
 #endif
-    mVADisplay = vaGetDisplay(mDisplay);
-    if (mVADisplay == NULL) {
-        ETRACE("vaGetDisplay failed.");
-        return DECODE_DRIVER_FAIL;
-    }
+    if (mPoolDisplay) {
+        if (mVADisplay == NULL) {
+            ETRACE("Unable to get the shared VA display.");
+            mUseSurfacePool = false;
+            mPoolDisplay = false;
+            return DECODE_DRIVER_FAIL;
+        }
+    } else {
+        mVADisplay = vaGetDisplay(mDisplay);
+        if (mVADisplay == NULL) {
+            ETRACE("vaGetDisplay failed.");
+            return DECODE_DRIVER_FAIL;
+        }
 
-    int majorVersion, minorVersion;
-    vaStatus = vaInitialize(mVADisplay, &majorVersion, &minorVersion);
-    CHECK_VA_STATUS("vaInitialize");
+        int majorVersion, minorVersion;
+        vaStatus = vaInitialize(mVADisplay, &majorVersion, &minorVersion);
+        CHECK_VA_STATUS("vaInitialize");
+    }
 
     if ((int32_t)profile != VAProfileSoftwareDecoding) {
 
@@ -879,13 +1082,13 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
     mNumSurfaces = numSurface;
     mNumExtraSurfaces = numExtraSurface;
     mSurfaces = new VASurfaceID [mNumSurfaces + mNumExtraSurfaces];
+    if (mSurfaces == NULL) {
+        return DECODE_MEMORY_FAIL;
+    }
     mExtraSurfaces = mSurfaces + mNumSurfaces;
     for (int i = 0; i < mNumSurfaces + mNumExtraSurfaces; ++i) {
         mSurfaces[i] = VA_INVALID_SURFACE;
     }
-    if (mSurfaces == NULL) {
-        return DECODE_MEMORY_FAIL;
-    }
 
     setRenderRect();
     setColorSpaceInfo(mVideoFormatInfo.colorMatrix, mVideoFormatInfo.videoRange);
@@ -897,6 +1100,7 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
         WTRACE("Surface is protected.");
 #endif
     }
+    mSurfaceFormat = format;
     if (mConfigBuffer.flag & USE_NATIVE_GRAPHIC_BUFFER) {
         if (!mStoreMetaData) {
             VASurfaceAttrib attribs[2];
@@ -959,6 +1163,12 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
                 attribs,
                 2);
         }
+    } else if (mUseSurfacePool) {
+        // pooled surfaces are MB aligned, so streams that differ only in cropping share them
+        mVideoFormatInfo.surfaceWidth = alignMB(mVideoFormatInfo.width);
+        mVideoFormatInfo.surfaceHeight = alignMB(mVideoFormatInfo.height);
+        status = createPooledSurfaces(mSurfaces, mNumSurfaces);
+        CHECK_STATUS("createPooledSurfaces");
     } else {
         vaStatus = vaCreateSurfaces(
             mVADisplay,
@@ -974,7 +1184,22 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
     }
     CHECK_VA_STATUS("vaCreateSurfaces");
 
-    if (mNumExtraSurfaces != 0) {
+    if (mNumExtraSurfaces != 0 && mUseSurfacePool) {
+        status = createPooledSurfaces(mExtraSurfaces, mNumExtraSurfaces);
+        if (status != DECODE_SUCCESS) {
+            // the surfaces of the first call would not be released either
+            VideoSurfacePool::getInstance()->releaseSurfaces(
+                mSurfaceFormat,
+                mVideoFormatInfo.surfaceWidth,
+                mVideoFormatInfo.surfaceHeight,
+                mSurfaces,
+                mNumSurfaces);
+            for (int i = 0; i < mNumSurfaces; ++i) {
+                mSurfaces[i] = VA_INVALID_SURFACE;
+            }
+        }
+        CHECK_STATUS("createPooledSurfaces");
+    } else if (mNumExtraSurfaces != 0) {
         vaStatus = vaCreateSurfaces(
             mVADisplay,
             format,
@@ -1031,6 +1256,9 @@ Decode_Status VideoDecoderBase::setupVA(uint32_t numSurface, VAProfile profile,
     if (mSurfaceBuffers == NULL) {
         return DECODE_MEMORY_FAIL;
     }
+    mFreeSurfaceQueue = new int32_t [mNumSurfaces];
+    mFreeSurfaceQueued = new bool [mNumSurfaces];
+    mSurfaceAliasCount = new int32_t [mNumSurfaces];
     initSurfaceBuffer(true);
 
     if ((int32_t)profile == VAProfileSoftwareDecoding) {
@@ -1084,6 +1312,24 @@ Decode_Status VideoDecoderBase::terminateVA(void) {
         mSurfaceBuffers = NULL;
     }
 
+    pthread_mutex_lock(&mFreeSurfaceLock);
+    if (mFreeSurfaceQueue) {
+        delete [] mFreeSurfaceQueue;
+        mFreeSurfaceQueue = NULL;
+    }
+    if (mFreeSurfaceQueued) {
+        delete [] mFreeSurfaceQueued;
+        mFreeSurfaceQueued = NULL;
+    }
+    mFreeSurfaceHead = 0;
+    mFreeSurfaceCount = 0;
+    pthread_mutex_unlock(&mFreeSurfaceLock);
+
+    if (mSurfaceAliasCount) {
+        delete [] mSurfaceAliasCount;
+        mSurfaceAliasCount = NULL;
+    }
+
     if (mVASurfaceAttrib) {
         if (mVASurfaceAttrib->buffers) free(mVASurfaceAttrib->buffers);
         delete mVASurfaceAttrib;
@@ -1096,7 +1342,21 @@ Decode_Status VideoDecoderBase::terminateVA(void) {
         mSurfaceUserPtr = NULL;
     }
 
-    if (mSurfaces) {
+    if (mSurfaces && mUseSurfacePool) {
+        // surfaces go back to the pool, make sure the context no longer refers to them
+        if (mVAContext != VA_INVALID_ID) {
+            vaDestroyContext(mVADisplay, mVAContext);
+            mVAContext = VA_INVALID_ID;
+        }
+        VideoSurfacePool::getInstance()->releaseSurfaces(
+            mSurfaceFormat,
+            mVideoFormatInfo.surfaceWidth,
+            mVideoFormatInfo.surfaceHeight,
+            mSurfaces,
+            mNumSurfaces + mNumExtraSurfaces);
+        delete [] mSurfaces;
+        mSurfaces = NULL;
+    } else if (mSurfaces) {
         vaDestroySurfaces(mVADisplay, mSurfaces, mStoreMetaData ? mMetaDataBuffersNum : (mNumSurfaces + mNumExtraSurfaces));
         delete [] mSurfaces;
         mSurfaces = NULL;
@@ -1112,10 +1372,15 @@ Decode_Status VideoDecoderBase::terminateVA(void) {
         mVAConfig = VA_INVALID_ID;
     }
 
-    if (mVADisplay) {
+    if (mVADisplay && mPoolDisplay) {
+        VideoSurfacePool::getInstance()->releaseDisplay();
+        mVADisplay = NULL;
+    } else if (mVADisplay) {
         vaTerminate(mVADisplay);
         mVADisplay = NULL;
     }
+    mUseSurfacePool = false;
+    mPoolDisplay = false;
 
     if (mDisplay) {
 #ifndef USE_HYBRID_DRIVER
@@ -1146,10 +1411,12 @@ Decode_Status VideoDecoderBase::parseBuffer(uint8_t *buffer, int32_t size, bool
     }
 
     uint8_t configFlag = config ? 1 : 0;
+    mStats.beginParse();
     vbpStatus = mParserParse(mParserHandle, buffer, size, configFlag);
     CHECK_VBP_STATUS("vbp_parse");
 
     vbpStatus = mParserQuery(mParserHandle, vbpData);
+    mStats.endParse();
     CHECK_VBP_STATUS("vbp_query");
 
     return DECODE_SUCCESS;
@@ -1213,6 +1480,9 @@ Decode_Status VideoDecoderBase::getRawDataFromSurface(VideoRenderBuffer *renderB
     VAImage vaImage;
     vaStatus = vaSyncSurface(renderBuffer->display, renderBuffer->surface);
     CHECK_VA_STATUS("vaSyncSurface");
+    if (internal) {
+        mStats.endHardware(mAcquiredBuffer - mSurfaceBuffers);
+    }
 
     vaStatus = vaDeriveImage(renderBuffer->display, renderBuffer->surface, &vaImage);
     CHECK_VA_STATUS("vaDeriveImage");
@@ -1423,6 +1693,15 @@ void VideoDecoderBase::initSurfaceBuffer(bool reset) {
         mSurfaceBuffers[i].renderBuffer.graphicBufferIndex = i;
     }
 
+    // all surface buffers own their surfaces again; queue the ones ready for decoding
+    memset(mSurfaceAliasCount, 0, mNumSurfaces * sizeof(int32_t));
+    resetFreeSurfaces();
+    for (int32_t i = 0; i < mNumSurfaces; i++) {
+        if (mSurfaceBuffers[i].renderBuffer.renderDone) {
+            pushFreeSurface(mSurfaceBuffers + i);
+        }
+    }
+
     if (useGraphicBuffer && reset) {
         mInitialized = true;
         mSignalBufferSize = 0;
@@ -1475,6 +1754,7 @@ Decode_Status VideoDecoderBase::signalRenderDone(void * graphichandler, bool isN
         for (i = 0; i < mNumSurfaces; i++) {
             if (mSurfaceBuffers[i].renderBuffer.graphicBufferHandle == graphichandler) {
                 mSurfaceBuffers[i].renderBuffer.renderDone = true;
+                pushFreeSurface(mSurfaceBuffers + i);
                 VTRACE("SignalRenderDoneFlag mInitialized = true index = %d", i);
                break;
            }
@@ -1630,6 +1910,21 @@ void VideoDecoderBase::fillDecodingErrors(VideoRenderBuffer *currentSurface) {
     }
 }
 
+void VideoDecoderBase::setSyncFrameOnly(uint32_t flag) {
+    // protected content can't be output as raw data, and secure decoders have their own decode path
+    mSyncFrameOnly = (flag & WANT_SYNC_FRAME_ONLY) && !(flag & WANT_SURFACE_PROTECTION);
+    mSkippingFrame = false;
+    if (!mSyncFrameOnly) {
+        return;
+    }
+    ITRACE("Only sync frames are decoded.");
+    // decoded frames are intra frames only, there is nothing to reorder
+    mLowDelay = true;
+    if (!(flag & USE_NATIVE_GRAPHIC_BUFFER)) {
+        mRawOutput = true;
+    }
+}
+
 void VideoDecoderBase::setRotationDegrees(int32_t rotationDegrees) {
     if (mRotationDegrees == rotationDegrees) {
         return;
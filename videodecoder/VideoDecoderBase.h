@@ -21,6 +21,7 @@
 #include <va/va_tpi.h>
 #include "VideoDecoderDefs.h"
 #include "VideoDecoderInterface.h"
+#include "VideoDecoderStats.h"
 #include <pthread.h>
 #include <dlfcn.h>
 
@@ -42,6 +43,10 @@ typedef unsigned int Display;
 // POC: 4P,  8P,  10P,  6B and mNextOutputPOC = 5
 #define OUTPUT_WINDOW_SIZE 8
 
+// Surfaces allocated in sync frame only mode: the decoding target, up to two references
+// still held by the previous intra frame and one frame pending output.
+#define SYNC_FRAME_SURFACE_NUMBER 4
+
 /*
  * ITU-R BT.601, BT.709  transfer matrices from VA 2.0
  * Video Color Field definitions Design Spec(Version 0.03).
@@ -77,6 +82,11 @@ public:
     virtual bool checkBufferAvail();
     virtual void enableErrorReport(bool enabled = false) {mErrReportEnabled = enabled; };
     virtual int getOutputQueueLength(void);
+    virtual void enableStatistics(bool enabled) {mStats.enable(enabled);}
+    virtual Decode_Status getStatistics(VideoDecoderStatistics *stats);
+    virtual Decode_Status dumpStatisticsTrace(int fd) {return mStats.dumpTrace(fd);}
+    // must be called before start, the display is picked in setupVA
+    void useSharedDisplay(bool enable) {mSharedDisplay = enable;}
 
 protected:
     // each acquireSurfaceBuffer must be followed by a corresponding outputSurfaceBuffer or releaseSurfaceBuffer.
@@ -115,6 +125,7 @@ private:
     void initSurfaceBuffer(bool reset);
     void drainDecodingErrors(VideoErrorBuffer *outErrBuf, VideoRenderBuffer *currentSurface);
     void fillDecodingErrors(VideoRenderBuffer *currentSurface);
+    void setSyncFrameOnly(uint32_t flag);
 
     bool mInitialized;
     pthread_mutex_t mLock;
@@ -122,6 +133,8 @@ private:
 protected:
     bool mLowDelay; // when true, decoded frame is immediately output for rendering
     bool mStoreMetaData; // when true, meta data mode is enabled for adaptive playback
+    bool mSyncFrameOnly; // when true, frames other than sync frames are dropped before decoding
+    bool mSkippingFrame; // indicate whether the frame being parsed is dropped before decoding
     VideoFormatInfo mVideoFormatInfo;
     Display *mDisplay;
     VADisplay mVADisplay;
@@ -147,6 +160,7 @@ protected:
 
     bool mErrReportEnabled;
     bool mWiDiOn;
+    VideoDecoderStats mStats; // per frame instrumentation, disabled by default
     typedef uint32_t (*OpenFunc)(uint32_t, void **);
     typedef uint32_t (*CloseFunc)(void *);
     typedef uint32_t (*ParseFunc)(void *, uint8_t *, uint32_t, uint8_t);
@@ -177,6 +191,9 @@ protected:
      };
 
 private:
+    // test/ResyncTest.cpp checks that a resync leaves the output queue alone
+    friend class ResyncTest;
+
     bool mRawOutput; // whether to output NV12 raw data
     bool mManageReference;  // this should stay true for VC1/MP4 decoder, and stay false for AVC decoder. AVC  handles reference frame using DPB
     OUTPUT_METHOD mOutputMethod;
@@ -196,6 +213,27 @@ private:
     uint32 mSignalBufferSize;
     bool mUseGEN;
     uint32_t mMetaDataBuffersNum;
+    // surface buffers released for reuse, in release order (signalRenderDone, releaseSurfaceBuffer,
+    // reference release). Entries are candidates and are validated when popped.
+    int32_t *mFreeSurfaceQueue;
+    bool *mFreeSurfaceQueued;
+    int32_t mFreeSurfaceHead;
+    int32_t mFreeSurfaceCount;
+    pthread_mutex_t mFreeSurfaceLock;
+    // number of surface buffers showing a surface on behalf of a skipped frame, per surface
+    int32_t *mSurfaceAliasCount;
+    // surfaces and display come from VideoSurfacePool (decoder allocated surfaces only)
+    bool mUseSurfacePool;
+    int32_t mSurfaceFormat;
+    bool mSharedDisplay; // decoder of a VideoDecoderGroup, always uses the pool display
+    bool mPoolDisplay; // mVADisplay is the VideoSurfacePool display
+
+    void pushFreeSurface(VideoSurfaceBuffer *buffer);
+    int32_t popFreeSurface(void);
+    void resetFreeSurfaces(void);
+    bool isSurfaceBufferFree(int32_t index);
+    int32_t findSurfaceIndex(VASurfaceID surface);
+    Decode_Status createPooledSurfaces(VASurfaceID *surfaces, int32_t count);
 protected:
     void ManageReference(bool enable) {mManageReference = enable;}
     void setOutputMethod(OUTPUT_METHOD method) {mOutputMethod = method;}
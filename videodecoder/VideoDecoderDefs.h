@@ -114,6 +114,16 @@ typedef enum {
 
     // indicate meta data mode
     WANT_STORE_META_DATA = 0x400000,
+
+    // indicate all slices of a picture should be submitted to the driver in one render call
+    WANT_BATCHED_SLICES = 0x800000,
+
+    // indicate only sync frames (I/IDR) should be decoded, e.g. for thumbnail or seek preview
+    WANT_SYNC_FRAME_ONLY = 0x1000000,
+
+    // indicate that after a loss (HAS_DISCONTINUITY, frame_num gap or missing reference) frames
+    // should be dropped up to the next sync frame or recovery point, keeping queued output
+    WANT_FAST_RESYNC = 0x2000000,
 } VIDEO_BUFFER_FLAG;
 
 typedef enum
@@ -229,6 +239,31 @@ struct VideoFormatInfo {
     VideoExtensionBuffer *ext;
 };
 
+// decoding stages timed for each frame, see IVideoDecoder::enableStatistics
+typedef enum {
+    DECODE_STAGE_PARSE = 0,     // parsing of the buffers preceding the frame's surface acquisition
+    DECODE_STAGE_ACQUIRE,       // waiting for a free surface
+    DECODE_STAGE_SUBMIT,        // VA buffer creation and submission, up to the end of picture
+    DECODE_STAGE_HARDWARE,      // from submission until the decoder synchronizes with the surface
+    DECODE_STAGE_OUTPUT_QUEUE,  // decoded frame waiting in the output queue
+    DECODE_STAGE_NUM,
+} VIDEO_DECODE_STAGE;
+
+struct VideoStageStatistics {
+    uint32_t count;  // frames for which the stage was measured
+    uint32_t p50;    // in microseconds, upper bound of the histogram bucket
+    uint32_t p99;
+    uint32_t max;
+};
+
+struct VideoDecoderStatistics {
+    VideoStageStatistics stage[DECODE_STAGE_NUM];
+    uint32_t framesOutput;      // frames handed out by getOutput
+    uint32_t framesDropped;     // frames discarded while being decoded
+    uint32_t noSurface;         // times DECODE_NO_SURFACE was hit
+    uint32_t referenceMissing;  // frames decoded or dropped with a missing reference (DecodeRefMissing)
+};
+
 // TODO: categorize the follow errors as fatal and non-fatal.
 typedef enum {
     DECODE_NOT_STARTED = -10,
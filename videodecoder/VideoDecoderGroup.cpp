@@ -0,0 +1,327 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VideoDecoderGroup.h"
+#include "VideoDecoderBase.h"
+#include "VideoDecoderHost.h"
+#include "VideoDecoderTrace.h"
+#include <string.h>
+#include <unistd.h>
+
+VideoDecoderGroup::VideoDecoderGroup()
+    : mNumWorkers(0),
+      mNumThreads(0),
+      mReadyCount(0),
+      mStopping(false) {
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mWorkCond, NULL);
+    pthread_cond_init(&mIdleCond, NULL);
+    pthread_key_create(&mWorkerKey, NULL);
+    memset(mMembers, 0, sizeof(mMembers));
+}
+
+VideoDecoderGroup::~VideoDecoderGroup() {
+    for (int32_t i = 0; i < MAX_DECODERS; i++) {
+        if (mMembers[i].decoder) {
+            releaseDecoder(mMembers[i].decoder);
+        }
+    }
+
+    pthread_mutex_lock(&mLock);
+    mStopping = true;
+    pthread_cond_broadcast(&mWorkCond);
+    pthread_mutex_unlock(&mLock);
+    for (int32_t i = 0; i < mNumThreads; i++) {
+        pthread_join(mWorkers[i].thread, NULL);
+    }
+    for (int32_t i = 0; i < mNumWorkers; i++) {
+        pthread_mutex_destroy(&mWorkers[i].lock);
+    }
+
+    pthread_key_delete(mWorkerKey);
+    pthread_cond_destroy(&mIdleCond);
+    pthread_cond_destroy(&mWorkCond);
+    pthread_mutex_destroy(&mLock);
+}
+
+Decode_Status VideoDecoderGroup::start(int32_t numWorkers) {
+    if (numWorkers <= 0) {
+        numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (numWorkers <= 0) {
+        numWorkers = 1;
+    } else if (numWorkers > MAX_WORKERS) {
+        numWorkers = MAX_WORKERS;
+    }
+
+    // queues are set up before any thread runs, workers read mNumWorkers without locking
+    for (int32_t i = 0; i < numWorkers; i++) {
+        Worker *worker = mWorkers + i;
+        worker->group = this;
+        worker->index = i;
+        worker->head = 0;
+        worker->count = 0;
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+    mNumWorkers = numWorkers;
+
+    for (int32_t i = 0; i < numWorkers; i++) {
+        if (pthread_create(&mWorkers[i].thread, NULL, workerThread, mWorkers + i) != 0) {
+            // queues without a thread are still served by stealing
+            ETRACE("Failed to create decoder group worker %d", i);
+            break;
+        }
+        mNumThreads++;
+    }
+    if (mNumThreads == 0) {
+        return DECODE_FAIL;
+    }
+    ITRACE("Decoder group started with %d workers", mNumThreads);
+    return DECODE_SUCCESS;
+}
+
+IVideoDecoder* VideoDecoderGroup::newDecoder(const char *mimeType) {
+    IVideoDecoder *decoder = createVideoDecoder(mimeType);
+    if (decoder == NULL) {
+        return NULL;
+    }
+    // every decoder created by the host derives from VideoDecoderBase
+    ((VideoDecoderBase *)decoder)->useSharedDisplay(true);
+    return decoder;
+}
+
+void VideoDecoderGroup::deleteDecoder(IVideoDecoder *decoder) {
+    releaseVideoDecoder(decoder);
+}
+
+IVideoDecoder* VideoDecoderGroup::createDecoder(const char *mimeType) {
+    IVideoDecoder *decoder = newDecoder(mimeType);
+    if (decoder == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&mLock);
+    for (int32_t i = 0; i < MAX_DECODERS; i++) {
+        Member *member = mMembers + i;
+        if (member->decoder == NULL) {
+            member->decoder = decoder;
+            member->head = NULL;
+            member->tail = NULL;
+            member->scheduled = false;
+            member->worker = i % mNumWorkers;
+            pthread_mutex_unlock(&mLock);
+            return decoder;
+        }
+    }
+    pthread_mutex_unlock(&mLock);
+
+    ETRACE("Too many decoders in the group.");
+    deleteDecoder(decoder);
+    return NULL;
+}
+
+void VideoDecoderGroup::releaseDecoder(IVideoDecoder *decoder) {
+    if (onWorkerThread("releaseDecoder")) {
+        return;
+    }
+    pthread_mutex_lock(&mLock);
+    Member *member = findMember(decoder);
+    if (member == NULL) {
+        pthread_mutex_unlock(&mLock);
+        ETRACE("Decoder is not in the group.");
+        return;
+    }
+    waitMemberIdle(member);
+    member->decoder = NULL;
+    pthread_mutex_unlock(&mLock);
+
+    deleteDecoder(decoder);
+}
+
+Decode_Status VideoDecoderGroup::queueDecode(
+    IVideoDecoder *decoder, VideoDecodeBuffer *buffer, VideoDecodeDoneFunc done, void *cookie) {
+    if (buffer == NULL) {
+        return DECODE_INVALID_DATA;
+    }
+    DecodeJob *job = new DecodeJob;
+    if (job == NULL) {
+        return DECODE_MEMORY_FAIL;
+    }
+    job->buffer = buffer;
+    job->done = done;
+    job->cookie = cookie;
+    job->next = NULL;
+
+    pthread_mutex_lock(&mLock);
+    Member *member = findMember(decoder);
+    if (member == NULL) {
+        pthread_mutex_unlock(&mLock);
+        delete job;
+        return DECODE_INVALID_DATA;
+    }
+    if (member->tail) {
+        member->tail->next = job;
+    } else {
+        member->head = job;
+    }
+    member->tail = job;
+    bool schedule = !member->scheduled;
+    member->scheduled = true;
+    int32_t worker = member->worker;
+    pthread_mutex_unlock(&mLock);
+
+    if (schedule) {
+        pushMember(member, worker);
+    }
+    return DECODE_SUCCESS;
+}
+
+void VideoDecoderGroup::waitIdle(IVideoDecoder *decoder) {
+    if (onWorkerThread("waitIdle")) {
+        return;
+    }
+    pthread_mutex_lock(&mLock);
+    Member *member = findMember(decoder);
+    if (member) {
+        waitMemberIdle(member);
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+void* VideoDecoderGroup::workerThread(void *arg) {
+    Worker *worker = (Worker *)arg;
+    pthread_setspecific(worker->group->mWorkerKey, worker);
+    worker->group->runWorker(worker);
+    return NULL;
+}
+
+void VideoDecoderGroup::runWorker(Worker *worker) {
+    while (true) {
+        Member *member = takeMember(worker->index);
+        if (member) {
+            runMember(member, worker->index);
+            continue;
+        }
+
+        pthread_mutex_lock(&mLock);
+        while (!mStopping && mReadyCount <= 0) {
+            pthread_cond_wait(&mWorkCond, &mLock);
+        }
+        bool stopping = mStopping;
+        pthread_mutex_unlock(&mLock);
+        if (stopping) {
+            break;
+        }
+    }
+}
+
+void VideoDecoderGroup::runMember(Member *member, int32_t worker) {
+    pthread_mutex_lock(&mLock);
+    DecodeJob *job = member->head;
+    member->head = job->next;
+    if (member->head == NULL) {
+        member->tail = NULL;
+    }
+    member->worker = worker;
+    pthread_mutex_unlock(&mLock);
+
+    Decode_Status status = member->decoder->decode(job->buffer);
+    if (job->done) {
+        job->done(job->cookie, member->decoder, job->buffer, status);
+    }
+    delete job;
+
+    pthread_mutex_lock(&mLock);
+    bool more = (member->head != NULL);
+    if (!more) {
+        member->scheduled = false;
+        pthread_cond_broadcast(&mIdleCond);
+    }
+    pthread_mutex_unlock(&mLock);
+
+    if (more) {
+        // back to the tail, the other decoders on this queue go first
+        pushMember(member, worker);
+    }
+}
+
+void VideoDecoderGroup::pushMember(Member *member, int32_t worker) {
+    Worker *w = mWorkers + worker;
+    pthread_mutex_lock(&w->lock);
+    w->queue[(w->head + w->count) % MAX_DECODERS] = member;
+    w->count++;
+    pthread_mutex_unlock(&w->lock);
+
+    pthread_mutex_lock(&mLock);
+    mReadyCount++;
+    pthread_cond_signal(&mWorkCond);
+    pthread_mutex_unlock(&mLock);
+}
+
+VideoDecoderGroup::Member* VideoDecoderGroup::takeMember(int32_t worker) {
+    Member *member = NULL;
+    for (int32_t i = 0; i < mNumWorkers && member == NULL; i++) {
+        Worker *w = mWorkers + (worker + i) % mNumWorkers;
+        pthread_mutex_lock(&w->lock);
+        if (w->count > 0) {
+            if (i == 0) {
+                // own queue, from the head
+                member = w->queue[w->head];
+                w->head = (w->head + 1) % MAX_DECODERS;
+            } else {
+                // steal the most recently queued decoder, its owner would run it last
+                member = w->queue[(w->head + w->count - 1) % MAX_DECODERS];
+            }
+            w->count--;
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    if (member) {
+        pthread_mutex_lock(&mLock);
+        mReadyCount--;
+        pthread_mutex_unlock(&mLock);
+    }
+    return member;
+}
+
+VideoDecoderGroup::Member* VideoDecoderGroup::findMember(IVideoDecoder *decoder) {
+    if (decoder == NULL) {
+        return NULL;
+    }
+    for (int32_t i = 0; i < MAX_DECODERS; i++) {
+        if (mMembers[i].decoder == decoder) {
+            return mMembers + i;
+        }
+    }
+    return NULL;
+}
+
+void VideoDecoderGroup::waitMemberIdle(Member *member) {
+    // mLock is held
+    while (member->scheduled) {
+        pthread_cond_wait(&mIdleCond, &mLock);
+    }
+}
+
+bool VideoDecoderGroup::onWorkerThread(const char *func) {
+    // a done callback waiting for a decoder would wait for its own worker, or for all of them
+    if (pthread_getspecific(mWorkerKey) != NULL) {
+        ETRACE("%s is not allowed on a decoder group worker thread.", func);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef VIDEO_DECODER_GROUP_H_
+#define VIDEO_DECODER_GROUP_H_
+
+#include "VideoDecoderInterface.h"
+#include <pthread.h>
+
+// Decoders of a group get the VideoSurfacePool display. A decoder with queued buffers is put
+// on the run queue of the worker that last ran it; a worker takes decoders from the head of
+// its own queue and, when it is empty, steals from the tail of the others. One buffer is
+// decoded per turn so that busy streams don't starve the rest.
+class VideoDecoderGroup : public IVideoDecoderGroup {
+public:
+    VideoDecoderGroup();
+    virtual ~VideoDecoderGroup();
+
+    Decode_Status start(int32_t numWorkers);
+
+    virtual IVideoDecoder* createDecoder(const char *mimeType);
+    virtual void releaseDecoder(IVideoDecoder *decoder);
+    virtual Decode_Status queueDecode(IVideoDecoder *decoder, VideoDecodeBuffer *buffer, VideoDecodeDoneFunc done, void *cookie);
+    virtual void waitIdle(IVideoDecoder *decoder);
+
+protected:
+    // creates and releases member decoders, test/DecoderGroupTest.cpp overrides them with
+    // stubs. Members left at destruction are released by the base class deleteDecoder.
+    virtual IVideoDecoder* newDecoder(const char *mimeType);
+    virtual void deleteDecoder(IVideoDecoder *decoder);
+
+private:
+    enum {
+        MAX_WORKERS = 16,
+        MAX_DECODERS = 64,
+    };
+
+    struct DecodeJob {
+        VideoDecodeBuffer *buffer;
+        VideoDecodeDoneFunc done;
+        void *cookie;
+        DecodeJob *next;
+    };
+
+    struct Member {
+        IVideoDecoder *decoder;
+        DecodeJob *head; // queued buffers, protected by mLock
+        DecodeJob *tail;
+        bool scheduled; // on a run queue or being decoded
+        int32_t worker; // worker that last ran it
+    };
+
+    struct Worker {
+        VideoDecoderGroup *group;
+        int32_t index;
+        pthread_t thread;
+        pthread_mutex_t lock;
+        Member *queue[MAX_DECODERS]; // a member is on at most one queue
+        int32_t head;
+        int32_t count;
+    };
+
+    static void* workerThread(void *arg);
+    void runWorker(Worker *worker);
+    void runMember(Member *member, int32_t worker);
+    void pushMember(Member *member, int32_t worker);
+    Member* takeMember(int32_t worker);
+    Member* findMember(IVideoDecoder *decoder);
+    void waitMemberIdle(Member *member);
+    bool onWorkerThread(const char *func);
+
+    pthread_mutex_t mLock;
+    pthread_cond_t mWorkCond;
+    pthread_cond_t mIdleCond;
+    pthread_key_t mWorkerKey; // set on the worker threads of the group
+    Worker mWorkers[MAX_WORKERS];
+    int32_t mNumWorkers;
+    int32_t mNumThreads; // worker threads actually running
+    Member mMembers[MAX_DECODERS];
+    int32_t mReadyCount; // members on run queues
+    bool mStopping;
+};
+
+#endif /* VIDEO_DECODER_GROUP_H_ */
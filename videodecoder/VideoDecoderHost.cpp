@@ -27,6 +27,8 @@
 #include "VideoDecoderVP8.h"
 #endif
 #include "VideoDecoderHost.h"
+#include "VideoDecoderGroup.h"
+#include "VideoSurfacePool.h"
 #include "VideoDecoderTrace.h"
 #include <string.h>
 
@@ -86,4 +88,20 @@ void releaseVideoDecoder(IVideoDecoder* p) {
     delete p;
 }
 
+IVideoDecoderGroup* createVideoDecoderGroup(int32_t numWorkers) {
+    VideoDecoderGroup *p = new VideoDecoderGroup();
+    if (p->start(numWorkers) != DECODE_SUCCESS) {
+        ETRACE("Failed to start decoder group.");
+        delete p;
+        return NULL;
+    }
+    return (IVideoDecoderGroup *)p;
+}
 
+void releaseVideoDecoderGroup(IVideoDecoderGroup *p) {
+    delete p;
+}
+
+void trimVideoDecoderSurfaces(void) {
+    VideoSurfacePool::getInstance()->trim();
+}
@@ -24,6 +24,14 @@
 IVideoDecoder* createVideoDecoder(const char* mimeType);
 void releaseVideoDecoder(IVideoDecoder *p);
 
+// numWorkers <= 0 uses one worker per online CPU
+IVideoDecoderGroup* createVideoDecoderGroup(int32_t numWorkers);
+void releaseVideoDecoderGroup(IVideoDecoderGroup *p);
+
+// decoder allocated surfaces are kept after a decoder is released, for the next one to reuse.
+// This frees them, and the VA display they belong to, once no decoder is left.
+void trimVideoDecoderSurfaces(void);
+
 
 
 #endif /* VIDEO_DECODER_HOST_H_ */
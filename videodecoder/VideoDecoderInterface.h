@@ -36,6 +36,29 @@ public:
     virtual Decode_Status getRawDataFromSurface(VideoRenderBuffer *renderBuffer = NULL, uint8_t *pRawData = NULL, uint32_t *pSize = NULL, bool internal = true) = 0;
     virtual void enableErrorReport(bool enabled) = 0;
     virtual int getOutputQueueLength(void) = 0;
+    // per frame instrumentation, enabling resets the collected statistics
+    virtual void enableStatistics(bool enabled) = 0;
+    virtual Decode_Status getStatistics(VideoDecoderStatistics *stats) = 0;
+    // writes the latest frames as Chrome trace event JSON (chrome://tracing)
+    virtual Decode_Status dumpStatisticsTrace(int fd) = 0;
+};
+
+// called on a worker thread of the group once the buffer is decoded
+typedef void (*VideoDecodeDoneFunc)(void *cookie, IVideoDecoder *decoder, VideoDecodeBuffer *buffer, Decode_Status status);
+
+// Decoders sharing one VA display and a pool of worker threads. Buffers queued to a decoder are
+// decoded in order, one at a time; different decoders run in parallel. While buffers are queued,
+// the decoder may only be used from the done callback, or again after waitIdle.
+// releaseDecoder and waitIdle wait for the worker threads, so they are rejected when called from
+// a done callback; the group itself must not be released from one either.
+class IVideoDecoderGroup {
+public:
+    virtual ~IVideoDecoderGroup() {}
+    virtual IVideoDecoder* createDecoder(const char *mimeType) = 0;
+    virtual void releaseDecoder(IVideoDecoder *decoder) = 0;
+    // the buffer must stay valid until done is called
+    virtual Decode_Status queueDecode(IVideoDecoder *decoder, VideoDecodeBuffer *buffer, VideoDecodeDoneFunc done, void *cookie) = 0;
+    virtual void waitIdle(IVideoDecoder *decoder) = 0;
 };
 
 #endif /* VIDEO_DECODER_INTERFACE_H_ */
@@ -181,6 +181,17 @@ Decode_Status VideoDecoderMPEG4::decodeFrame(VideoDecodeBuffer *buffer, vbp_data
         status = endDecodingFrame(false);
         CHECK_STATUS("endDecodingFrame");
 
+        if (mSyncFrameOnly) {
+            vbp_picture_data_mp42 *picData = data->picture_data;
+            mSkippingFrame = picData->vop_coded == 0 ||
+                picData->picture_param.vop_fields.bits.vop_coding_type != MP4_VOP_TYPE_I;
+            if (mSkippingFrame) {
+                // drop the frame before any VA work, a pending n-vop of a packed frame goes with it
+                mExpectingNVOP = false;
+                return DECODE_SUCCESS;
+            }
+        }
+
         // start decoding a new frame
         status = beginDecodingFrame(data);
         if (status == DECODE_MULTIPLE_FRAME) {
@@ -193,6 +204,10 @@ Decode_Status VideoDecoderMPEG4::decodeFrame(VideoDecodeBuffer *buffer, vbp_data
         }
         CHECK_STATUS("beginDecodingFrame");
     } else {
+        if (mSkippingFrame) {
+            // remaining data of a dropped frame
+            return DECODE_SUCCESS;
+        }
         status = continueDecodingFrame(data);
         if (status == DECODE_MULTIPLE_FRAME) {
             buffer->ext = &mExtensionBuffer;
@@ -343,6 +358,10 @@ Decode_Status VideoDecoderMPEG4::continueDecodingFrame(vbp_data_mp42 *data) {
                 // TODO: handle this case
             }
             if (mDecodingFrame) {
+                // Both pictures of the packed frame are decoded in this call when a surface is free
+                // for the second one. With graphic buffers the client may be out of buffers, then
+                // the rest of the data is handed back to it and parsed again (DECODE_MULTIPLE_FRAME).
+                bool splitPackedFrame = useGraphicBuffer && !checkBufferAvail();
                 if (codingType == MP4_VOP_TYPE_B){
                     // this indicates the start of a new frame in the packed frame
                     // Update timestamp for P frame in the packed frame as timestamp here is for the B frame!
@@ -354,7 +373,7 @@ Decode_Status VideoDecoderMPEG4::continueDecodingFrame(vbp_data_mp42 *data) {
                         // TODO: unit of time stamp varies on different frame work
                         increment = increment * 1e6 / picParam->vop_time_increment_resolution;
                         mAcquiredBuffer->renderBuffer.timeStamp += increment;
-                        if (useGraphicBuffer){
+                        if (splitPackedFrame){
                            mPackedFrame.timestamp = mCurrentPTS;
                            mCurrentPTS = mAcquiredBuffer->renderBuffer.timeStamp;
                         }
@@ -367,7 +386,7 @@ Decode_Status VideoDecoderMPEG4::continueDecodingFrame(vbp_data_mp42 *data) {
                         increment = increment % picParam->vop_time_increment_resolution;
                         //convert to micro-second
                         increment = increment * 1e6 / picParam->vop_time_increment_resolution;
-                        if (useGraphicBuffer) {
+                        if (splitPackedFrame) {
                             mPackedFrame.timestamp = mCurrentPTS + increment;
                         }
                         else {
@@ -375,7 +394,7 @@ Decode_Status VideoDecoderMPEG4::continueDecodingFrame(vbp_data_mp42 *data) {
                         }
 
                     } else {
-                        if (useGraphicBuffer) {
+                        if (splitPackedFrame) {
                             mPackedFrame.timestamp = mCurrentPTS + 30000;
                         }
                         else {
@@ -388,7 +407,7 @@ Decode_Status VideoDecoderMPEG4::continueDecodingFrame(vbp_data_mp42 *data) {
                 if (codingType != MP4_VOP_TYPE_B) {
                     mExpectingNVOP = false;
                 }
-                if (useGraphicBuffer) {
+                if (splitPackedFrame) {
                     int32_t count = i - 1;
                     if (count < 0) {
                         WTRACE("Shuld not be here!");
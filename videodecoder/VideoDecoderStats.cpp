@@ -0,0 +1,333 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VideoDecoderStats.h"
+#include "VideoDecoderTrace.h"
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *sStageNames[DECODE_STAGE_NUM] = {
+    "parse",
+    "acquire",
+    "submit",
+    "hardware",
+    "output queue",
+};
+
+VideoDecoderStats::VideoDecoderStats()
+    : mEnabled(false) {
+    enable(false);
+}
+
+void VideoDecoderStats::enable(bool enabled) {
+    mEnabled = false;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    mParseBegin = 0;
+    mParseStart = 0;
+    mParseTime = 0;
+    mAcquireBegin = 0;
+    memset(mFrames, 0, sizeof(mFrames));
+    memset(mHistogram, 0, sizeof(mHistogram));
+    memset(mMax, 0, sizeof(mMax));
+    mFramesOutput = 0;
+    mFramesDropped = 0;
+    mNoSurface = 0;
+    mReferenceMissing = 0;
+    __atomic_store_n(&mRingHead, 0, __ATOMIC_RELEASE);
+
+    mEnabled = enabled;
+}
+
+uint64_t VideoDecoderStats::now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int32_t VideoDecoderStats::getBucket(uint32_t duration) {
+    if (duration < 4) {
+        return duration;
+    }
+    int32_t msb = 31 - __builtin_clz(duration);
+    return (msb - 1) * 4 + ((duration >> (msb - 2)) & 3);
+}
+
+uint32_t VideoDecoderStats::getBucketLimit(int32_t bucket) {
+    // largest duration falling in the bucket
+    uint64_t next = bucket + 1;
+    if (next >= 4) {
+        next = (uint64_t)(4 + (next & 3)) << (next / 4 - 1);
+    }
+    if (next > 0xFFFFFFFF) {
+        return 0xFFFFFFFF;
+    }
+    return (uint32_t)(next - 1);
+}
+
+void VideoDecoderStats::beginParse(void) {
+    if (!mEnabled) {
+        return;
+    }
+    mParseStart = now();
+    if (mParseBegin == 0) {
+        mParseBegin = mParseStart;
+    }
+}
+
+void VideoDecoderStats::endParse(void) {
+    if (!mEnabled || mParseStart == 0) {
+        return;
+    }
+    mParseTime += (uint32_t)(now() - mParseStart);
+    mParseStart = 0;
+}
+
+void VideoDecoderStats::beginAcquire(void) {
+    if (!mEnabled) {
+        return;
+    }
+    // kept across DECODE_NO_SURFACE retries, the wait covers all of them
+    if (mAcquireBegin == 0) {
+        mAcquireBegin = now();
+    }
+}
+
+void VideoDecoderStats::endAcquire(int32_t index) {
+    if (!mEnabled || index < 0 || index >= MAX_GRAPHIC_BUFFER_NUM) {
+        return;
+    }
+    FrameRecord *record = mFrames + index;
+    uint64_t end = now();
+    memset(record, 0, sizeof(FrameRecord));
+    if (mParseBegin) {
+        record->begin[DECODE_STAGE_PARSE] = mParseBegin;
+        record->duration[DECODE_STAGE_PARSE] = mParseTime;
+        record->measured[DECODE_STAGE_PARSE] = true;
+    }
+    setStage(record, DECODE_STAGE_ACQUIRE, mAcquireBegin ? mAcquireBegin : end, end);
+    mParseBegin = 0;
+    mParseTime = 0;
+    mAcquireBegin = 0;
+}
+
+void VideoDecoderStats::endSubmit(int32_t index) {
+    if (!mEnabled || index < 0 || index >= MAX_GRAPHIC_BUFFER_NUM) {
+        return;
+    }
+    FrameRecord *record = mFrames + index;
+    if (!record->measured[DECODE_STAGE_ACQUIRE]) {
+        return;
+    }
+    uint64_t begin = record->begin[DECODE_STAGE_ACQUIRE] + record->duration[DECODE_STAGE_ACQUIRE];
+    setStage(record, DECODE_STAGE_SUBMIT, begin, now());
+}
+
+void VideoDecoderStats::endHardware(int32_t index) {
+    if (!mEnabled || index < 0 || index >= MAX_GRAPHIC_BUFFER_NUM) {
+        return;
+    }
+    FrameRecord *record = mFrames + index;
+    if (!record->measured[DECODE_STAGE_SUBMIT] || record->measured[DECODE_STAGE_HARDWARE]) {
+        return;
+    }
+    uint64_t begin = record->begin[DECODE_STAGE_SUBMIT] + record->duration[DECODE_STAGE_SUBMIT];
+    setStage(record, DECODE_STAGE_HARDWARE, begin, now());
+}
+
+void VideoDecoderStats::endOutput(int32_t index, int64_t timeStamp) {
+    if (!mEnabled || index < 0 || index >= MAX_GRAPHIC_BUFFER_NUM) {
+        return;
+    }
+    FrameRecord *record = mFrames + index;
+    if (!record->measured[DECODE_STAGE_SUBMIT]) {
+        return;
+    }
+    // the queue residency starts once the frame is fully decoded
+    int32_t last = record->measured[DECODE_STAGE_HARDWARE] ? DECODE_STAGE_HARDWARE : DECODE_STAGE_SUBMIT;
+    setStage(record, DECODE_STAGE_OUTPUT_QUEUE, record->begin[last] + record->duration[last], now());
+    record->timeStamp = timeStamp;
+    addRecord(record);
+    __atomic_fetch_add(&mFramesOutput, 1, __ATOMIC_RELAXED);
+    memset(record, 0, sizeof(FrameRecord));
+}
+
+void VideoDecoderStats::dropFrame(int32_t index) {
+    if (!mEnabled) {
+        return;
+    }
+    if (index >= 0 && index < MAX_GRAPHIC_BUFFER_NUM) {
+        memset(mFrames + index, 0, sizeof(FrameRecord));
+    }
+    __atomic_fetch_add(&mFramesDropped, 1, __ATOMIC_RELAXED);
+}
+
+void VideoDecoderStats::countNoSurface(void) {
+    if (!mEnabled) {
+        return;
+    }
+    __atomic_fetch_add(&mNoSurface, 1, __ATOMIC_RELAXED);
+}
+
+void VideoDecoderStats::countReferenceMissing(void) {
+    if (!mEnabled) {
+        return;
+    }
+    __atomic_fetch_add(&mReferenceMissing, 1, __ATOMIC_RELAXED);
+}
+
+void VideoDecoderStats::setStage(FrameRecord *record, int32_t stage, uint64_t begin, uint64_t end) {
+    uint64_t duration = end > begin ? end - begin : 0;
+    record->begin[stage] = begin;
+    record->duration[stage] = duration > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)duration;
+    record->measured[stage] = true;
+}
+
+void VideoDecoderStats::addRecord(FrameRecord *record) {
+    for (int32_t i = 0; i < DECODE_STAGE_NUM; i++) {
+        if (!record->measured[i]) {
+            continue;
+        }
+        __atomic_fetch_add(&mHistogram[i][getBucket(record->duration[i])], 1, __ATOMIC_RELAXED);
+        if (record->duration[i] > mMax[i]) {
+            __atomic_store_n(&mMax[i], record->duration[i], __ATOMIC_RELAXED);
+        }
+    }
+
+    // readers drop any slot that may have been rewritten while they copied it
+    uint32_t head = mRingHead;
+    mRing[head % RING_SIZE] = *record;
+    __atomic_store_n(&mRingHead, head + 1, __ATOMIC_RELEASE);
+}
+
+void VideoDecoderStats::getStatistics(VideoDecoderStatistics *stats) {
+    memset(stats, 0, sizeof(VideoDecoderStatistics));
+    for (int32_t i = 0; i < DECODE_STAGE_NUM; i++) {
+        uint32_t histogram[HISTOGRAM_SIZE];
+        uint64_t count = 0;
+        for (int32_t j = 0; j < HISTOGRAM_SIZE; j++) {
+            histogram[j] = __atomic_load_n(&mHistogram[i][j], __ATOMIC_RELAXED);
+            count += histogram[j];
+        }
+        VideoStageStatistics *stage = stats->stage + i;
+        stage->count = (uint32_t)count;
+        stage->max = __atomic_load_n(&mMax[i], __ATOMIC_RELAXED);
+        if (count == 0) {
+            continue;
+        }
+        uint64_t sum = 0;
+        bool p50Found = false;
+        for (int32_t j = 0; j < HISTOGRAM_SIZE; j++) {
+            sum += histogram[j];
+            if (!p50Found && sum * 100 >= count * 50) {
+                stage->p50 = getBucketLimit(j);
+                p50Found = true;
+            }
+            if (sum * 100 >= count * 99) {
+                stage->p99 = getBucketLimit(j);
+                break;
+            }
+        }
+        // the bucket limit may exceed what was actually measured
+        if (stage->p50 > stage->max) {
+            stage->p50 = stage->max;
+        }
+        if (stage->p99 > stage->max) {
+            stage->p99 = stage->max;
+        }
+    }
+    stats->framesOutput = __atomic_load_n(&mFramesOutput, __ATOMIC_RELAXED);
+    stats->framesDropped = __atomic_load_n(&mFramesDropped, __ATOMIC_RELAXED);
+    stats->noSurface = __atomic_load_n(&mNoSurface, __ATOMIC_RELAXED);
+    stats->referenceMissing = __atomic_load_n(&mReferenceMissing, __ATOMIC_RELAXED);
+}
+
+static bool writeAll(int fd, const char *data, int32_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+Decode_Status VideoDecoderStats::dumpTrace(int fd) {
+    if (fd < 0) {
+        return DECODE_INVALID_DATA;
+    }
+
+    FrameRecord *records = new FrameRecord[RING_SIZE];
+    if (records == NULL) {
+        return DECODE_MEMORY_FAIL;
+    }
+    uint32_t head = __atomic_load_n(&mRingHead, __ATOMIC_ACQUIRE);
+    uint32_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+    for (uint32_t i = first; i < head; i++) {
+        records[i % RING_SIZE] = mRing[i % RING_SIZE];
+    }
+    // slots the writer reached while copying are not consistent
+    uint32_t newHead = __atomic_load_n(&mRingHead, __ATOMIC_ACQUIRE);
+    if (newHead >= first + RING_SIZE) {
+        first = newHead - RING_SIZE + 1;
+    }
+
+    char line[256];
+    int pid = getpid();
+    bool ok = writeAll(fd, "{\"traceEvents\":[\n", strlen("{\"traceEvents\":[\n"));
+    for (int32_t i = 0; i < DECODE_STAGE_NUM && ok; i++) {
+        // one track per stage
+        int32_t len = snprintf(line, sizeof(line),
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+            pid, i + 1, sStageNames[i]);
+        ok = writeAll(fd, line, len);
+    }
+    for (uint32_t i = first; i < head && ok; i++) {
+        FrameRecord *record = records + (i % RING_SIZE);
+        for (int32_t j = 0; j < DECODE_STAGE_NUM && ok; j++) {
+            if (!record->measured[j]) {
+                continue;
+            }
+            int32_t len = snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"cat\":\"video\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                "\"ts\":%llu,\"dur\":%u,\"args\":{\"pts\":%lld}},\n",
+                sStageNames[j], pid, j + 1,
+                (unsigned long long)record->begin[j], record->duration[j], (long long)record->timeStamp);
+            ok = writeAll(fd, line, len);
+        }
+    }
+    // closing metadata event, so that every event above can end with a comma
+    if (ok) {
+        int32_t len = snprintf(line, sizeof(line),
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"videodecoder\"}}\n]}\n", pid);
+        ok = writeAll(fd, line, len);
+    }
+    delete [] records;
+
+    if (!ok) {
+        ETRACE("Failed to write decoder trace, errno = %d", errno);
+        return DECODE_FAIL;
+    }
+    return DECODE_SUCCESS;
+}
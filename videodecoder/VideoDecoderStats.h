@@ -0,0 +1,88 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef VIDEO_DECODER_STATS_H_
+#define VIDEO_DECODER_STATS_H_
+
+#include "VideoDecoderDefs.h"
+
+// Per frame stage timing for VideoDecoderBase. Stage marks are taken by the decoding thread
+// (decode and getOutput are not called concurrently). Finished frames go to a ring and to
+// per stage histograms, which getStatistics and dumpTrace read from any thread without
+// locking. Every mark returns right away when statistics are disabled.
+class VideoDecoderStats {
+public:
+    VideoDecoderStats();
+
+    void enable(bool enabled);
+    inline bool isEnabled(void) { return mEnabled; }
+
+    void beginParse(void);
+    void endParse(void);
+    void beginAcquire(void);
+    void endAcquire(int32_t index);
+    void endSubmit(int32_t index);
+    void endHardware(int32_t index);
+    void endOutput(int32_t index, int64_t timeStamp);
+    void dropFrame(int32_t index);
+
+    void countNoSurface(void);
+    void countReferenceMissing(void);
+
+    void getStatistics(VideoDecoderStatistics *stats);
+    Decode_Status dumpTrace(int fd);
+
+private:
+    enum {
+        RING_SIZE = 256,
+        // 4 buckets per power of 2 up to 2^32 microseconds
+        HISTOGRAM_SIZE = 124,
+    };
+
+    struct FrameRecord {
+        int64_t timeStamp;
+        uint64_t begin[DECODE_STAGE_NUM]; // microseconds, monotonic clock
+        uint32_t duration[DECODE_STAGE_NUM];
+        bool measured[DECODE_STAGE_NUM];
+    };
+
+    static uint64_t now(void);
+    static int32_t getBucket(uint32_t duration);
+    static uint32_t getBucketLimit(int32_t bucket);
+    void setStage(FrameRecord *record, int32_t stage, uint64_t begin, uint64_t end);
+    void addRecord(FrameRecord *record);
+
+    volatile bool mEnabled;
+
+    // decoding thread only
+    uint64_t mParseBegin; // first parse since the last surface acquisition
+    uint64_t mParseStart;
+    uint32_t mParseTime; // accumulated until the next surface is acquired
+    uint64_t mAcquireBegin;
+    FrameRecord mFrames[MAX_GRAPHIC_BUFFER_NUM]; // frames in flight, by surface buffer index
+
+    // single writer, lock free readers
+    FrameRecord mRing[RING_SIZE];
+    uint32_t mRingHead; // number of records ever written
+    uint32_t mHistogram[DECODE_STAGE_NUM][HISTOGRAM_SIZE];
+    uint32_t mMax[DECODE_STAGE_NUM];
+    uint32_t mFramesOutput;
+    uint32_t mFramesDropped;
+    uint32_t mNoSurface;
+    uint32_t mReferenceMissing;
+};
+
+#endif /* VIDEO_DECODER_STATS_H_ */
@@ -184,6 +184,11 @@ Decode_Status VideoDecoderWMV::decodeFrame(VideoDecodeBuffer* buffer, vbp_data_v
 #endif
     }
 
+    if (mSyncFrameOnly && data->pic_data[0].pic_parms->picture_fields.bits.picture_type != VC1_PTYPE_I) {
+        // drop the frame before any VA work, second field of an I/P field pair is decoded with its I field
+        return DECODE_SUCCESS;
+    }
+
     status = acquireSurfaceBuffer();
     CHECK_STATUS("acquireSurfaceBuffer");
 
@@ -0,0 +1,124 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VideoSurfacePool.h"
+#include "VideoDecoderTrace.h"
+#include <string.h>
+#include <va/va_android.h>
+
+VideoSurfacePool* VideoSurfacePool::getInstance(void) {
+    // never destroyed, decoders may still be released while the process exits
+    static VideoSurfacePool *sPool = new VideoSurfacePool();
+    return sPool;
+}
+
+VideoSurfacePool::VideoSurfacePool()
+    : mDisplay(0),
+      mVADisplay(NULL),
+      mDisplayUsers(0),
+      mNumIdleSurfaces(0) {
+    pthread_mutex_init(&mLock, NULL);
+}
+
+VADisplay VideoSurfacePool::acquireDisplay(Display display) {
+    pthread_mutex_lock(&mLock);
+    if (mVADisplay == NULL) {
+        mDisplay = display;
+        mVADisplay = vaGetDisplay(&mDisplay);
+        if (mVADisplay == NULL) {
+            ETRACE("vaGetDisplay failed.");
+            pthread_mutex_unlock(&mLock);
+            return NULL;
+        }
+        int majorVersion, minorVersion;
+        VAStatus vaStatus = vaInitialize(mVADisplay, &majorVersion, &minorVersion);
+        if (vaStatus != VA_STATUS_SUCCESS) {
+            ETRACE("vaInitialize failed. vaStatus = %d", vaStatus);
+            mVADisplay = NULL;
+            pthread_mutex_unlock(&mLock);
+            return NULL;
+        }
+    }
+    mDisplayUsers++;
+    VADisplay vaDisplay = mVADisplay;
+    pthread_mutex_unlock(&mLock);
+    return vaDisplay;
+}
+
+void VideoSurfacePool::releaseDisplay(void) {
+    pthread_mutex_lock(&mLock);
+    if (mDisplayUsers > 0) {
+        mDisplayUsers--;
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+int32_t VideoSurfacePool::acquireSurfaces(
+    int32_t format, uint32_t width, uint32_t height, VASurfaceID *surfaces, int32_t count) {
+    int32_t taken = 0;
+    pthread_mutex_lock(&mLock);
+    // take the most recently released surfaces first
+    for (int32_t i = mNumIdleSurfaces - 1; i >= 0 && taken < count; i--) {
+        IdleSurface *idle = mIdleSurfaces + i;
+        if (idle->format != format || idle->width != width || idle->height != height) {
+            continue;
+        }
+        surfaces[taken++] = idle->surface;
+        memmove(idle, idle + 1, (mNumIdleSurfaces - i - 1) * sizeof(IdleSurface));
+        mNumIdleSurfaces--;
+    }
+    pthread_mutex_unlock(&mLock);
+    if (taken) {
+        ITRACE("Reused %d pooled surfaces (%d x %d)", taken, width, height);
+    }
+    return taken;
+}
+
+void VideoSurfacePool::releaseSurfaces(
+    int32_t format, uint32_t width, uint32_t height, VASurfaceID *surfaces, int32_t count) {
+    pthread_mutex_lock(&mLock);
+    for (int32_t i = 0; i < count; i++) {
+        if (surfaces[i] == VA_INVALID_SURFACE) {
+            continue;
+        }
+        if (mNumIdleSurfaces == MAX_IDLE_SURFACES) {
+            // drop the oldest one
+            vaDestroySurfaces(mVADisplay, &(mIdleSurfaces[0].surface), 1);
+            memmove(mIdleSurfaces, mIdleSurfaces + 1, (MAX_IDLE_SURFACES - 1) * sizeof(IdleSurface));
+            mNumIdleSurfaces--;
+        }
+        IdleSurface *idle = mIdleSurfaces + mNumIdleSurfaces;
+        idle->format = format;
+        idle->width = width;
+        idle->height = height;
+        idle->surface = surfaces[i];
+        mNumIdleSurfaces++;
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+void VideoSurfacePool::trim(void) {
+    pthread_mutex_lock(&mLock);
+    if (mDisplayUsers == 0 && mVADisplay != NULL) {
+        for (int32_t i = 0; i < mNumIdleSurfaces; i++) {
+            vaDestroySurfaces(mVADisplay, &(mIdleSurfaces[i].surface), 1);
+        }
+        mNumIdleSurfaces = 0;
+        vaTerminate(mVADisplay);
+        mVADisplay = NULL;
+    }
+    pthread_mutex_unlock(&mLock);
+}
@@ -0,0 +1,68 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef VIDEO_SURFACE_POOL_H_
+#define VIDEO_SURFACE_POOL_H_
+
+#include "VideoDecoderBase.h"
+
+// Process wide pool of VA surfaces allocated by the decoders themselves (surfaces not backed by
+// graphic buffers). Surfaces released by terminateVA are kept, keyed by format and MB aligned
+// size, and handed out again by the next setupVA of any decoder instance. This avoids a full
+// surface reallocation on reset or on a resolution switch back to a known size.
+// Surfaces belong to a VA display, so pooled decoders share one display owned by the pool.
+// Idle surfaces and the display are kept after the last decoder is gone, up to
+// MAX_IDLE_SURFACES surfaces; only trim() (trimVideoDecoderSurfaces) releases them.
+class VideoSurfacePool {
+public:
+    static VideoSurfacePool* getInstance(void);
+
+    // returns the shared display, initializing it on first use
+    VADisplay acquireDisplay(Display display);
+    void releaseDisplay(void);
+
+    // takes up to count idle surfaces of the given format and size, returns the number taken
+    int32_t acquireSurfaces(int32_t format, uint32_t width, uint32_t height, VASurfaceID *surfaces, int32_t count);
+    // returns surfaces to the pool; the oldest idle surfaces are destroyed if the pool is full
+    void releaseSurfaces(int32_t format, uint32_t width, uint32_t height, VASurfaceID *surfaces, int32_t count);
+
+    // destroys all idle surfaces and the display if no decoder is using it. Never called by
+    // the decoders themselves.
+    void trim(void);
+
+private:
+    VideoSurfacePool();
+
+    enum {
+        MAX_IDLE_SURFACES = 64,
+    };
+
+    struct IdleSurface {
+        int32_t format;
+        uint32_t width;
+        uint32_t height;
+        VASurfaceID surface;
+    };
+
+    pthread_mutex_t mLock;
+    Display mDisplay;
+    VADisplay mVADisplay;
+    int32_t mDisplayUsers;
+    IdleSurface mIdleSurfaces[MAX_IDLE_SURFACES];
+    int32_t mNumIdleSurfaces;
+};
+
+#endif /* VIDEO_SURFACE_POOL_H_ */
@@ -0,0 +1,69 @@
+LOCAL_PATH := $(call my-dir)
+
+# dpbindextest: AVC DPB POC index against a scan of the DPB
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    DPBIndexTest.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(TARGET_OUT_HEADERS)/libva \
+    $(TARGET_OUT_HEADERS)/libmixvbp
+
+LOCAL_SHARED_LIBRARIES := \
+    libva_videodecoder \
+    libva
+
+LOCAL_CFLAGS += -Werror
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := dpbindextest
+
+include $(BUILD_EXECUTABLE)
+
+# decodergrouptest: VideoDecoderGroup scheduler with stub decoders
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    DecoderGroupTest.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(TARGET_OUT_HEADERS)/libva \
+    $(TARGET_OUT_HEADERS)/libmixvbp
+
+LOCAL_SHARED_LIBRARIES := \
+    libva_videodecoder \
+    libva
+
+# ThreadSanitizer is only available for 64-bit targets
+ifeq ($(TARGET_IS_64_BIT),true)
+LOCAL_SANITIZE := thread
+endif
+
+LOCAL_CFLAGS += -Werror
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := decodergrouptest
+
+include $(BUILD_EXECUTABLE)
+
+# resynctest: AVC fast resync decisions with synthetic pictures
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    ResyncTest.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(TARGET_OUT_HEADERS)/libva \
+    $(TARGET_OUT_HEADERS)/libmixvbp
+
+LOCAL_SHARED_LIBRARIES := \
+    libva_videodecoder \
+    libva
+
+LOCAL_CFLAGS += -Werror
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := resynctest
+
+include $(BUILD_EXECUTABLE)
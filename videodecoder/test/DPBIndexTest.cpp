@@ -0,0 +1,158 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// Randomized check of the AVC DPB POC index: buildPOCIndex/findDPBIndex
+// against a scan of the DPB for the first and the latest entry holding
+// either field POC of a picture. POCs are drawn from small ranges, so that
+// entries share POCs and hash slots collide, and from the int32 extremes.
+//
+// usage: dpbindextest [iterations] [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "VideoDecoderAVC.h"
+
+class DPBIndexTest {
+public:
+    DPBIndexTest(VideoDecoderAVC *decoder)
+        : mDecoder(decoder),
+          // invalidateDPB in the constructor marks every entry empty
+          mEmptyPOC(decoder->mDPBs[0][0].poc) {
+    }
+
+    bool run(int iterations);
+
+private:
+    int32_t randomPOC();
+    void fillDPB(int toggle);
+    int32_t scanDPB(int toggle, VAPictureH264 *pic, bool latest);
+
+    VideoDecoderAVC *mDecoder;
+    int32_t mEmptyPOC;
+    VideoSurfaceBuffer mSurfaces[VideoDecoderAVC::DPB_SIZE];
+};
+
+int32_t DPBIndexTest::randomPOC() {
+    switch (rand() % 8) {
+    case 0:
+        return mEmptyPOC;
+    case 1:
+        // widely spaced POCs
+        return (rand() % 8) * VideoDecoderAVC::POC_INDEX_SIZE;
+    case 2:
+        return (rand() & 1) ? (int32_t)0x80000000 : mEmptyPOC - 1 - rand() % 4;
+    case 3:
+        return rand() - RAND_MAX / 2;
+    default:
+        return rand() % 24 - 4;
+    }
+}
+
+void DPBIndexTest::fillDPB(int toggle) {
+    for (int i = 0; i < VideoDecoderAVC::DPB_SIZE; i++) {
+        int32_t poc = (rand() % 4 == 0) ? mEmptyPOC : randomPOC();
+        mDecoder->mDPBs[toggle][i].poc = poc;
+        mDecoder->mDPBs[toggle][i].surfaceBuffer = (poc == mEmptyPOC) ? NULL : &mSurfaces[i];
+    }
+    mDecoder->buildPOCIndex(toggle);
+}
+
+// the scan findSurfaceBuffer and findRefSurfaceBuffer did before the index;
+// empty entries hold no surface and are skipped
+int32_t DPBIndexTest::scanDPB(int toggle, VAPictureH264 *pic, bool latest) {
+    int32_t found = -1;
+    for (int32_t i = 0; i < VideoDecoderAVC::DPB_SIZE; i++) {
+        int32_t poc = mDecoder->mDPBs[toggle][i].poc;
+        if (poc == mEmptyPOC) {
+            continue;
+        }
+        if (poc == pic->BottomFieldOrderCnt || poc == pic->TopFieldOrderCnt) {
+            found = i;
+            if (!latest) {
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+bool DPBIndexTest::run(int iterations) {
+    long lookups = 0;
+
+    for (int iter = 0; iter < iterations; iter++) {
+        int toggle = iter & 1;
+        fillDPB(toggle);
+
+        for (int n = 0; n < 64; n++) {
+            VAPictureH264 pic;
+            memset(&pic, 0, sizeof(pic));
+
+            // a POC from the DPB most of the time, field pairs and single fields
+            int32_t taken = mDecoder->mDPBs[toggle][rand() % VideoDecoderAVC::DPB_SIZE].poc;
+            pic.TopFieldOrderCnt = (rand() % 3) ? taken : randomPOC();
+            switch (rand() % 3) {
+            case 0:
+                pic.BottomFieldOrderCnt = pic.TopFieldOrderCnt;
+                break;
+            case 1:
+                pic.BottomFieldOrderCnt = randomPOC();
+                break;
+            default:
+                pic.BottomFieldOrderCnt = mDecoder->mDPBs[toggle][rand() % VideoDecoderAVC::DPB_SIZE].poc;
+                break;
+            }
+            if (rand() & 1) {
+                int32_t poc = pic.TopFieldOrderCnt;
+                pic.TopFieldOrderCnt = pic.BottomFieldOrderCnt;
+                pic.BottomFieldOrderCnt = poc;
+            }
+
+            for (int latest = 0; latest < 2; latest++) {
+                int32_t expected = scanDPB(toggle, &pic, latest);
+                int32_t index = mDecoder->findDPBIndex(toggle, &pic, latest);
+                if (index != expected) {
+                    printf("iter %d: %s entry for POC %d/%d is %d, the scan finds %d\n",
+                        iter, latest ? "latest" : "first",
+                        pic.TopFieldOrderCnt, pic.BottomFieldOrderCnt, index, expected);
+                    return false;
+                }
+                lookups++;
+            }
+        }
+    }
+
+    printf("%ld lookups matched\n", lookups);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int iterations = 20000;
+    unsigned int seed = 1;
+
+    if (argc > 1) iterations = atoi(argv[1]);
+    if (argc > 2) seed = (unsigned int)strtoul(argv[2], NULL, 0);
+    srand(seed);
+
+    VideoDecoderAVC decoder("video/avc");
+    DPBIndexTest test(&decoder);
+    if (!test.run(iterations)) {
+        printf("FAIL (seed %u)\n", seed);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
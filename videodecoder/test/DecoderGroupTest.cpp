@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// VideoDecoderGroup scheduler with stub decoders: 36 decoders on 4 workers, buffers
+// queued from several threads. Each decoder must see its buffers in queue order and
+// never be entered by two workers at once. The stubs keep their state in plain
+// fields, so under ThreadSanitizer (LOCAL_SANITIZE := thread) a missing hand-off
+// between workers is also reported as a race. releaseDecoder and waitIdle called
+// from a done callback must return instead of deadlocking.
+//
+// usage: decodergrouptest [buffers per decoder]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "VideoDecoderGroup.h"
+
+#define NUM_DECODERS 36
+#define NUM_WORKERS 4
+#define NUM_PRODUCERS 3
+
+class StubDecoder : public IVideoDecoder {
+public:
+    StubDecoder()
+        : mNext(0),
+          mDone(0),
+          mErrors(0),
+          mInside(0) {
+    }
+
+    virtual Decode_Status start(VideoConfigBuffer *) { return DECODE_SUCCESS; }
+    virtual Decode_Status reset(VideoConfigBuffer *) { return DECODE_SUCCESS; }
+    virtual void stop(void) {}
+    virtual void flush() {}
+    virtual void freeSurfaceBuffers(void) {}
+    virtual const VideoRenderBuffer* getOutput(bool, VideoErrorBuffer *) { return NULL; }
+    virtual const VideoFormatInfo* getFormatInfo(void) { return NULL; }
+    virtual Decode_Status signalRenderDone(void *, bool) { return DECODE_SUCCESS; }
+    virtual bool checkBufferAvail() { return true; }
+    virtual Decode_Status getRawDataFromSurface(VideoRenderBuffer *, uint8_t *, uint32_t *, bool) { return DECODE_SUCCESS; }
+    virtual void enableErrorReport(bool) {}
+    virtual int getOutputQueueLength(void) { return 0; }
+    virtual void enableStatistics(bool) {}
+    virtual Decode_Status getStatistics(VideoDecoderStatistics *) { return DECODE_SUCCESS; }
+    virtual Decode_Status dumpStatisticsTrace(int) { return DECODE_SUCCESS; }
+
+    virtual Decode_Status decode(VideoDecodeBuffer *buffer) {
+        // atomic, so that a second worker entering is counted rather than reported by TSan
+        if (__sync_fetch_and_add(&mInside, 1) != 0) {
+            __sync_fetch_and_add(&mErrors, 1);
+        }
+        if (buffer->timeStamp != mNext) {
+            __sync_fetch_and_add(&mErrors, 1);
+        }
+        mNext++;
+        // give other workers a chance to pick the same decoder
+        sched_yield();
+        __sync_fetch_and_sub(&mInside, 1);
+        return DECODE_SUCCESS;
+    }
+
+    int64_t mNext; // time stamp of the next buffer, buffers are numbered in queue order
+    int64_t mDone; // done callbacks, in the same order
+    int32_t mErrors;
+    int32_t mInside; // workers in decode()
+};
+
+class StubDecoderGroup : public VideoDecoderGroup {
+protected:
+    virtual IVideoDecoder* newDecoder(const char *) {
+        return new StubDecoder;
+    }
+    virtual void deleteDecoder(IVideoDecoder *decoder) {
+        delete (StubDecoder *)decoder;
+    }
+};
+
+struct Stream {
+    StubDecoderGroup *group;
+    StubDecoder *decoder;
+    VideoDecodeBuffer *buffers;
+    int32_t count;
+    pthread_mutex_t lock; // producers of a stream queue in turn, as a client would
+    int32_t queued;
+};
+
+static Stream gStreams[NUM_DECODERS];
+static int32_t gFailures = 0;
+static int32_t gReentryCalls = 0;
+
+static void decodeDone(void *cookie, IVideoDecoder *decoder, VideoDecodeBuffer *buffer, Decode_Status status) {
+    Stream *stream = (Stream *)cookie;
+    StubDecoder *stub = (StubDecoder *)decoder;
+
+    if (decoder != stream->decoder || status != DECODE_SUCCESS || buffer->timeStamp != stub->mDone) {
+        __sync_fetch_and_add(&gFailures, 1);
+    }
+    stub->mDone++;
+
+    // these would wait for this very worker; they must be rejected
+    if (buffer->timeStamp == 1) {
+        stream->group->waitIdle(decoder);
+        stream->group->releaseDecoder(gStreams[(stream - gStreams + 1) % NUM_DECODERS].decoder);
+        __sync_fetch_and_add(&gReentryCalls, 1);
+    }
+}
+
+static void* producerThread(void *arg) {
+    int32_t index = (int32_t)(intptr_t)arg;
+
+    // every producer visits the streams in a different order
+    for (int32_t round = 0; ; round++) {
+        bool busy = false;
+        for (int32_t i = 0; i < NUM_DECODERS; i++) {
+            Stream *stream = gStreams + (i * (index + 1) + round) % NUM_DECODERS;
+            pthread_mutex_lock(&stream->lock);
+            if (stream->queued < stream->count) {
+                int32_t n = stream->queued++;
+                if (stream->group->queueDecode(stream->decoder, stream->buffers + n, decodeDone, stream) != DECODE_SUCCESS) {
+                    __sync_fetch_and_add(&gFailures, 1);
+                }
+                busy = true;
+            }
+            pthread_mutex_unlock(&stream->lock);
+        }
+        if (!busy) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int32_t count = 200;
+    if (argc > 1) count = atoi(argv[1]);
+    if (count < 2) count = 2;
+
+    StubDecoderGroup group;
+    if (group.start(NUM_WORKERS) != DECODE_SUCCESS) {
+        printf("FAIL: group not started\n");
+        return 1;
+    }
+
+    for (int32_t i = 0; i < NUM_DECODERS; i++) {
+        Stream *stream = gStreams + i;
+        stream->group = &group;
+        stream->decoder = (StubDecoder *)group.createDecoder("video/avc");
+        if (stream->decoder == NULL) {
+            printf("FAIL: decoder %d not created\n", i);
+            return 1;
+        }
+        // streams of different lengths, so that queues drain unevenly
+        stream->count = count + i * 7;
+        stream->buffers = new VideoDecodeBuffer[stream->count];
+        memset(stream->buffers, 0, sizeof(VideoDecodeBuffer) * stream->count);
+        for (int32_t n = 0; n < stream->count; n++) {
+            stream->buffers[n].timeStamp = n;
+        }
+        pthread_mutex_init(&stream->lock, NULL);
+        stream->queued = 0;
+    }
+
+    pthread_t producers[NUM_PRODUCERS];
+    for (int32_t i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_create(&producers[i], NULL, producerThread, (void *)(intptr_t)i);
+    }
+    for (int32_t i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+
+    int32_t failures = 0;
+    for (int32_t i = 0; i < NUM_DECODERS; i++) {
+        Stream *stream = gStreams + i;
+        group.waitIdle(stream->decoder);
+        StubDecoder *stub = stream->decoder;
+        if (stub->mErrors || stub->mNext != stream->count || stub->mDone != stream->count) {
+            printf("decoder %d: %d errors, %lld decoded, %lld done of %d\n", i, stub->mErrors,
+                (long long)stub->mNext, (long long)stub->mDone, stream->count);
+            failures++;
+        }
+    }
+    if (gFailures) {
+        printf("%d done callbacks out of order or for the wrong decoder\n", gFailures);
+        failures++;
+    }
+    if (gReentryCalls != NUM_DECODERS) {
+        printf("%d of %d calls from done callbacks returned\n", gReentryCalls, NUM_DECODERS);
+        failures++;
+    }
+
+    // decoders are released before the group, which would release them with the base class
+    for (int32_t i = 0; i < NUM_DECODERS; i++) {
+        group.releaseDecoder(gStreams[i].decoder);
+        delete [] gStreams[i].buffers;
+        pthread_mutex_destroy(&gStreams[i].lock);
+    }
+
+    if (failures) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
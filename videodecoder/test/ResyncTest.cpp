@@ -0,0 +1,306 @@
+/*
+* Copyright (c) 2009-2011 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// Fast resync (WANT_FAST_RESYNC) of the AVC decoder: skipForResync and
+// isReferenceMissing fed with single slice pictures, as decode() calls them
+// for the first slice of each frame. Decoded reference frames go into a
+// sliding window DPB the way updateDPB would put them; no VA work is done.
+// Scenarios:
+//  - a frame_num gap, then frames dropped up to the next IDR
+//  - a discontinuity, then recovery through a recovery point SEI with
+//    recovery_frame_cnt > 0
+//  - output already queued when HAS_DISCONTINUITY arrives is kept
+//
+// usage: resynctest
+
+#include <stdio.h>
+#include <string.h>
+#include "VideoDecoderAVC.h"
+
+class ResyncTest {
+public:
+    ResyncTest(VideoDecoderAVC *decoder)
+        : mDecoder(decoder),
+          // invalidateDPB in the constructor marks every entry empty
+          mEmptyPOC(decoder->mDPBs[0][0].poc),
+          mNextSurface(0) {
+    }
+
+    bool run();
+
+private:
+    enum {
+        NO_REF = -1,
+        NO_SEI = -1,
+        SLICE_P = 0,
+        SLICE_B = 1,
+        SLICE_I = 2,
+        // DPB window kept by the test, small enough that old frames leave it
+        REF_WINDOW = 4,
+    };
+
+    struct Frame {
+        uint32_t frameNum;
+        int32_t poc;
+        uint8_t sliceType;
+        bool idr;
+        bool reference;
+        int32_t refPOC;            // frame predicted from, NO_REF for intra frames
+        uint32_t flag;             // VideoDecodeBuffer flag
+        int32_t recoveryFrameCnt;  // recovery point SEI ahead of the frame, NO_SEI if none
+        // expected
+        bool skipped;
+        bool shown;
+    };
+
+    void reset();
+    bool decodeFrames(const char *name, const Frame *frames, int count);
+    void updateDPB(const Frame &frame);
+    bool testDropToIDR();
+    bool testRecoveryPoint();
+    bool testDiscontinuityKeepsOutput();
+
+    VideoDecoderAVC *mDecoder;
+    int32_t mEmptyPOC;
+    VAPictureParameterBufferH264 mPicParam;
+    vbp_slice_data_h264 mSlice;
+    vbp_picture_data_h264 mPicData;
+    VideoSurfaceBuffer mSurfaces[REF_WINDOW];
+    int32_t mNextSurface;
+};
+
+void ResyncTest::reset() {
+    // state after start() with WANT_FAST_RESYNC and no frame decoded yet; flush also
+    // empties the DPBs
+    mDecoder->flush();
+    mDecoder->mFastResync = true;
+    mNextSurface = 0;
+}
+
+void ResyncTest::updateDPB(const Frame &frame) {
+    VideoDecoderAVC::DecodedPictureBuffer *dpb = mDecoder->mDPBs[mDecoder->mToggleDPB];
+    if (frame.idr) {
+        for (int i = 0; i < VideoDecoderAVC::DPB_SIZE; i++) {
+            dpb[i].poc = mEmptyPOC;
+            dpb[i].surfaceBuffer = NULL;
+        }
+        mNextSurface = 0;
+    }
+    // entry i of the window holds mSurfaces[i]; the oldest frame is replaced
+    int32_t i = mNextSurface % REF_WINDOW;
+    dpb[i].poc = frame.poc;
+    dpb[i].surfaceBuffer = &mSurfaces[i];
+    mNextSurface++;
+    mDecoder->buildPOCIndex(mDecoder->mToggleDPB);
+}
+
+bool ResyncTest::decodeFrames(const char *name, const Frame *frames, int count) {
+    for (int n = 0; n < count; n++) {
+        const Frame &frame = frames[n];
+
+        memset(&mPicParam, 0, sizeof(mPicParam));
+        // MaxFrameNum is 16
+        mPicParam.seq_fields.bits.log2_max_frame_num_minus4 = 0;
+        mPicParam.frame_num = frame.frameNum;
+        mPicParam.CurrPic.TopFieldOrderCnt = frame.poc;
+        mPicParam.CurrPic.BottomFieldOrderCnt = frame.poc;
+        mPicParam.CurrPic.flags = frame.reference ? VA_PICTURE_H264_SHORT_TERM_REFERENCE : 0;
+        for (int i = 0; i < VideoDecoderAVC::MAX_REF_NUMBER; i++) {
+            mPicParam.ReferenceFrames[i].flags = VA_PICTURE_H264_INVALID;
+        }
+        if (frame.refPOC != NO_REF) {
+            mPicParam.ReferenceFrames[0].flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+            mPicParam.ReferenceFrames[0].TopFieldOrderCnt = frame.refPOC;
+            mPicParam.ReferenceFrames[0].BottomFieldOrderCnt = frame.refPOC;
+        }
+
+        memset(&mSlice, 0, sizeof(mSlice));
+        mSlice.slc_parms.slice_type = frame.sliceType;
+        mPicData.pic_parms = &mPicParam;
+        mPicData.num_slices = 1;
+        mPicData.slc_data = &mSlice;
+        mPicData.idr_flag = frame.idr;
+
+        VideoDecodeBuffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.flag = frame.flag;
+
+        if (frame.recoveryFrameCnt != NO_SEI) {
+            // what decode() records for a recovery point SEI
+            mDecoder->mRecoveryPointPending = true;
+            mDecoder->mRecoveryFrameCnt = frame.recoveryFrameCnt;
+            mDecoder->mRecoveryBrokenLink = false;
+        }
+
+        bool shown = true;
+        bool skipped = mDecoder->skipForResync(&buffer, &mPicData, &shown);
+        if (skipped) {
+            // decode() drops the frame here; no frame is in flight, so there is no VA work
+            if (mDecoder->endDecodingFrame(false) != DECODE_SUCCESS) {
+                printf("%s: frame %d: endDecodingFrame failed\n", name, n);
+                return false;
+            }
+        } else if (frame.reference) {
+            updateDPB(frame);
+        }
+
+        if (skipped != frame.skipped || (!skipped && shown != frame.shown)) {
+            printf("%s: frame %d (frame_num %u, POC %d) is %s, expected %s\n",
+                name, n, frame.frameNum, frame.poc,
+                skipped ? "dropped" : (shown ? "shown" : "decoded, not shown"),
+                frame.skipped ? "dropped" : (frame.shown ? "shown" : "decoded, not shown"));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ResyncTest::testDropToIDR() {
+    static const Frame frames[] = {
+        // frameNum poc  type     idr    ref    refPOC  flag          sei     skipped shown
+        {0,  0,  SLICE_I, true,  true,  NO_REF, 0,            NO_SEI, false, true},
+        {1,  4,  SLICE_P, false, true,  0,      0,            NO_SEI, false, true},
+        {2,  8,  SLICE_P, false, true,  4,      0,            NO_SEI, false, true},
+        // frame_num 3 and 4 are lost
+        {5,  20, SLICE_P, false, true,  16,     0,            NO_SEI, true,  false},
+        {6,  24, SLICE_P, false, true,  20,     0,            NO_SEI, true,  false},
+        {6,  22, SLICE_B, false, false, 20,     0,            NO_SEI, true,  false},
+        // an intra frame that is neither IDR, flagged sync nor a recovery point
+        {7,  28, SLICE_I, false, true,  NO_REF, 0,            NO_SEI, true,  false},
+        {0,  0,  SLICE_I, true,  true,  NO_REF, 0,            NO_SEI, false, true},
+        {1,  4,  SLICE_P, false, true,  0,      0,            NO_SEI, false, true},
+        {2,  2,  SLICE_B, false, false, 0,      0,            NO_SEI, false, true},
+        // no gap, but the reference is not in the DPB
+        {2,  12, SLICE_P, false, true,  40,     0,            NO_SEI, true,  false},
+        {3,  16, SLICE_P, false, true,  12,     0,            NO_SEI, true,  false},
+        // a sync frame ends the drop too
+        {4,  20, SLICE_I, false, true,  NO_REF, IS_SYNC_FRAME, NO_SEI, false, true},
+        {5,  24, SLICE_P, false, true,  20,     0,            NO_SEI, false, true},
+    };
+
+    reset();
+    if (!decodeFrames("drop to IDR", frames, sizeof(frames) / sizeof(frames[0]))) {
+        return false;
+    }
+    if (mDecoder->mResyncState != VideoDecoderAVC::RESYNC_NONE) {
+        printf("drop to IDR: still resyncing at the end\n");
+        return false;
+    }
+    return true;
+}
+
+bool ResyncTest::testRecoveryPoint() {
+    static const Frame frames[] = {
+        // frameNum poc  type     idr    ref    refPOC  flag               sei     skipped shown
+        {0,  0,  SLICE_I, true,  true,  NO_REF, 0,                 NO_SEI, false, true},
+        {1,  4,  SLICE_P, false, true,  0,      0,                 NO_SEI, false, true},
+        {2,  8,  SLICE_P, false, true,  4,      HAS_DISCONTINUITY, NO_SEI, true,  false},
+        {3,  12, SLICE_P, false, true,  8,      0,                 NO_SEI, true,  false},
+        // gradual decoding refresh: frame_num 5 + 3 is the first correct frame
+        {5,  20, SLICE_P, false, true,  16,     0,                 3,      false, false},
+        {5,  18, SLICE_B, false, false, 20,     0,                 NO_SEI, true,  false},
+        {6,  24, SLICE_P, false, true,  20,     0,                 NO_SEI, false, false},
+        {7,  28, SLICE_P, false, true,  24,     0,                 NO_SEI, false, false},
+        {8,  32, SLICE_P, false, true,  28,     0,                 NO_SEI, false, true},
+        // leading frame of the recovery frame
+        {9,  30, SLICE_B, false, false, 28,     0,                 NO_SEI, true,  false},
+        // frames before the recovery frame may stay in the reference list, they are never used
+        {9,  36, SLICE_P, false, true,  12,     0,                 NO_SEI, false, true},
+        {10, 40, SLICE_P, false, true,  36,     0,                 NO_SEI, false, true},
+        {10, 38, SLICE_B, false, false, 36,     0,                 NO_SEI, false, true},
+    };
+
+    reset();
+    if (!decodeFrames("recovery point", frames, sizeof(frames) / sizeof(frames[0]))) {
+        return false;
+    }
+    if (mDecoder->mResyncState != VideoDecoderAVC::RESYNC_NONE) {
+        printf("recovery point: still resyncing at the end\n");
+        return false;
+    }
+    return true;
+}
+
+bool ResyncTest::testDiscontinuityKeepsOutput() {
+    static const Frame decoded[] = {
+        // frameNum poc  type     idr    ref    refPOC  flag  sei     skipped shown
+        {0,  0,  SLICE_I, true,  true,  NO_REF, 0,    NO_SEI, false, true},
+        {1,  4,  SLICE_P, false, true,  0,      0,    NO_SEI, false, true},
+        {2,  8,  SLICE_P, false, true,  4,      0,    NO_SEI, false, true},
+    };
+    static const Frame resync[] = {
+        // frameNum poc  type     idr    ref    refPOC  flag               sei     skipped shown
+        {3,  12, SLICE_P, false, true,  8,      HAS_DISCONTINUITY, NO_SEI, true,  false},
+        {4,  16, SLICE_P, false, true,  12,     0,                 NO_SEI, true,  false},
+        {5,  20, SLICE_I, false, true,  NO_REF, IS_SYNC_FRAME,     NO_SEI, false, true},
+    };
+
+    reset();
+    if (!decodeFrames("discontinuity", decoded, sizeof(decoded) / sizeof(decoded[0]))) {
+        return false;
+    }
+
+    // the three frames wait for output, as outputSurfaceBuffer would leave them
+    VideoSurfaceBuffer queued[3];
+    memset(queued, 0, sizeof(queued));
+    for (int i = 0; i < 3; i++) {
+        queued[i].pictureOrder = decoded[i].poc;
+        queued[i].next = (i < 2) ? &queued[i + 1] : NULL;
+    }
+    mDecoder->mOutputHead = &queued[0];
+    mDecoder->mOutputTail = &queued[2];
+
+    bool ok = decodeFrames("discontinuity", resync, sizeof(resync) / sizeof(resync[0]));
+    if (ok && (mDecoder->mOutputHead != &queued[0] || mDecoder->mOutputTail != &queued[2] ||
+        queued[0].next != &queued[1] || queued[1].next != &queued[2] || queued[2].next != NULL)) {
+        printf("discontinuity: queued output was dropped\n");
+        ok = false;
+    }
+    // the references decoded before the discontinuity are kept too
+    for (int i = 0; ok && i < 3; i++) {
+        VAPictureH264 pic;
+        memset(&pic, 0, sizeof(pic));
+        pic.TopFieldOrderCnt = decoded[i].poc;
+        pic.BottomFieldOrderCnt = decoded[i].poc;
+        if (mDecoder->findDPBIndex(mDecoder->mToggleDPB, &pic, true) < 0) {
+            printf("discontinuity: reference frame %d left the DPB\n", decoded[i].poc);
+            ok = false;
+        }
+    }
+
+    mDecoder->mOutputHead = NULL;
+    mDecoder->mOutputTail = NULL;
+    return ok;
+}
+
+bool ResyncTest::run() {
+    bool ok = testDropToIDR();
+    ok = testRecoveryPoint() && ok;
+    ok = testDiscontinuityKeepsOutput() && ok;
+    reset();
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    VideoDecoderAVC decoder("video/avc");
+    ResyncTest test(&decoder);
+    if (!test.run()) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}